@@ -86,7 +86,7 @@ int main(int argc, char **argv) {
         ("ps, p_start" , "Specify amount of edges before start", cxxopts::value<double>()->default_value("0"))
         ("s,seed", "", cxxopts::value<unsigned>()->default_value("1234"))
         ("qf,query_frequency", "Expected number of queries per update", cxxopts::value<double>()->default_value("0"))
-        ("m,mode", "Choose mode between maxTimeUpdate, correctnessCheck, queryTime or regular", cxxopts::value<std::string>()->default_value("regular"));
+        ("m,mode", "Choose mode between maxTimeUpdate, correctnessCheck, queryTime, memoryUsage, searchStats, rootCache or regular", cxxopts::value<std::string>()->default_value("regular"));
 
     options.parse_positional({"instance", "output"});
     auto arguments = options.parse(argc, argv);
@@ -6,6 +6,8 @@
 #include <ctime>
 #include <random>
 
+#include <sys/resource.h>
+
 #include "io.hpp"
 
 #include "base.hpp"
@@ -120,6 +122,8 @@ std::string runBenchmark(const std::vector<Action> &actions, std::string algo, c
 
     std::shared_ptr<DynConnectivity> connectivity;
 
+    clock_t tConstruction = clock();
+
     if (algo == "DTree"){
         connectivity = std::make_shared<DTree>(G);
     }
@@ -132,6 +136,15 @@ std::string runBenchmark(const std::vector<Action> &actions, std::string algo, c
     else if (algo == "GKKT[lvlHeu]") {
         connectivity = std::make_shared<GKKT>(G, 1, 1, 1, GKKT::Mode::lvlHeu);
     }
+    else if (algo == "GKKT[pHeu,splay]") {
+        connectivity = std::make_shared<GKKT>(G, 1, 1, 1, GKKT::Mode::pHeu, 1, ETBalancing::splay);
+    }
+    else if (algo == "GKKT[lvlHeu,splay]") {
+        connectivity = std::make_shared<GKKT>(G, 1, 1, 1, GKKT::Mode::lvlHeu, 1, ETBalancing::splay);
+    }
+    else if (algo == "GKKT[lvlHeu,avlQuery]") {
+        connectivity = std::make_shared<GKKT>(G, 1, 1, 1, GKKT::Mode::lvlHeu, 1, ETBalancing::avl, QueryForestType::avl);
+    }
     else if (algo == "Wang[base]"){
         connectivity = std::make_shared<Wang>(G, 1, 1);
     }
@@ -141,6 +154,9 @@ std::string runBenchmark(const std::vector<Action> &actions, std::string algo, c
     else if (algo == "Wang[lvlHeu]") {
         connectivity = std::make_shared<Wang>(G, 1, 1, 1, Wang::Mode::lvlHeu);
     }
+    else if (algo == "Wang[lvlHeu,avlQuery]") {
+        connectivity = std::make_shared<Wang>(G, 1, 1, 1, Wang::Mode::lvlHeu, QueryForestType::avl);
+    }
     else if (algo == "Kaibel[base]"){
         connectivity = std::make_shared<Kaibel>(G, 1, 1);
     }
@@ -150,6 +166,9 @@ std::string runBenchmark(const std::vector<Action> &actions, std::string algo, c
     else if (algo == "Kaibel[lvlHeu]") {
         connectivity = std::make_shared<Kaibel>(G, 1, 1, 1, Kaibel::Mode::lvlHeu);
     }
+    else if (algo == "Kaibel[lvlHeu,avlQuery]") {
+        connectivity = std::make_shared<Kaibel>(G, 1, 1, 1, Kaibel::Mode::lvlHeu, QueryForestType::avl);
+    }
     else if (algo == "HDT") {
         connectivity = std::make_shared<HDT>(G);
     }
@@ -159,6 +178,8 @@ std::string runBenchmark(const std::vector<Action> &actions, std::string algo, c
     }
     else throw std::runtime_error("Not a valid algorithm");
 
+    tConstruction = clock() - tConstruction;
+
     if (type == "regular") {
         clock_t runtime = runAllUpdatesTime(actions, connectivity, G);
         return std::to_string(runtime);
@@ -175,10 +196,79 @@ std::string runBenchmark(const std::vector<Action> &actions, std::string algo, c
         clock_t tSum = runQueryTime(actions, connectivity, G);
         return std::to_string(tSum);
     }
+    else if (type == "memoryUsage") {
+        clock_t runtime = runAllUpdatesTime(actions, connectivity, G);
+        return std::to_string(tConstruction) + "," + std::to_string(runtime) + "," + std::to_string(getPeakMemoryKB());
+    }
+    else if (type == "searchStats") {
+        auto gkkt = std::dynamic_pointer_cast<GKKT>(connectivity);
+        if (gkkt == nullptr) throw std::runtime_error("search statistics are only collected for GKKT");
+
+        gkkt->getCutSet().setSearchStatsEnabled(true);
+        clock_t runtime = runAllUpdatesTime(actions, connectivity, G);
+        printSearchStats(gkkt->getCutSet(), std::cout);
+
+        //Totals over all levels and boost lines
+        CutSet::SearchStats total;
+        for (count level = 0; level < gkkt->getCutSet().getNumLevels(); level++) {
+            for (count line = 0; line < gkkt->getCutSet().getBoostLevel(); line++) {
+                CutSet::SearchStats stats = gkkt->getCutSet().getSearchStats(level, line);
+                total.searches += stats.searches;
+                total.empty += stats.empty;
+                total.rejected += stats.rejected;
+                total.successes += stats.successes;
+            }
+        }
+        return std::to_string(runtime) + "," + std::to_string(total.searches) + "," + std::to_string(total.empty) + "," +
+               std::to_string(total.rejected) + "," + std::to_string(total.successes);
+    }
+    else if (type == "rootCache") {
+        auto gkkt = std::dynamic_pointer_cast<GKKT>(connectivity);
+        if (gkkt == nullptr) throw std::runtime_error("the root cache only exists for GKKT");
+
+        gkkt->getCutSet().setRootCacheEnabled(true);
+        clock_t runtime = runAllUpdatesTime(actions, connectivity, G);
+        printRootCacheStats(gkkt->getCutSet(), std::cout);
+
+        //Totals over all levels
+        CutSet::RootCacheStats total;
+        for (count level = 0; level < gkkt->getCutSet().getNumLevels(); level++) {
+            CutSet::RootCacheStats stats = gkkt->getCutSet().getRootCacheStats(level);
+            total.hits += stats.hits;
+            total.misses += stats.misses;
+        }
+        double hitRate = (total.hits + total.misses == 0) ? 0 : double(total.hits) / (total.hits + total.misses);
+        return std::to_string(runtime) + "," + std::to_string(total.hits) + "," + std::to_string(total.misses) + "," + std::to_string(hitRate);
+    }
     else
         throw std::runtime_error("no valid mode selected");
 }
 
+void printSearchStats(const CutSet &cutSet, std::ostream &out) {
+    out << "level,line,searches,empty,rejected,successes\n";
+    for (count level = 0; level < cutSet.getNumLevels(); level++) {
+        for (count line = 0; line < cutSet.getBoostLevel(); line++) {
+            CutSet::SearchStats stats = cutSet.getSearchStats(level, line);
+            out << level << "," << line << "," << stats.searches << "," << stats.empty << "," << stats.rejected << "," << stats.successes << "\n";
+        }
+    }
+}
+
+void printRootCacheStats(const CutSet &cutSet, std::ostream &out) {
+    out << "level,hits,misses,hitRate\n";
+    for (count level = 0; level < cutSet.getNumLevels(); level++) {
+        CutSet::RootCacheStats stats = cutSet.getRootCacheStats(level);
+        double hitRate = (stats.hits + stats.misses == 0) ? 0 : double(stats.hits) / (stats.hits + stats.misses);
+        out << level << "," << stats.hits << "," << stats.misses << "," << hitRate << "\n";
+    }
+}
+
+count getPeakMemoryKB() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
 clock_t runAllUpdatesTime(const std::vector<Action> &actions, std::shared_ptr<DynConnectivity> connectivity, Graph &G) {
     auto t0 = clock();
 
@@ -15,6 +15,7 @@
 #include "base.hpp"
 
 #include "DynConnectivityAlgorithm.hpp"
+#include "CutSet.hpp"
 
 namespace IO {
 using Edge = std::pair<node, node>;
@@ -61,6 +62,26 @@ clock_t runQueryTime(const std::vector<Action> & actions, std::shared_ptr<DynCon
 
 std::pair<std::pair<count, count>, std::pair<count, count>> runAccuracyCheck(const std::vector<Action> & actions, std::shared_ptr<DynConnectivity> connectivity, Graph &G);
 
+/**
+     * Get the peak resident memory of the benchmark process
+     * @return the maximum resident set size in KB
+ */
+count getPeakMemoryKB();
+
+/**
+     * Writes the search statistics of every level and boost line of @cutSet as csv to @out
+     * @param cutSet the cutset, statistics have to be turned on
+     * @param out the stream to write to
+ */
+void printSearchStats(const CutSet &cutSet, std::ostream &out);
+
+/**
+     * Writes the hits, misses and hit rate of the root cache of every level of @cutSet as csv to @out
+     * @param cutSet the cutset, the root cache has to be turned on
+     * @param out the stream to write to
+ */
+void printRootCacheStats(const CutSet &cutSet, std::ostream &out);
+
 /**
      * Reads a graph from a file, lines starting with % or # are ignored otherwise it expects two integers per line denoting the endpoints of an edge
      * @param fname
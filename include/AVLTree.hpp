@@ -93,6 +93,27 @@ public:
      */
     [[nodiscard]] bool empty() const;
 
+    /**
+     * Get the number of key-value-pairs stored
+     * Runs in O(1)
+     * @return the number of key-value-pairs
+     */
+    count size() const;
+
+    /**
+     * Get the number of bytes used by the nodes of the AVL-Tree
+     * Runs in O(1)
+     * @return the number of bytes
+     */
+    count getNumBytes() const {
+        return size() * getNodeBytes();
+    }
+
+    //! Get the number of bytes of a single node
+    static constexpr count getNodeBytes() {
+        return sizeof(Node);
+    }
+
     /**
      * Returns all key-value-pairs in-order
      * Runs in O(n)
@@ -3,6 +3,7 @@
 
 #include <utility>
 #include <cmath>
+#include <vector>
 
 #include "base.hpp"
 
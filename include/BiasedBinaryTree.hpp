@@ -116,6 +116,11 @@ public:
      */
     count getWeightSum() const;
 
+    //! Get the number of bytes of a single node
+    static constexpr count getNodeBytes() {
+        return sizeof(Node);
+    }
+
 protected:
     class Node{
     public:
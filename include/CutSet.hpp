@@ -1,26 +1,67 @@
 #ifndef GKKT_CUTSET_HPP
 #define GKKT_CUTSET_HPP
 
+#include <memory>
+#include <span>
 #include <vector>
 
 #include "base.hpp"
+#include "MemoryUsage.hpp"
+#include "SketchArena.hpp"
 #include "ETForestCutSet.hpp"
 #include "AVLTree.hpp"
 #include "TabularHash.hpp"
+#include "ThreadPool.hpp"
 
 constexpr uint blockSize = 2;
+//! Minimal number of levels a thread handles when per level loops run in parallel, fewer levels stay serial
+constexpr count minLevelsPerThread = 8;
+//! Number of searches finding a nonempty sketch after which a level with adaptive boosting reconsiders its number of boost lines
+constexpr count boostAdaptationWindow = 256;
 
 class CutSet{
 public:
+    //! Counts how searches went on one boost line of one level
+    struct SearchStats{
+        //! Number of searches that looked at the line
+        count searches = 0;
+        //! Searches that found every slot of the line empty
+        count empty = 0;
+        //! Searches whose first nonempty slot held more than one edge
+        count rejected = 0;
+        //! Searches that returned the edge of the line
+        count successes = 0;
+    };
+
+    //! Counts the lookups of tree roots on one level while the root cache is on
+    //! Every compSize, compRepresentative and search (or searchMany) call is one lookup
+    struct RootCacheStats{
+        //! Lookups answered by the cache
+        count hits = 0;
+        //! Lookups that had to walk up to the root, because the tree changed or the vertex wasn't looked up before
+        count misses = 0;
+    };
+
     /**
      * Creates a cutset data structure
+     * Storage for a level is only created once it gets its first tree edge and the sketch of a vertex once it gets its first tree edge on that level
+     * Until then the sketch of a vertex is computed from @pAdjacencyTrees, which therefore must hold exactly the edges added to the sets
      * @param pn the number of nodes
      * @param pBoostLevel boost level, guarantees find has chance at least 1 - (7/8)^boostLevel to succeed
      * @param pNumLevels number of levels
+     * @param pEncoding how edges are stored in the sketches, delta makes updates O(1) per boost line and moves a prefix xor into search
+     * @param numThreads the number of threads used to build the levels and for the per level loops of updates (see setNumThreads)
+     * @param balancing how the ET trees of all levels are kept shallow
      */
-    CutSet(count pn, count pBoostLevel, count pNumLevels, count seed, const std::vector<AVLTree<node, bool>> &pAdjacencyTrees);
+    CutSet(count pn, count pBoostLevel, count pNumLevels, count seed, const std::vector<AVLTree<node, bool>> &pAdjacencyTrees,
+           SketchEncoding pEncoding = SketchEncoding::delta, count numThreads = 1, ETBalancing balancing = ETBalancing::avl);
 
-    ~CutSet();
+    /**
+     * Split the per level loops of updates across @numThreads threads (including the caller)
+     * Updates touching fewer than 2 * minLevelsPerThread levels always run serially
+     * @param numThreads the number of threads, 1 turns parallelism off
+     */
+    void setNumThreads(count numThreads);
 
     /**
      * Adds the edge @e = {v,w} to the sets of v and w on all levels
@@ -28,6 +69,13 @@ public:
      */
     void addEdgeToSet(edge e);
 
+    /**
+     * Adds all edges in @edges to the sets of their endpoints on all levels
+     * Has the same effect as calling addEdgeToSet for every edge, but the ET trees are updated once per level for the whole batch
+     * @param edges the edges
+     */
+    void addEdgesToSet(std::span<const edge> edges);
+
     /**
      * Inserts the edge @e on all levels above @level
      * @param e the edge, which must connect two unconnected components on all levels
@@ -35,6 +83,15 @@ public:
      */
     void makeTreeEdge(edge e, count level);
 
+    /**
+     * Inserts the forest @edges into levels that have no tree edges yet, edge k becomes a tree edge on all levels from @lowestLevels[k] upwards
+     * The ET trees of a level are built bottom-up in one pass, which takes O(n) per level plus building the sketches of the vertices
+     * instead of O(log(n)) splits and joins per edge and level
+     * @param edges the edges of a forest
+     * @param lowestLevels the lowest level of every edge, on every level the edges must connect components of the level below
+     */
+    void buildTreeEdges(std::span<const edge> edges, std::span<const count> lowestLevels);
+
     /**
      * Turns @e into a nontree edge on all levels on which it is a tree edge
      * @param e the edge
@@ -48,14 +105,130 @@ public:
      */
     void deleteEdge(edge e);
 
+    /**
+     * Removes all edges in @edges, has the same effect as calling deleteEdge for every edge
+     * The sketches are updated like in addEdgesToSet
+     * @param edges the edges, no edge may appear twice
+     */
+    void deleteEdges(std::span<const edge> edges);
+
     /**
      * Looks for any edge leaving the tree of @v on level @level
      * If any such edge exists one is returned with probability >= 1/8
      * @param v the node
      * @param level the level on which we are looking
+     * @param record false keeps the search out of the search statistics, adaptive boosting and the root cache and never restructures a tree,
+     * for checks that must not change behaviour
      * @return an edge leaving the tree of @v on level @level with probability 1/8 (if any exists), (0,0) otherwise
      */
-    edge search(node v, count level);
+    edge search(node v, count level, bool record = true);
+
+    /**
+     * Collects up to @k distinct edges leaving the tree of @v on level @level in a single pass over its sketch
+     * Unlike search every slot of every boost line is checked, not only the first nonempty one of each line
+     * @param v the node
+     * @param level the level on which we are looking
+     * @param k the maximal number of edges returned
+     * @return distinct edges leaving the tree of @v on level @level, empty if none were found
+     */
+    std::vector<edge> searchMany(node v, count level, count k);
+
+    /**
+     * Turns the search statistics on or off, turning them on resets all counters
+     * Statistics are off by default and only cover search
+     * @param enabled true to collect statistics
+     */
+    void setSearchStatsEnabled(bool enabled);
+
+    //! Sets all search statistics back to 0
+    void resetSearchStats();
+
+    /**
+     * Get the statistics of boost line @line on level @level (all 0 if statistics are off)
+     * @param level the level
+     * @param line the boost line
+     * @return the statistics
+     */
+    SearchStats getSearchStats(count level, count line) const;
+
+    /**
+     * Turns the root cache on or off, turning it on resets its statistics
+     * The cache remembers the root of the tree of every vertex on every level together with the version of the tree, see ETForestCutSet::getVersion
+     * A link or cut only changes the versions of the trees it touches, so repeated lookups in between (compSize, compRepresentative, search)
+     * take O(1) instead of walking up to the root. The cache is off by default and costs 16 bytes per vertex and level with tree edges
+     * @param enabled true to cache roots
+     */
+    void setRootCacheEnabled(bool enabled);
+
+    /**
+     * Get the statistics of the root cache on @level (all 0 if the cache is off)
+     * @param level the level
+     * @return the statistics
+     */
+    RootCacheStats getRootCacheStats(count level) const;
+
+    /**
+     * Sets the number of boost lines used on @level, the existing sketches of the level are rebuilt from the adjacency trees
+     * Fewer lines make updates on the level cheaper and its sketches smaller, but searches on it fail more often
+     * @param level the level
+     * @param lines the number of boost lines, at most the boost level given at construction
+     */
+    void setLevelBoostLevel(count level, count lines);
+
+    /**
+     * Get the number of boost lines currently used on @level
+     * @param level the level
+     * @return the number of boost lines
+     */
+    count getLevelBoostLevel(count level) const {
+        return levelBoostLevels[level];
+    }
+
+    /**
+     * Lets every level raise or lower its number of boost lines based on how often its searches fail
+     * After boostAdaptationWindow searches that found a nonempty sketch a level gets another line if more than @pTargetFailureRate of them failed,
+     * and drops its last line if less than half of @pTargetFailureRate of them would have failed without it
+     * Levels never go above the boost level given at construction or below the minimal boost level (see setMinBoostLevel)
+     * @param pTargetFailureRate the failure rate the levels aim for, 0 turns adaptation off (the default)
+     */
+    void setAdaptiveBoost(double pTargetFailureRate);
+
+    /**
+     * Sets the number of boost lines adaptive boosting never drops a level below (1 by default)
+     * A user that sized the number of levels for a success probability, like GKKT, passes the boost level it was computed for, so the guarantee
+     * and the projected memory usage stay valid. Levels below @lines are not raised until adaptation reconsiders them
+     * @param lines the number of boost lines, at most the boost level given at construction
+     */
+    void setMinBoostLevel(count lines);
+
+    count getNumLevels() const {
+        return numLevels;
+    }
+
+    //! Get the maximal number of boost lines per level
+    count getBoostLevel() const {
+        return boostLevel;
+    }
+
+    /**
+     * Get the number of bytes currently used by the cutset, split by component
+     * Runs in O(n * numLevels)
+     * @return the memory usage
+     */
+    MemoryUsage memoryUsage() const;
+
+    /**
+     * Get the number of bytes a cutset needs once every level is spanned by a tree
+     * Assumes every vertex sketch is materialized, which is the worst case for a connected graph
+     * Sketches and accumulated sketches count 2 * boostLevel full lines per level. The fingerprint lines hold 64 bit hashes in whole
+     * sketch words, so without PACKED_SKETCHES they take twice the memory the fingerprints need, a quarter of all sketch memory
+     * @param n the number of nodes
+     * @param boostLevel the boost level
+     * @param numLevels the number of levels
+     * @param m the number of edges in the sets
+     * @return the projected memory usage
+     */
+    static MemoryUsage projectMemoryUsage(count n, count boostLevel, count numLevels, count m = 0);
 
     /**
      * Get a representative of the connected component of @v on level @level
@@ -74,30 +247,201 @@ public:
      */
     count compSize(node v, count level);
 
+    /**
+     * Check if @v and @w are in the same component on level @level
+     * Unlike compRepresentative this neither restructures a tree nor touches the root cache, so assertions can use it freely
+     * @return true iff they are connected on @level
+     */
+    bool checkConnected(node v, node w, count level) const;
+
+    /**
+     * Get the size of the component of @v on level @level like compSize, but without restructuring a tree or touching the root cache
+     * @return the size
+     */
+    count checkCompSize(node v, count level) const;
+
 protected:
     count numLevels = 0;
     count boostLevel = 0;
     count n = 0;
     count lognsqr = 0;
+    SketchEncoding encoding = SketchEncoding::delta;
 
     //! Stores the adjacent edges of a node in AVLTrees
     const std::vector<AVLTree<node, bool>> &adjacencyTrees;
 
-    //! Stores the tree edges and the active edge of every node for every level [level][vertex]
+    //! Stores the tree edges and the active edge of every node for every level [level][vertex], empty for levels without tree edges so far
     std::vector<std::vector<AVLTree<node, address>>> treeEdges;
     std::vector<std::vector<address>> activeEdges;
 
+    //! Number of boost lines every level currently uses, at most boostLevel
+    //! Hashes and signatures always cover all boostLevel lines, so lines can be enabled again without rehashing
+    std::vector<count> levelBoostLevels;
+
+    //! Counts the outcome of the searches on a level since it last reconsidered its number of boost lines
+    struct BoostWindow{
+        //! Searches that found a nonempty sketch
+        count searches = 0;
+        //! Searches that found a nonempty sketch but no edge
+        count failures = 0;
+        //! Searches that only found an edge on the last boost line
+        count lastLineSuccesses = 0;
+    };
+    //! Target failure rate of adaptive boosting, 0 if the number of boost lines is fixed
+    double targetFailureRate = 0;
+    //! Adaptive boosting never lowers a level below this many lines
+    count minBoostLevel = 1;
+    std::vector<BoostWindow> boostWindows;
+
     //! The levels of ETTrees
     std::vector<ETForestCutSet> forests;
 
-    //! For every node this stores the xored edge sets with index [level][vertex][boostLine][inBoostLine]
-    std::vector<std::vector<std::vector<std::vector<edge>>>> xOrEdgeVectors;
+    //! For every node this stores the xored edge sets [level][vertex], nullptr for vertices that never had a tree edge on the level
+    //! A sketch on level l has 2 * levelBoostLevels[l] lines, line levelBoostLevels[l] + i holds the xor of the fingerprints of the edges in line i
+    //! Fingerprints are stored as sketch words, so all lines share one layout and xor kernel at the price of 8 unused bytes per fingerprint slot
+    //! unless sketch words are packed
+    std::vector<std::vector<sketchWord*>> sketches;
+    //! For every sketch the lowest starting level of any edge ever added to it [level][vertex], all lines are 0 below it
+    //! Deleting edges never raises it again, so it is only a lower bound that goes stale on vertices that lose their sparse edges
+    //! A stale bound never hides an edge, it only costs the scan of some empty slots
+    std::vector<std::vector<uint8_t>> firstSlots;
+    //! Owns the sketches of every level, one pool per level so that levels can be updated in parallel
+    std::vector<SketchPool> sketchPools;
+    //! Holds sketches of singletons that are computed for a search
+    std::vector<sketchWord> scratchSketch;
 
     //! For every level this stores the necessary hash functions with index [level][boostLine]
     std::vector<std::vector<TabularHash>> hashes;
+    //! Seed of the fingerprints that are stored next to the edges to recognize slots holding a single edge
+    count fingerprintSeed = 0;
+
+    /**
+     * Every edge currently in the sets has a signature holding its starting level for every level and boost line
+     * The starting level of boost line j on level i is at offset i * boostLevel + j, signature k starts at k * numLevels * boostLevel
+     * Signatures are computed when an edge is added and dropped once it is deleted, so deletions need no hashing
+     */
+    std::vector<uint8_t> signatures;
+    //! Indices of signatures that are no longer used
+    std::vector<count> freeSignatures;
+    //! For every edge {v,w} with v < w this stores the index of its signature with key w in the tree of v
+    std::vector<AVLTree<node, count>> signatureIndices;
+
+    //! Search statistics with index level * boostLevel + line, empty if statistics are off
+    std::vector<SearchStats> searchStats;
+
+    //! A cached root, valid as long as it is a root with the same version
+    struct RootCacheEntry{
+        address root = ETForestCutSet::noHandle;
+        count version = 0;
+    };
+    //! Cached roots [level][vertex], empty if the cache is off and empty for a level until its first lookup
+    std::vector<std::vector<RootCacheEntry>> rootCache;
+    //! Root cache statistics per level, empty if the cache is off
+    std::vector<RootCacheStats> rootCacheStats;
+
+    //! Runs the per level loops of updates in parallel, nullptr if everything is serial
+    std::unique_ptr<ThreadPool> threadPool;
 
     //! Gets a new active instance for @v
     void refreshActiveInstance(count level, node v);
+
+    //! Calls @body(i) for every level i in [@begin, @end), in parallel if a thread pool is set and there are enough levels
+    //! Serial loops call @body directly, it is only wrapped into a std::function once it is handed to the pool
+    template<class F>
+    void forEachLevel(count begin, count end, F &&body) {
+        //Every level has its own forest, tree edges, active edges and sketches, so levels can be updated independently
+        if(threadPool != nullptr && end > begin && end - begin >= 2 * minLevelsPerThread) threadPool->parallelFor(begin, end, minLevelsPerThread, body);
+        else for(count i = begin; i < end; i++) body(i);
+    }
+
+    //! Xors @e into the sets of its endpoints on all levels, @e must be ordered
+    void xorEdgeIntoSets(edge e);
+
+    //! Xors all @edges into the sets of their endpoints on all levels, the edges must be ordered
+    void xorEdgesIntoSets(std::span<const edge> edges);
+
+    //! Adds @e to the sets of its endpoints on @level, @startingLevel holds the starting level of every boost line
+    void addEdgeToLevel(edge e, count level, const uint8_t *startingLevel);
+
+    //! Adds all @edges to the sets of their endpoints on @level, @edgeSignatures[k] is the signature of @edges[k]
+    void addEdgesToLevel(std::span<const edge> edges, const std::vector<count> &edgeSignatures, count level);
+
+    //! Writes the starting level of @e for every boost line on @level into @startingLevel
+    void computeStartingLevels(edge e, count level, uint8_t *startingLevel);
+
+    //! Get the index of the signature of @e, computing it if @e has none yet, @e must be ordered
+    count acquireSignature(edge e);
+
+    //! Drops the signature of @e if it has one, @e must be ordered
+    void releaseSignature(edge e);
+
+    //! Get the starting levels of signature @index on @level
+    const uint8_t* getSignature(count index, count level) const {
+        return signatures.data() + (index * numLevels + level) * boostLevel;
+    }
+
+    //! Xors @e and its fingerprint @print into every line of the @level sketch @sketch according to the encoding, @startingLevel holds one starting level per boost line
+    void xorEdgeIntoSketch(count level, sketchWord* sketch, sketchWord e, sketchWord print, const uint8_t *startingLevel);
+
+    //! Records a search on @level that found a nonempty sketch for adaptive boosting, @foundLine is the line that found an edge (the number of lines if none did)
+    void recordBoostOutcome(count level, count foundLine);
+
+    //! Get the fingerprint of @e, a 64 bit hash independent of the level hashes
+    sketchWord fingerprint(edge e) const;
+
+    //! Get the root of the tree of @v on @level or noHandle if @v has no tree edges there, using the root cache if it is on
+    address getTreeRoot(count level, node v);
+
+    //! Like getTreeRoot, but walks up without restructuring the tree or touching the root cache
+    address findTreeRoot(count level, node v) const {
+        return forests[level].findRoot(getActiveEdge(level, v));
+    }
+
+    //! Get a view of the sketch of the whole tree of @v on @level, @root is getTreeRoot(level, v)
+    SketchView getTreeSketch(node v, count level, address root);
+
+    //! Get a slot such that every line of the sketch of the tree of @v on @level is 0 below it, @root is getTreeRoot(level, v)
+    count getTreeFirstSlot(node v, count level, address root);
+
+    //! Get the lowest starting level of the lines used on @level in @startingLevel
+    uint8_t getFirstSlot(count level, const uint8_t *startingLevel) const {
+        uint8_t first = ETForestCutSet::noFirstSlot;
+        for(count j = 0; j < levelBoostLevels[level]; j++) first = std::min(first, startingLevel[j]);
+        return first;
+    }
+
+    //! Inserts the tree edge @e on @level
+    void makeTreeEdgeOnLevel(edge e, count level);
+
+    //! Removes the tree edge @e from @level
+    void makeNonTreeEdgeOnLevel(edge e, count level);
+
+    //! Creates the per vertex storage of @level if it doesn't exist yet
+    void materializeLevel(count level);
+
+    //! Get the sketch of @v on @level, creating it from the adjacent edges of @v if it doesn't exist yet
+    sketchWord* materializeSketch(count level, node v);
+
+    //! Get the sketch of the singleton @v on @level, computed into scratchSketch if @v has no sketch of its own
+    const sketchWord* getSingletonSketch(count level, node v);
+
+    //! Xors all edges adjacent to @v into @sketch as they are stored on @level, returns the lowest starting level of those edges
+    uint8_t buildSketch(count level, node v, sketchWord *sketch);
+
+    //! Get the sketch of @v on @level or nullptr if it wasn't created yet
+    sketchWord* getSketch(count level, node v) {
+        return sketches[level].empty() ? nullptr : sketches[level][v];
+    }
+
+    //! Get the active edge of @v on @level or noHandle if @v has no tree edges there
+    address getActiveEdge(count level, node v) const {
+        return activeEdges[level].empty() ? ETForestCutSet::noHandle : activeEdges[level][v];
+    }
+
+    //! Check if @e is a tree edge on @level
+    bool isTreeEdge(edge e, count level) const {
+        return not treeEdges[level].empty() && treeEdges[level][e.v].contains(e.w);
+    }
 };
 
 #endif //GKKT_CUTSET_HPP
@@ -0,0 +1,184 @@
+#ifndef GKKT_ETFORESTBTREE_HPP
+#define GKKT_ETFORESTBTREE_HPP
+
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+
+/**
+ * This class provides functionality to use EulerTourTrees as described by Henzinger and King 1993
+ * It requires that some algorithm further up keeps track of references to the edges to do proper calls
+ * Unlike the other ET forests the Euler tours are stored in B-trees: up to maxFanout edges share a leaf block and up to maxFanout
+ * blocks share a parent, every block fills exactly one cache line. A tour of 10^6 edges is only about 7 blocks deep, so finding the
+ * root touches a handful of cache lines instead of a binary path of 20 or more nodes. Nothing is tracked apart from subtree sizes
+ */
+class ETForestBTree {
+public:
+    //! Index of an edge of an Euler tour, stays valid until the edge is deleted
+    using Handle = uint32_t;
+    //! Index of a block, the root block identifies a tree until the next link or cut
+    using BlockIndex = uint32_t;
+
+    //! Handle or block index that refers to nothing
+    static constexpr Handle noHandle = std::numeric_limits<Handle>::max();
+
+    //! Largest number of children (edges for leaves) of a block
+    static constexpr count maxFanout = 12;
+    //! Smallest number of children of a block that is not the root
+    static constexpr count minFanout = maxFanout / 2;
+
+    /**
+     * Creates an empty forest
+     * @param n the number of vertices, the 2 * (n - 1) edges of a spanning forest have to be addressable by a Handle
+     * @throws std::length_error if they are not
+     */
+    explicit ETForestBTree(count n = 0);
+
+    /**
+     * Get the root block of the ETTree that @e is part of
+     * @param e an edge
+     * @return the root block of the tree
+     */
+    BlockIndex getRoot(Handle e) const;
+
+    /**
+     * Get the number of edges below the block @b (use the root block to get the size of the entire tree)
+     * @param b the block
+     * @return the number of edges
+     */
+    count getSize(BlockIndex b) const {
+        return blocks[b].size;
+    }
+
+    //! Get the first edge of the Euler tour of the root block @root
+    Handle getFirst(BlockIndex root) const;
+
+    node getV(Handle e) const {
+        return occurrences[e].v;
+    }
+
+    node getW(Handle e) const {
+        return occurrences[e].w;
+    }
+
+    /**
+     * Inserts an edge between node @v and @w
+     * @param v the name of node v
+     * @param w the name of node w
+     * @param vEdge a reference to any edge (v,x) or noHandle
+     * @param wEdge a reference to any edge (w,y) or noHandle
+     * @return references to the two new edges
+     */
+    std::pair<Handle, Handle> insertETEdge(node v, node w, Handle vEdge, Handle wEdge);
+
+    /**
+     * Builds the Euler tours of the whole forest @edges at once with all blocks filled evenly in O(|edges|), the forest must not hold any edges yet
+     * @param edges the edges of a forest
+     * @return references to the edges (v,w) and (w,v) for every edge (v,w) of @edges
+     */
+    std::vector<std::pair<Handle, Handle>> buildForest(std::span<const edge> edges);
+
+    /**
+     * Deletes an ETEdge and its backedge
+     * @param edge a reference to the edge
+     * @param backEdge a reference to the backedge
+     */
+    void deleteETEdge(Handle edge, Handle backEdge);
+
+    /**
+     * Get the euler tour of some edge
+     * @param e any edge in the euler tour
+     * @return the euler tour
+     */
+    std::vector<std::pair<node, node>> getTour(Handle e) const;
+
+    /**
+     * Get the number of bytes used by the edges and blocks of the forest (including ones that are free to be reused)
+     * @return the number of bytes
+     */
+    count getNumBytes() const {
+        return occurrences.capacity() * sizeof(Occurrence) + blocks.capacity() * sizeof(Block);
+    }
+
+    /**
+     * Get the number of bytes a single tree with @numEdges edges uses at most
+     * @param numEdges the number of edges
+     * @return the number of bytes
+     */
+    static count projectNumBytes(count numEdges);
+
+protected:
+    struct Occurrence {
+        uint32_t v = 0, w = 0;
+        //! the leaf block holding the edge, free edges are linked through it
+        BlockIndex leaf = noHandle;
+    };
+
+    //! Every block fills exactly one cache line
+    struct alignas(64) Block {
+        //! the parent block, free blocks are linked through it
+        BlockIndex parent = noHandle;
+        //! the number of edges below the block
+        uint32_t size = 0;
+        //! 0 for leaves, all leaves of a tree have the same depth
+        uint8_t height = 0;
+        //! the number of children
+        uint8_t num = 0;
+        //! blocks for inner blocks, edges for leaves, one spare slot lets a block overflow before it is split
+        uint32_t children[maxFanout + 1];
+    };
+
+    static_assert(sizeof(Block) == 64);
+
+    std::vector<Occurrence> occurrences;
+    std::vector<Block> blocks;
+    Handle firstFreeOccurrence = noHandle;
+    BlockIndex firstFreeBlock = noHandle;
+    //! stores the number of edges of a spanning forest, space for these is reserved with the first edge
+    count maxOccurrences = 0;
+
+    //! Creates the edge (v, w) in a 1-edge tree, throws std::length_error if no Handle is left
+    Handle allocateOccurrence(node v, node w);
+    //! Creates an empty block of @height, throws std::length_error if no BlockIndex is left
+    BlockIndex allocateBlock(uint8_t height);
+    void freeBlock(BlockIndex b);
+
+    //! Recomputes the size of @b and points its children back to it
+    void refresh(BlockIndex b);
+
+    //! Get the position of @child among the children of @parent
+    count indexOf(BlockIndex parent, uint32_t child) const;
+
+    //! Inserts @child as the @index-th child of @parent
+    void insertChild(BlockIndex parent, count index, uint32_t child);
+
+    //! Rotates the Euler tour of @e such that it is now the very first edge within it, returns the new root
+    BlockIndex makeFront(Handle e);
+
+    //! Splits the tree of @e into everything before @e and @e with everything after
+    std::pair<BlockIndex, BlockIndex> split(Handle e);
+
+    //! Concatenates the tours of the roots @left and @right (either may be noHandle), returns the new root
+    BlockIndex join(BlockIndex left, BlockIndex right);
+
+    //! Removes @e from its tree, returns the root of the remaining tree or noHandle if it is empty
+    BlockIndex erase(Handle e);
+
+    //! Turns @num children of height @height - 1 into a tree, returns its root or noHandle if @num is 0
+    BlockIndex makeFragment(const uint32_t *kids, count num, uint8_t height);
+
+    //! Reduces the root @b to a valid root (no inner root with a single child), returns the new root or noHandle if it is empty
+    BlockIndex collapseRoot(BlockIndex b);
+
+    //! Merges the @index-th child of @parent with a sibling or evens out their children, which fixes it being underfull
+    void mergeWithSibling(BlockIndex parent, count index);
+
+    //! Splits overfull and merges underfull blocks from @b upwards and refreshes all ancestors, returns the root
+    BlockIndex fixUpwards(BlockIndex b);
+
+    void checkTreeValidity(BlockIndex root) const;
+};
+
+#endif //GKKT_ETFORESTBTREE_HPP
@@ -1,133 +1,349 @@
 #ifndef GKKT_ETFORESTCUTSET_HPP
 #define GKKT_ETFORESTCUTSET_HPP
 
+#include <bit>
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "base.hpp"
+#include "SketchArena.hpp"
+
+//! How the trees of an ETForestCutSet are kept shallow
+//! avl keeps them balanced, splay moves the nodes touched by links and cuts to the root, which favours update streams that touch
+//! the same vertices over and over. Lookups that walk far up a splay tree splay the node they started from to just below the root,
+//! which keeps them amortized O(log n) while roots stay the same until the next link or cut
+enum class ETBalancing { avl, splay };
 
 /**
  * This class provides functionality to use EulerTourTrees as described by Henzinger and King 1993
  * It requires that some algorithm further up keeps track of references to the edges to do proper calls
  * The specific tracking is currently set to the edge tracking for the cutset data structure used by Kapron, King and Mountjoy
+ * Nodes are stored in one array and refer to each other by 32 bit indices into it, the sketches attached to a node live in
+ * arrays indexed the same way. Walking up to the root only touches the small nodes and never the sketches
  */
 class ETForestCutSet {
 public:
-    class Node {
-    public:
-        struct TrackingData{
-            std::vector<std::vector<edge>> accumulatedData;
-            std::vector<std::vector<edge>> *ownData = nullptr;
-        };
-
-        node getV() {
-            return v;
-        }
+    //! Index of a node (an edge of an Euler tour) in the node array and the sketch arrays, stays valid until the edge is deleted
+    using Handle = uint32_t;
 
-        node getW() {
-            return w;
-        }
+    //! Handle that refers to no node
+    static constexpr Handle noHandle = std::numeric_limits<Handle>::max();
+    //! First slot of a sketch that is entirely 0
+    static constexpr uint8_t noFirstSlot = std::numeric_limits<uint8_t>::max();
 
-        count getSize() {
-            return size;
-        }
+    /**
+     * Creates an empty forest
+     * @param pBoostLevel the number of boost lines of the sketches, the boost level can later only be lowered below this
+     * @param n the number of vertices, the 2 * (n - 1) nodes of a spanning forest have to be addressable by a Handle
+     * @param pNoTracking true if the nodes don't track any sketches
+     * @param pEncoding how edges are placed within the slots of a sketch line
+     * @param pBalancing how the trees are kept shallow
+     * @throws std::length_error if the nodes of a spanning forest are not addressable by a Handle
+     */
+    ETForestCutSet(count pBoostLevel, count n, bool pNoTracking=false, SketchEncoding pEncoding=SketchEncoding::cumulative,
+                   ETBalancing pBalancing=ETBalancing::avl);
 
-    protected:
-        friend class ETForestCutSet;
+    ETForestCutSet(const ETForestCutSet &other) = delete;
+    ETForestCutSet& operator=(const ETForestCutSet &other) = delete;
 
-        Node() = default;
-        Node(node pv, node pw, TrackingData pTrackingData);
+    ETForestCutSet(ETForestCutSet &&other) noexcept = default;
+    ETForestCutSet& operator=(ETForestCutSet &&other) noexcept = default;
 
-        node v = 0, w = 0;
+    /**
+     * Get the root of the ETTree that @e is part of
+     * With splay balancing a long walk restructures the tree below the root, the root itself never changes
+     * @param e an edge
+     * @return the root of the tree
+     */
+    Handle getRoot(Handle e);
 
-        Node* parent = nullptr;
-        Node* leftChild = nullptr;
-        Node* rightChild = nullptr;
+    /**
+     * Get the root of the ETTree that @e is part of without restructuring anything, for checks that must not change the trees
+     * @param e an edge or noHandle
+     * @return the root of the tree
+     */
+    Handle findRoot(Handle e) const;
 
-        count height = 1;
-        count size = 1;
+    /**
+     * Check if @e is the root of its ETTree
+     * @param e an edge
+     * @return true if @e has no parent
+     */
+    bool isRoot(Handle e) const {
+        return at(e).parent == noHandle;
+    }
 
-        TrackingData trackingData;
-    };
+    /**
+     * Turns the versions of the trees on or off, see getVersion
+     * Turning them on gives every tree a new version
+     * @param enabled true to track versions
+     */
+    void setVersioning(bool enabled);
 
-    ETForestCutSet(count pBoostLevel, count n, bool pNoTracking=false);
+    /**
+     * Get the version of the tree with root @root, which changes whenever a link or cut changes the tree
+     * As long as @root is a root with the same version it is the root of the same tree, so roots can be cached by their versions
+     * Versions are never 0 while versioning is on, nodes that are free or not a root may have version 0
+     * @param root the root of a tree
+     * @return the version, 0 if versioning is off
+     */
+    count getVersion(Handle root) const {
+        return versioning ? versions[root] : 0;
+    }
 
     /**
-     * Get the root of the ETTree that @v is part of
-     * @param v a node
-     * @return the root of the tree
+     * Get the number of edges in the subtree of @e (use root to get the size of the entire tree)
+     * @param e the edge
+     * @return the size of the subtree
+     */
+    count getSize(Handle e) const {
+        return at(e).size;
+    }
+
+    node getV(Handle e) const {
+        return at(e).v;
+    }
+
+    node getW(Handle e) const {
+        return at(e).w;
+    }
+
+    /**
+     * Get the first slot in which the accumulated sketch of the subtree of @e may be nonzero (use root for the entire tree)
+     * Outdated accumulated sketches in the subtree of @e are recombined first
+     * @param e the edge
+     * @return the slot, every line of the sketch is 0 in all slots below it
      */
-    Node* getRoot(Node* v) const;
+    uint8_t getFirstSlot(Handle e);
 
     /**
-     * Get the tracking data of @edge (use root to get accumulated data of the entire tree)
-     * @param edge the edge
-     * @return a const reference to the tracking data of the edge
+     * Get a read-only view of the accumulated sketch of the subtree of @e (use root to get the sketch of the entire tree)
+     * Outdated accumulated sketches in the subtree of @e are recombined first
+     * @param e the edge
+     * @return a view of the accumulated sketch, valid until the tree of @e changes
      */
-    const Node::TrackingData &getTrackingData(Node* edge);
+    SketchView getAccumulatedSketch(Handle e);
 
     /**
      * Set new tracking data for @edge
      * @param e the edge
-     * @param newTrackingData the new tracking data
+     * @param trackingDataRef the sketch that is now attached to @e (or nullptr)
+     * @param ownFirstSlot every line of @trackingDataRef is 0 in all slots below this one
      */
-    void setTrackingData(Node* e, std::vector<std::vector<edge>> *trackingDataRef);
+    void setTrackingData(Handle e, const sketchWord *trackingDataRef, count ownFirstSlot = 0);
 
     /**
      * Adds @newEdge to the accumulated edgesets of @e and every ancestor in the ETTree
+     * With delta encoding only the slot startingLevels[i] of every line i is touched
      * @param e reference to the active edge
      * @param newEdge the new edge being inserted
-     * @param startingLevels vector of the levels from which upwards the edge is supposed to be inserted
+     * @param fingerprint the fingerprint of the new edge, it goes into the fingerprint lines
+     * @param startingLevels the levels from which upwards the edge is supposed to be inserted, one per boost line
      */
-    void addEdgeToData(Node* e, edge newEdge, const std::vector<uint8_t> &startingLevels);
+    void addEdgeToData(Handle e, sketchWord newEdge, sketchWord fingerprint, const uint8_t *startingLevels);
+
+    /**
+     * Xors the sketch @deltas[i] into the accumulated edgesets of @nodes[i] and every ancestor in the ETTree
+     * Deltas meeting at a common ancestor are combined first, so every ancestor is only updated once
+     * @param nodes the active edges, no node may appear twice
+     * @param deltas the sketches (2 * boostLevel * lognsqr words each) that are added to the nodes
+     * @param firstSlots every line of @deltas[i] is 0 in all slots below @firstSlots[i]
+     */
+    void addSketchesToData(const std::vector<Handle> &nodes, const std::vector<const sketchWord*> &deltas, const std::vector<uint8_t> &firstSlots);
+
+    /**
+     * Changes the number of boost lines of all sketches in the forest and recomputes every accumulated sketch
+     * @param pBoostLevel the new number of boost lines, at most the boost level the forest was created with
+     * @param activeNodes every node that has tracking data attached
+     * @param ownSketches the new tracking data of @activeNodes[i] (already using @pBoostLevel lines)
+     * @param ownFirstSlots every line of @ownSketches[i] is 0 in all slots below @ownFirstSlots[i]
+     */
+    void setBoostLevel(count pBoostLevel, const std::vector<Handle> &activeNodes, const std::vector<const sketchWord*> &ownSketches,
+                       const std::vector<uint8_t> &ownFirstSlots);
 
     /**
      * Inserts an edge between node @v and @w
      * @param v the name of node v
      * @param w the name of node w
-     * @param vEdge a reference to any edge (v,x)
-     * @param wEdge a reference to any edge (w,y)
-     * @param vwEdgeTrack tracking data that should be attached to the edge (v,w)
-     * @param wvEdgeTrack tracking data that should be attached to the edge (w,v)
+     * @param vEdge a reference to any edge (v,x) or noHandle
+     * @param wEdge a reference to any edge (w,y) or noHandle
      * @return references to the two new edges
      */
-    std::pair<Node*, Node*> insertETEdge(node v, node w, Node* vEdge, Node* wEdge);
+    std::pair<Handle, Handle> insertETEdge(node v, node w, Handle vEdge, Handle wEdge);
+
+    /**
+     * Builds the Euler tours of the whole forest @edges at once as perfectly balanced trees, the forest must not hold any edges yet
+     * Runs in O(|edges|) plus one combination of sketches per node, compared to O(log(n)) splits and joins per edge for insertETEdge
+     * The sketch of a vertex v is attached to (v, w) for the first edge {v, w} of @edges containing it, just like inserting the edges one by
+     * one with insertETEdge and attaching the sketch to the first new edge of v would
+     * @param edges the edges of a forest
+     * @param ownSketches the sketch of every vertex, indexed by vertex (nullptr for none)
+     * @param ownFirstSlots every line of @ownSketches[v] is 0 in all slots below @ownFirstSlots[v]
+     * @return references to the edges (v,w) and (w,v) for every edge (v,w) of @edges
+     */
+    std::vector<std::pair<Handle, Handle>> buildForest(std::span<const edge> edges, const std::vector<sketchWord*> &ownSketches,
+                                                       const std::vector<uint8_t> &ownFirstSlots);
 
     /**
      * Deletes an ETEdge and its backedge
      * @param edge a reference to the edge
      * @param backEdge a reference to the backedge
      */
-    void deleteETEdge(Node* edge, Node*backEdge);
+    void deleteETEdge(Handle edge, Handle backEdge);
 
     /**
      * Get the euler tour of some edge
-     * @param v any edge in the euler tour
+     * @param e any edge in the euler tour
      * @return the euler tour
      */
-    std::vector<std::pair<node, node>> getTour(Node* e);
+    std::vector<std::pair<node, node>> getTour(Handle e) const;
+
+    /**
+     * Get the number of bytes used by the nodes of the forest and their accumulated sketches
+     * This includes nodes and slab slots that are currently unused
+     * @return the number of bytes
+     */
+    count getNumBytes() const {
+        return nodes.capacity() * sizeof(Node) + (ownData.capacity() + accumulatedData.capacity()) * sizeof(sketchWord*)
+               + numSlots * slotSize * sizeof(sketchWord) + versions.capacity() * sizeof(count);
+    }
+
+    /**
+     * Get the number of bytes a forest without versioning uses once it holds @numNodes nodes, including the unused slots of its last chunk
+     * @param numNodes the number of nodes
+     * @param boostLevel the number of boost lines of the sketches
+     * @param lognsqr the number of slots per line
+     * @param noTracking true if the forest does no tracking
+     * @return the number of bytes
+     */
+    static count projectNumBytes(count numNodes, count boostLevel, count lognsqr, bool noTracking);
 
 protected:
+    struct Node {
+        uint32_t v = 0, w = 0;
+
+        Handle parent = noHandle;
+        Handle leftChild = noHandle;
+        Handle rightChild = noHandle;
+
+        uint32_t size = 1;
+        //! only maintained for avl balancing, splay trees can be deeper than 8 bits count
+        uint8_t height = 1;
+
+        //! Every line of the accumulated sketch is 0 in all slots below this one, so only the slots from here on are combined
+        //! Small components rarely have edges with a low starting level, so this skips most of the sparse slots for them
+        uint8_t firstSlot = noFirstSlot;
+        //! Every line of the own sketch is 0 in all slots below this one
+        uint8_t ownFirstSlot = noFirstSlot;
+        //! The subtree changed since its accumulated sketch and firstSlot were combined, they are recombined once they are read
+        //! All ancestors of a dirty node are dirty as well
+        bool dirty = false;
+    };
+
+    static_assert(sizeof(Node) == 28);
+
     //! Stores if complex tracking is done at all
     bool noTracking = true;
     //! stores the boost level of the cutset data structure
     count boostLevel = 0;
     //! stores the logarithm of n
     count lognsqr = 0;
+    //! stores the number of words in one sketch (2 * boostLevel * lognsqr, edges and fingerprints)
+    count sketchSize = 0;
+    //! stores how edges are placed within the slots of a sketch line
+    SketchEncoding encoding = SketchEncoding::cumulative;
+    //! stores how the trees are kept shallow
+    ETBalancing balancing = ETBalancing::avl;
+    //! stores the number of nodes (two per tree edge) in the forest
+    count numNodes = 0;
+
+    std::vector<Node> nodes;
+
+    Node &at(Handle e) {
+        return nodes[e];
+    }
+
+    const Node &at(Handle e) const {
+        return nodes[e];
+    }
+
+    //! stores the first node of a deleted edge, the free nodes are linked through their parent field and reused before the array grows
+    Handle firstFree = noHandle;
+
+    //! Sketches are stored flat with 2 * boostLevel lines of lognsqr slots, slot j of line i is at i * lognsqr + j
+    //! The first boostLevel lines hold edges, line boostLevel + i holds the fingerprints of the edges in line i
+    //! stores the sketch of the vertex every node is the active edge of, owned by the cutset (empty without tracking)
+    std::vector<const sketchWord*> ownData;
+    //! stores the accumulated sketch of the subtree of every node, a slot of the slab that stays with the node when it is reused
+    std::vector<sketchWord*> accumulatedData;
+
+    //! Stores if the versions of the trees are tracked
+    bool versioning = false;
+    //! stores the version of the tree of every root, indexed like the sketch arrays (empty without versioning)
+    std::vector<count> versions;
+    //! stores the last version that was handed out
+    count lastVersion = 0;
+
+    //! Gives the tree of @root a new version if versioning is on, @root may be noHandle
+    void newVersion(Handle root);
+
+    //! Number of slots in the first chunk of the slab
+    static constexpr count minSlotsPerChunk = 16;
+    //! Chunks stop growing once they reach this many bytes
+    static constexpr count maxChunkBytes = count(1) << 18;
+
+    struct ChunkDeleter {
+        count numEntries = 0;
+
+        void operator()(sketchWord *data) const {
+            freeSketchMemory(data, numEntries);
+        }
+    };
+
+    //! stores the number of words reserved for the accumulated sketch of a slot (fixed by the initial boost level)
+    count sketchCapacity = 0;
+    //! stores the number of words of a slot
+    count slotSize = 0;
+    //! stores the number of slots in the last chunk and how many of them were already handed out
+    count chunkCapacity = 0;
+    count usedInChunk = 0;
+    //! stores the number of slots in all chunks
+    count numSlots = 0;
+    //! Every accumulated sketch lives in a slot of this slab, slots are carved from chunks that never move
+    std::vector<std::unique_ptr<sketchWord[], ChunkDeleter>> chunks;
+    //! Scratch space for the dirty nodes recombined by cleanTracking
+    std::vector<Handle> dirtyNodes;
+
+    /**
+     * Get the number of words of a slab slot
+     * @param sketchCapacity the number of words reserved for the accumulated sketch
+     * @return the size of a slot, padded to whole cache lines
+     */
+    static count getSlotSize(count sketchCapacity);
+
+    //! Get the number of slots of the chunk following one with @chunkCapacity slots (0 for the first chunk)
+    static count nextChunkCapacity(count chunkCapacity, count slotSize);
+
+    //! Creates a node (v, w) with a zeroed accumulated sketch as a 1-node tree, throws std::length_error if no Handle is left
+    Handle allocateNode(node v, node w);
+
+    //! Returns @v to the free nodes, its sketch slot stays with it
+    void freeNode(Handle v);
 
     /**
      * Rotates the Euler tout of @newFront such that it is now the very first edge within it
      * @param newFront the edge that is supposed to be the new first edge
      * @return the root of the rotated tree
      */
-    Node* makeFront(Node* newFront);
+    Handle makeFront(Handle newFront);
 
     /**
      * Splits the tree that @v is part off into everything before @v and @v with everything after
      * @param v the node v
      * @return a pair of trees, the first one with every node left of @v, the second with all other nodes
      */
-    std::pair<Node*, Node*> split(Node* v);
+    std::pair<Handle, Handle> split(Handle v);
 
     /**
      * Joins two trees with a join node such that the final in-order is leftTree, joinNode, rightTree
@@ -136,7 +352,7 @@ protected:
      * @param joinTNode the node to join them all
      * @return the root of the final joined tree
      */
-    Node* join(Node* leftTree, Node* rightTree, Node* joinNode);
+    Handle join(Handle leftTree, Handle rightTree, Handle joinNode);
 
     /**
      * Inserts @v into the tree of @root as the first or last element
@@ -145,7 +361,7 @@ protected:
      * @param first denotes if we insert as the first or last element in-order
      * @return
      */
-    Node* trivialInsert(Node* newNode, Node* root, bool first);
+    Handle trivialInsert(Handle newNode, Handle root, bool first);
 
     /**
      * Removes the first ot last node from the tree of @root
@@ -153,40 +369,69 @@ protected:
      * @param first indicates if the first or last element gets removed
      * @return a pair of references (deleted node, root of the remaining tree)
      */
-    std::pair<Node*, Node*> trivialDelete(Node* root, bool first);
+    std::pair<Handle, Handle> trivialDelete(Handle root, bool first);
 
     //! from start going up checks for unbalanced nodes and rotates to rebalance them, returns the root
-    Node* rebalance(Node* start);
+    Handle rebalance(Handle start);
 
     //! Simple single rotation//
-    Node* rotate(Node* head, bool left);
+    Handle rotate(Handle head, bool left);
+
+    //! Moves @v up until its parent is @top, to the root of its splay tree if @top is noHandle
+    void splay(Handle v, Handle top = noHandle);
 
-    //! refresh tracking data for @v and all its ancestors
-    void refreshTrackingDataUpwards(Node* v);
+    //! Splays @v to a child of @root, the root of its tree, after a walk from @v took too long
+    void splayBelowRoot(Handle v, Handle root);
 
-    //! Refreshes height and size of @v, as well as subtree tracking
-    void refreshSubtreeInfo(Node* v);
+    //! Get the number of steps up a splay tree after which the walk pays for splaying its start
+    count maxRootWalk() const {
+        return 2 * std::bit_width(numNodes);
+    }
+
+    //! Marks the tracking data of @v and all its ancestors as outdated
+    void markDirtyUpwards(Handle v);
+
+    //! Recombines the outdated tracking data in the subtree of @v, clean subtrees are skipped
+    void cleanTracking(Handle v);
+
+    //! Refreshes height and size of @v and marks its subtree tracking as outdated
+    void refreshSubtreeInfo(Handle v);
 
     //! refresh the subtree tracking of @v
-    void refreshTracking(Node* v);
+    void refreshTracking(Handle v);
+
+    //! refreshTracking and addEdgeToData for sketches with @FixedBoostLevel boost lines, 0 reads the boost level at runtime
+    template<count FixedBoostLevel>
+    void refreshTrackingLines(Handle v);
+    template<count FixedBoostLevel>
+    void addEdgeToDataLines(Handle e, sketchWord newEdge, sketchWord fingerprint, const uint8_t *startingLevels);
+
+    //! Xors the slots from @firstSlot on of every line of @src into @dst
+    void xorSlotsInto(sketchWord *dst, const sketchWord *src, count firstSlot);
+
+    //! Clears the accumulated sketch of every node in the tree of @root and recomputes it with the current sketch size
+    void rebuildTracking(Handle root);
 
     //! Cleanly separetes the connection to a child
-    Node* separateDirChild(Node* v, bool left);
+    Handle separateDirChild(Handle v, bool left);
+
+    //! Links the @num nodes at @order into a perfectly balanced tree in this order and combines its tracking data, returns the root
+    Handle buildBalanced(const Handle *order, count num);
 
-    //! Returns the height of a subtree or 0 if handed a nullpointer
-    count getHeight(Node* v);
-    //! Returns the size of a subtree or 0 if handed a nullpointer
-    count getSize(Node* v);
+    //! Returns the height of a subtree or 0 if handed noHandle
+    count getHeight(Handle v) const;
+    //! Returns the size of a subtree or 0 if handed noHandle
+    count getSubtreeSize(Handle v) const;
     //! turns this node into a valid 1-node AVL-Tree by removing all references and resetting height, tracking etc.
-    void cleanNode(Node* v);
+    void cleanNode(Handle v);
 
-    void checkTreeValidity(Node* v);
+    //! Checks the subtree of @v in debug mode, splay trees can be deep, so this doesn't recurse
+    void checkTreeValidity(Handle v);
 
     //! Test function that writes the sequence of @root into @path
-    void writeTour(Node* root, std::vector<std::pair<node, node>>* path);
+    void writeTour(Handle root, std::vector<std::pair<node, node>>* path) const;
 };
 
-using address = ETForestCutSet::Node*;
-using TrackingData = ETForestCutSet::Node::TrackingData;
+using address = ETForestCutSet::Handle;
 
 #endif //GKKT_ETFORESTCUTSET_HPP
@@ -2,6 +2,7 @@
 #define GKKT_ETFORESTHDT_HPP
 
 #include <memory>
+#include <span>
 #include <vector>
 
 #include "base.hpp"
@@ -10,70 +11,64 @@
  * This class provides functionality to use EulerTourTrees as described by Henzinger and King 1993
  * It requires that some algorithm further up keeps track of references to the edges to do proper calls
  * The specific tracking is currently set to track edges and tree edges on level as required by Holm, de Lichtenberg and Thorup (1998)
+ * Nodes are stored in one array and refer to each other by 32 bit indices into it. Unlike ETForestCutSet one forest holds the trees
+ * of all levels, so the number of nodes isn't bounded by a spanning forest; allocating more nodes than a Handle can address throws
  */
 class ETForestHDT {
 public:
-    class Node {
-    public:
-        struct TrackingData{
-            bool own_isOnLevel = false;
-            count own_numNonTreeEdgesOnLevel = 0;
-            count accumulated_numTreeEdgesOnLevel = 0;
-            count accumulated_numNonTreeEdgesOnLevel = 0;
-        };
-
-        node getV() {
-            return v;
-        }
-
-        node getW() {
-            return w;
-        }
-
-        count getSize() {
-            return size;
-        }
-
-    protected:
-        friend class ETForestHDT;
-
-        Node() = default;
-        Node(node pv, node pw, TrackingData pTrackingData);
-
-        node v = 0, w = 0;
-
-        Node* parent = nullptr;
-        Node* leftChild = nullptr;
-        Node* rightChild = nullptr;
-
-        count height = 1;
-        count size = 1;
-
-        TrackingData trackingData;
+    //! Index of a node (an edge of an Euler tour) in the node array, stays valid until the edge is deleted
+    using Handle = uint32_t;
+
+    //! Handle that refers to no node
+    static constexpr Handle noHandle = std::numeric_limits<Handle>::max();
+
+    //! The counters only count vertices and edges of a single tree, so 32 bits are plenty
+    struct TrackingData{
+        uint32_t own_numNonTreeEdgesOnLevel = 0;
+        uint32_t accumulated_numTreeEdgesOnLevel = 0;
+        uint32_t accumulated_numNonTreeEdgesOnLevel = 0;
+        bool own_isOnLevel = false;
     };
 
     ETForestHDT() = default;
 
     /**
-     * Get the root of the ETTree that @v is part of
-     * @param v a node
+     * Get the root of the ETTree that @e is part of
+     * @param e an edge
      * @return the root of the tree
      */
-    Node* getRoot(Node* v) const;
+    Handle getRoot(Handle e) const;
+
+    /**
+     * Get the number of edges in the subtree of @e (use root to get the size of the entire tree)
+     * @param e the edge
+     * @return the size of the subtree
+     */
+    count getSize(Handle e) const {
+        return nodes[e].size;
+    }
+
+    node getV(Handle e) const {
+        return nodes[e].v;
+    }
+
+    node getW(Handle e) const {
+        return nodes[e].w;
+    }
 
     /**
      * Get the tracking data of @edge (use root to get accumulated data of the entire tree)
      * @param edge the edge
      * @return a const reference to the tracking data of the edge
      */
-    const Node::TrackingData &getTrackingData(Node* edge);
+    const TrackingData &getTrackingData(Handle edge) const;
 
     /**
      * Set new tracking data for @edge
      * @param e the edge
      * @param onLevel is it supposed to be on level
      */
-    void setEdgeOnLevel(Node* e, bool onLevel);
+    void setEdgeOnLevel(Handle e, bool onLevel);
 
 
     /**
@@ -81,65 +76,104 @@ public:
      * @param e the edge
      * @param nonTreeEdgesOnLevel the number of nonTreeEdges attached to it
      */
-    void setEdgeNontreeEdges(Node* e, count nonTreeEdgesOnLevel);
+    void setEdgeNontreeEdges(Handle e, count nonTreeEdgesOnLevel);
 
     /**
      * Get an on-level tree edge in the tree of @e
      * @param e reference to any edge in the tree to be searched
      * @return Returns any one tree edge on this level, (node, none) if none exists
      */
-    edge getOnLevelTreeEdge(Node* e);
+    edge getOnLevelTreeEdge(Handle e) const;
 
     /**
      * Get a node in the tree of @e that is marked as having nonTreeEdges on level
      * @param e reference to any edge in the tree to be searched
      * @return Returns any one node with nonTreeEdges on level, none if no such node exists
      */
-    node getNodeWithOnLevelNontreeEdge(Node* e);
+    node getNodeWithOnLevelNontreeEdge(Handle e) const;
 
     /**
      * Inserts an edge between node @v and @w
      * @param v the name of node v
      * @param w the name of node w
-     * @param vEdge a reference to any edge (v,x)
-     * @param wEdge a reference to any edge (w,y)
+     * @param vEdge a reference to any edge (v,x) or noHandle
+     * @param wEdge a reference to any edge (w,y) or noHandle
      * @param vOnLevel is edge (v,w) on this level
      * @param wOnLevel is edge (w,v) on this level
      * @param vNonTreeEdgesOnLevel number of nonTreeEdges of v attached to this edge
      * @param wNonTreeEdgesOnLevel number of nonTreeEdges of w attached to this edge
      * @return references to the two new edges
      */
-    std::pair<Node*, Node*> insertETEdge(node v, node w, Node* vEdge, Node* wEdge, bool vOnLevel, bool wOnLevel,
-                                         count vNonTreeEdgesOnLevel, count wNonTreeEdgesOnLevel);
+    std::pair<Handle, Handle> insertETEdge(node v, node w, Handle vEdge, Handle wEdge, bool vOnLevel, bool wOnLevel,
+                                           count vNonTreeEdgesOnLevel, count wNonTreeEdgesOnLevel);
+
+    /**
+     * Builds the Euler tours of the whole forest @edges at once as perfectly balanced trees in O(|edges|), none of the edges may be in
+     * the forest yet. The nonTreeEdges of a vertex v are attached to (v, w) for the first edge {v, w} of @edges containing it, just
+     * like inserting the edges one by one with insertETEdge would attach them to the first new edge of v
+     * @param edges the edges of a forest
+     * @param onLevel are the edges on this level
+     * @param nonTreeEdgesOnLevel the number of nonTreeEdges on this level of every vertex, indexed by vertex
+     * @return references to the edges (v,w) and (w,v) for every edge (v,w) of @edges
+     */
+    std::vector<std::pair<Handle, Handle>> buildForest(std::span<const edge> edges, bool onLevel, const std::vector<count> &nonTreeEdgesOnLevel);
 
     /**
      * Deletes an ETEdge and its backedge
      * @param edge a reference to the edge
      * @param backEdge a reference to the backedge
      */
-    void deleteETEdge(Node* edge, Node*backEdge);
+    void deleteETEdge(Handle edge, Handle backEdge);
 
     /**
      * Get the euler tour of some edge
-     * @param v any edge in the euler tour
+     * @param e any edge in the euler tour
      * @return the euler tour
      */
-    std::vector<std::pair<node, node>> getTour(Node* e);
+    std::vector<std::pair<node, node>> getTour(Handle e) const;
+
+    /**
+     * Get the number of bytes used by the nodes of the forest (including nodes that are free to be reused)
+     * @return the number of bytes
+     */
+    count getNumBytes() const {
+        return nodes.capacity() * sizeof(Node);
+    }
 
 protected:
+    struct Node {
+        uint32_t v = 0, w = 0;
+
+        Handle parent = noHandle;
+        Handle leftChild = noHandle;
+        Handle rightChild = noHandle;
+
+        uint32_t size = 1;
+        uint8_t height = 1;
+
+        TrackingData trackingData;
+    };
+
+    std::vector<Node> nodes;
+    //! stores the first node of a deleted edge, the free nodes are linked through their parent field and reused before the array grows
+    Handle firstFree = noHandle;
+
+    //! Creates the node (v, w) with the given own tracking data as a 1-node tree, throws std::length_error if no Handle is left
+    Handle allocateNode(node v, node w, bool onLevel, count nonTreeEdgesOnLevel);
+
     /**
      * Rotates the Euler tout of @newFront such that it is now the very first edge within it
      * @param newFront the edge that is supposed to be the new first edge
      * @return the root of the rotated tree
      */
-    Node* makeFront(Node* newFront);
+    Handle makeFront(Handle newFront);
 
     /**
      * Splits the tree that @v is part off into everything before @v and @v with everything after
      * @param v the node v
      * @return a pair of trees, the first one with every node left of @v, the second with all other nodes
      */
-    std::pair<Node*, Node*> split(Node* v);
+    std::pair<Handle, Handle> split(Handle v);
 
     /**
      * Joins two trees with a join node such that the final in-order is leftTree, joinNode, rightTree
@@ -148,7 +182,7 @@ protected:
      * @param joinTNode the node to join them all
      * @return the root of the final joined tree
      */
-    Node* join(Node* leftTree, Node* rightTree, Node* joinNode);
+    Handle join(Handle leftTree, Handle rightTree, Handle joinNode);
 
     /**
      * Inserts @v into the tree of @root as the first or last element
@@ -157,7 +191,7 @@ protected:
      * @param first denotes if we insert as the first or last element in-order
      * @return
      */
-    Node* trivialInsert(Node* newNode, Node* root, bool first);
+    Handle trivialInsert(Handle newNode, Handle root, bool first);
 
     /**
      * Removes the first ot last node from the tree of @root
@@ -165,40 +199,43 @@ protected:
      * @param first indicates if the first or last element gets removed
      * @return a pair of references (deleted node, root of the remaining tree)
      */
-    std::pair<Node*, Node*> trivialDelete(Node* root, bool first);
+    std::pair<Handle, Handle> trivialDelete(Handle root, bool first);
 
     //! from start going up checks for unbalanced nodes and rotates to rebalance them, returns the root
-    Node* rebalance(Node* start);
+    Handle rebalance(Handle start);
 
     //! Simple single rotation//
-    Node* rotate(Node* head, bool left);
+    Handle rotate(Handle head, bool left);
 
     //! refresh tracking data for @v and all its ancestors
-    void refreshTrackingDataUpwards(Node* v);
+    void refreshTrackingDataUpwards(Handle v);
 
     //! Refreshes height and size of @v, as well as subtree tracking
-    void refreshSubtreeInfo(Node* v);
+    void refreshSubtreeInfo(Handle v);
 
     //! refresh the subtree tracking of @v
-    void refreshTracking(Node* v);
+    void refreshTracking(Handle v);
 
     //! Cleanly separetes the connection to a child
-    Node* separateDirChild(Node* v, bool left);
+    Handle separateDirChild(Handle v, bool left);
+
+    //! Links the @num nodes at @order into a perfectly balanced tree in this order and sums up their tracking data, returns the root
+    Handle buildBalanced(const Handle *order, count num);
 
-    //! Returns the height of a subtree or 0 if handed a nullpointer
-    count getHeight(Node* v);
-    //! Returns the size of a subtree or 0 if handed a nullpointer
-    count getSize(Node* v);
+    //! Returns the height of a subtree or 0 if handed noHandle
+    count getHeight(Handle v) const;
+    //! Returns the size of a subtree or 0 if handed noHandle
+    count getSubtreeSize(Handle v) const;
     //! turns this node into a valid 1-node AVL-Tree by removing all references and resetting height, tracking etc.
-    void cleanNode(Node* v);
+    void cleanNode(Handle v);
 
-    void checkTreeValidity(Node* v);
+    void checkTreeValidity(Handle v);
 
     //! Test function that writes the sequence of @root into @path
-    void writeTour(Node* root, std::vector<std::pair<node, node>>* path);
+    void writeTour(Handle root, std::vector<std::pair<node, node>>* path) const;
 };
 
-using addressHDT = ETForestHDT::Node*;
-using TrackingDataHDT = ETForestHDT::Node::TrackingData;
+using addressHDT = ETForestHDT::Handle;
+using TrackingDataHDT = ETForestHDT::TrackingData;
 
 #endif //GKKT_ETFORESTHDT_HPP
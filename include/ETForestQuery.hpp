@@ -0,0 +1,175 @@
+#ifndef GKKT_ETFORESTQUERY_HPP
+#define GKKT_ETFORESTQUERY_HPP
+
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "base.hpp"
+
+/**
+ * This class provides functionality to use EulerTourTrees as described by Henzinger and King 1993
+ * It requires that some algorithm further up keeps track of references to the edges to do proper calls
+ * Unlike ETForestCutSet and ETForestHDT nothing is tracked, the nodes only know their subtree size and height. This keeps them small
+ * for forests that only answer connectivity queries. Nodes are stored in one array and refer to each other by 32 bit indices into it,
+ * so links take half the space of pointers
+ */
+class ETForestQuery {
+public:
+    //! Index of a node (an edge of an Euler tour) in the node array, stays valid until the edge is deleted
+    using Handle = uint32_t;
+
+    //! Handle that refers to no node
+    static constexpr Handle noHandle = std::numeric_limits<Handle>::max();
+
+    /**
+     * Creates an empty forest
+     * @param n the number of vertices, the 2 * (n - 1) nodes of a spanning forest have to be addressable by a Handle
+     * @throws std::length_error if they are not
+     */
+    explicit ETForestQuery(count n = 0);
+
+    /**
+     * Get the root of the ETTree that @e is part of
+     * @param e an edge
+     * @return the root of the tree
+     */
+    Handle getRoot(Handle e) const;
+
+    /**
+     * Get the number of edges in the subtree of @e (use root to get the size of the entire tree)
+     * @param e the edge
+     * @return the size of the subtree
+     */
+    count getSize(Handle e) const {
+        return at(e).size;
+    }
+
+    node getV(Handle e) const {
+        return at(e).v;
+    }
+
+    node getW(Handle e) const {
+        return at(e).w;
+    }
+
+    /**
+     * Inserts an edge between node @v and @w
+     * @param v the name of node v
+     * @param w the name of node w
+     * @param vEdge a reference to any edge (v,x) or noHandle
+     * @param wEdge a reference to any edge (w,y) or noHandle
+     * @return references to the two new edges
+     */
+    std::pair<Handle, Handle> insertETEdge(node v, node w, Handle vEdge, Handle wEdge);
+
+    /**
+     * Builds the Euler tours of the whole forest @edges at once as perfectly balanced trees in O(|edges|), the forest must not hold any edges yet
+     * @param edges the edges of a forest
+     * @return references to the edges (v,w) and (w,v) for every edge (v,w) of @edges
+     */
+    std::vector<std::pair<Handle, Handle>> buildForest(std::span<const edge> edges);
+
+    /**
+     * Deletes an ETEdge and its backedge
+     * @param edge a reference to the edge
+     * @param backEdge a reference to the backedge
+     */
+    void deleteETEdge(Handle edge, Handle backEdge);
+
+    /**
+     * Get the euler tour of some edge
+     * @param e any edge in the euler tour
+     * @return the euler tour
+     */
+    std::vector<std::pair<node, node>> getTour(Handle e) const;
+
+    /**
+     * Get the number of bytes used by the nodes of the forest (including nodes that are free to be reused)
+     * @return the number of bytes
+     */
+    count getNumBytes() const {
+        return nodes.capacity() * sizeof(Node);
+    }
+
+    /**
+     * Get the number of bytes a forest with @numNodes nodes uses
+     * @param numNodes the number of nodes
+     * @return the number of bytes
+     */
+    static count projectNumBytes(count numNodes) {
+        return numNodes * sizeof(Node);
+    }
+
+protected:
+    struct Node {
+        uint32_t v = 0, w = 0;
+
+        Handle parent = noHandle;
+        Handle leftChild = noHandle;
+        Handle rightChild = noHandle;
+
+        uint32_t size = 1;
+        uint8_t height = 1;
+    };
+
+    std::vector<Node> nodes;
+
+    Node &at(Handle e) {
+        return nodes[e];
+    }
+
+    const Node &at(Handle e) const {
+        return nodes[e];
+    }
+    //! stores the number of nodes of a spanning forest, space for these is reserved with the first node
+    count maxNodes = 0;
+    //! stores the first node of a deleted edge, the free nodes are linked through their parent field and reused before the array grows
+    Handle firstFree = noHandle;
+
+    //! Creates the node (v, w) as a 1-node tree, throws std::length_error if no Handle is left
+    Handle allocateNode(node v, node w);
+
+    //! Rotates the Euler tour of @newFront such that it is now the very first edge within it, returns the new root
+    Handle makeFront(Handle newFront);
+
+    //! Splits the tree of @v into everything before @v and @v with everything after
+    std::pair<Handle, Handle> split(Handle v);
+
+    //! Joins two trees with a join node such that the final in-order is leftTree, joinNode, rightTree
+    Handle join(Handle leftTree, Handle rightTree, Handle joinNode);
+
+    //! Inserts @newNode into the tree of @root as the first or last element, returns the new root
+    Handle trivialInsert(Handle newNode, Handle root, bool first);
+
+    //! Removes the first or last node from the tree of @root, returns (deleted node, root of the remaining tree)
+    std::pair<Handle, Handle> trivialDelete(Handle root, bool first);
+
+    //! from start going up checks for unbalanced nodes and rotates to rebalance them, returns the root
+    Handle rebalance(Handle start);
+
+    //! Simple single rotation
+    Handle rotate(Handle head, bool left);
+
+    //! Refreshes height and size of @v
+    void refreshSubtreeInfo(Handle v);
+
+    //! Cleanly separetes the connection to a child
+    Handle separateDirChild(Handle v, bool left);
+
+    //! Links the @num nodes at @order into a perfectly balanced tree in this order, returns the root
+    Handle buildBalanced(const Handle *order, count num);
+
+    //! Returns the height of a subtree or 0 if handed noHandle
+    count getHeight(Handle v) const;
+    //! Returns the size of a subtree or 0 if handed noHandle
+    count getSubtreeSize(Handle v) const;
+    //! turns this node into a valid 1-node AVL-Tree by removing all references and resetting height and size
+    void cleanNode(Handle v);
+
+    void checkTreeValidity(Handle v);
+};
+
+using addressQuery = ETForestQuery::Handle;
+
+#endif //GKKT_ETFORESTQUERY_HPP
@@ -0,0 +1,19 @@
+#ifndef GKKT_EULERTOUR_HPP
+#define GKKT_EULERTOUR_HPP
+
+#include <span>
+#include <vector>
+
+#include "base.hpp"
+
+/**
+ * Orders the directed edges of a forest into Euler tours in O(n + |edges|), the ET forests use it to build whole trees bottom-up
+ * Directed edge 2 * k stands for @edges[k] = (v, w) and 2 * k + 1 for its backedge (w, v)
+ * Every tour starts at v for the first edge (v, w) of its tree in @edges
+ * @param edges the edges of a forest
+ * @param tourStarts gets the position of the first directed edge of every tour followed by the total number of directed edges
+ * @return the directed edges of all tours one after the other
+ */
+std::vector<count> eulerTours(std::span<const edge> edges, std::vector<count> &tourStarts);
+
+#endif //GKKT_EULERTOUR_HPP
@@ -1,13 +1,15 @@
 #ifndef GKKT_GKKT_HPP
 #define GKKT_GKKT_HPP
 
+#include <optional>
+
 #include "DynConnectivityAlgorithm.hpp"
 #include "Graph.hpp"
 #include "base.hpp"
 #include "LinkCutTrees.hpp"
+#include "MemoryUsage.hpp"
 #include "CutSet.hpp"
 #include "QueryForest.hpp"
-#include "QueryForestAVL.hpp"
 #include "AVLTree.hpp"
 
 class GKKT : public DynConnectivity {
@@ -17,21 +19,86 @@ public:
      */
     enum Mode { base, pHeu, lvlHeu };
 
+    //! A choice of parameters together with the memory it is projected to need
+    struct Configuration {
+        float c = 0;
+        count boostLevel = 1;
+        count numLevels = 0;
+        MemoryUsage projectedMemory;
+    };
+
     /**
      * Constructs an instance of the algorithm for dynamic connectivity by Gibb, Kapron, King and Thorn with starting grapg @G
      * @param G the starting graph
      * @param c the precision. Queries are wrong with likelihood <= 1/n^c, the runtime is quadratic in c
      * @param seed the seed for the randomized values
+     * @param numThreads the number of threads the per level loops of the cutset are split across
+     * @param balancing how the ET trees of the cutset are kept shallow
+     * @param queryForestType the forest that answers connectivity queries
      */
-    GKKT(Graph &G, float c, uint seed, count boostLevel = 1, Mode mode = base);
+    GKKT(Graph &G, float c, uint seed, count boostLevel = 1, Mode mode = base, count numThreads = 1, ETBalancing balancing = ETBalancing::avl,
+         QueryForestType queryForestType = QueryForestType::btree);
 
     /**
      * Constructs an instance of the algorithm for dynamic connectivity by Gibb, Kapron, King and Thorn on an empty graph with @n vertices
      * @param n the number of vertices in
      * @param c the precision. Queries are wrong with likelihood <= 1/n^c, the runtime is quadratic in c
      * @param seed the seed for the randomized values
+     * @param numThreads the number of threads the per level loops of the cutset are split across
+     * @param balancing how the ET trees of the cutset are kept shallow
+     * @param queryForestType the forest that answers connectivity queries
+     */
+    GKKT(count n, float c, uint seed, count boostLevel = 1, Mode mode = base, count numThreads = 1, ETBalancing balancing = ETBalancing::avl,
+         QueryForestType queryForestType = QueryForestType::btree);
+
+    /**
+     * Constructs an instance on an empty graph with @n vertices using the precision and boost level of @config
+     * @param n the number of vertices, @config should have been chosen for it
+     * @param config the configuration, usually from configureForMemory
+     * @param seed the seed for the randomized values
+     * @param mode the mode @config was chosen for
+     * @param numThreads the number of threads the per level loops of the cutset are split across
+     * @param balancing how the ET trees of the cutset are kept shallow
+     * @param queryForestType the forest that answers connectivity queries, @config should have been chosen for it
+     */
+    GKKT(count n, const Configuration &config, uint seed, Mode mode = base, count numThreads = 1, ETBalancing balancing = ETBalancing::avl,
+         QueryForestType queryForestType = QueryForestType::btree);
+
+    /**
+     * Get the number of levels used for @n vertices with precision @c, boost level @boostLevel and mode @mode
+     * @return the number of levels
+     */
+    static count computeNumLevels(count n, float c, count boostLevel, Mode mode);
+
+    /**
+     * Get the memory an instance with these parameters is projected to need once the graph is connected
+     * The sketches include their fingerprint lines at the full sketch word size, see CutSet::projectMemoryUsage
+     * @param n the number of vertices
+     * @param c the precision
+     * @param boostLevel the boost level
+     * @param mode the mode
+     * @param m the number of edges expected in the graph
+     * @param queryForestType the forest that answers connectivity queries
+     * @return the projected memory usage
      */
-    GKKT(count n, float c, uint seed, count boostLevel = 1, Mode mode = base);
+    static MemoryUsage projectMemoryUsage(count n, float c, count boostLevel, Mode mode, count m = 0,
+                                          QueryForestType queryForestType = QueryForestType::btree);
+
+    /**
+     * Picks the largest configuration whose projected memory fits into @memoryBudget bytes
+     * Precision is favoured over boosting: the result has the largest precision up to @c for which any boost level fits,
+     * and the largest boost level up to @maxBoostLevel for that precision
+     * @param n the number of vertices
+     * @param memoryBudget the number of bytes available
+     * @param mode the mode
+     * @param c the largest precision of interest
+     * @param maxBoostLevel the largest boost level of interest
+     * @param m the number of edges expected in the graph
+     * @param queryForestType the forest that answers connectivity queries
+     * @return the configuration or nothing if not even a single level with one boost line fits
+     */
+    static std::optional<Configuration> configureForMemory(count n, count memoryBudget, Mode mode, float c, count maxBoostLevel, count m = 0,
+                                                           QueryForestType queryForestType = QueryForestType::btree);
 
     /**
      * Queries if node @u and @v are connected in time O(log(n)). Gives false negatives with likelihood at most 1/n^c
@@ -59,16 +126,34 @@ public:
      */
     count numberOfComponents() override;
 
+    /**
+     * Get the cutset, mainly to read its search statistics
+     * @return the cutset
+     */
+    CutSet &getCutSet() {
+        return *cutSet;
+    }
+
+    /**
+     * Get the number of bytes currently used, split by component
+     * Runs in O(n * numLevels)
+     * @return the memory usage
+     */
+    MemoryUsage memoryUsage() const;
+
 protected:
     static constexpr double precision = 1.0/8;
 
+    //! Get the chance that a search on a level with @boostLevel boost lines succeeds as assumed by @mode
+    static double successProbability(count boostLevel, Mode mode);
+
     count n = 0;
     float c = 0;
     count numLevels = 0, boostLevel = 1;
     double p = 0;
 
     std::vector<AVLTree<node, bool>> adjacencyTrees;
-    std::unique_ptr<QueryForestAVL> queryForest;
+    std::unique_ptr<QueryForest> queryForest;
     std::unique_ptr<CutSet> cutSet;
     std::unique_ptr<LinkCutTrees> linkCutTrees;
 
@@ -77,6 +162,9 @@ protected:
     //! Checks if on @level the tree of @v has an edge leaving it and if so inserts the edge for all levels > @level
     void searchAndInsert(node v, count level);
 
+    //! Adds all edges of @G at once, the ET trees of every level are built bottom-up from a spanning forest instead of edge by edge
+    void build(const Graph &G);
+
 
     //! Sanity check if everything is fine
     void sanityCheck();
@@ -23,6 +23,12 @@ public:
 
     count getM() const;
 
+    /**
+     * Computes a spanning forest by breadth first search in O(n + m)
+     * @return the edges of the forest
+     */
+    std::vector<edge> spanningForest() const;
+
 protected:
     count n = 0, m = 0;
 
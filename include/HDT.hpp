@@ -70,6 +70,9 @@ protected:
     void deleteNonTreeEdge(node u, node v, count level);
 
     void refreshActiveEdge(node v, count level);
+
+    //! Adds all edges of @G at once, the ET trees of a spanning forest are built bottom-up instead of edge by edge
+    void build(const Graph &G);
 };
 
 #endif //GKKT_HDT_HPP
@@ -93,6 +93,22 @@ public:
      */
     void update(node v, diff x);
 
+    /**
+     * Get an upper bound on the number of bytes used, the biased trees are not walked
+     * @return the number of bytes
+     */
+    count getNumBytes() const {
+        return projectNumBytes(n);
+    }
+
+    /**
+     * Get an upper bound on the number of bytes used by link cut trees on @n nodes
+     * Every node has a leaf in the path trees, paths add at most n - 1 inner nodes and light edges at most n - 1 heap entries
+     * @param n the number of nodes
+     * @return the number of bytes
+     */
+    static count projectNumBytes(count n);
+
 protected:
     //! number of nodes
     count n;
@@ -0,0 +1,39 @@
+#ifndef GKKT_MEMORYUSAGE_HPP
+#define GKKT_MEMORYUSAGE_HPP
+
+#include "base.hpp"
+
+/**
+ * Bytes used by the parts of a dynamic connectivity data structure
+ * Only the storage of the data structures is counted, allocator overhead is not
+ */
+struct MemoryUsage {
+    //! Xor sketches of single vertices
+    count sketches = 0;
+    //! Nodes of Euler tour trees, including the accumulated sketches they own
+    count etNodes = 0;
+    //! Nodes of AVL trees (adjacency lists, tree edge sets and signature indices)
+    count avlNodes = 0;
+    //! Link cut trees
+    count linkCutTrees = 0;
+    //! Hash tables and the cached hash signatures of the edges
+    count hashes = 0;
+    //! Per vertex and per level arrays
+    count other = 0;
+
+    count total() const {
+        return sketches + etNodes + avlNodes + linkCutTrees + hashes + other;
+    }
+
+    MemoryUsage& operator+=(const MemoryUsage &m) {
+        sketches += m.sketches;
+        etNodes += m.etNodes;
+        avlNodes += m.avlNodes;
+        linkCutTrees += m.linkCutTrees;
+        hashes += m.hashes;
+        other += m.other;
+        return *this;
+    }
+};
+
+#endif //GKKT_MEMORYUSAGE_HPP
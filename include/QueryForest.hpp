@@ -1,13 +1,24 @@
 #ifndef GKKT_QUERYFOREST_HPP
 #define GKKT_QUERYFOREST_HPP
 
+#include <memory>
+#include <span>
+
 #include "base.hpp"
+#include "MemoryUsage.hpp"
+
+//! Which forest answers the connectivity queries of an algorithm
+//! avl stores the Euler tours in AVL trees (QueryForestAVL), btree in cache line sized B-tree blocks (QueryForestBTree), which finds roots
+//! in fewer cache misses on large trees
+enum class QueryForestType { avl, btree };
 
 /**
  * Template for classes that provide connectivity queries on dynamic forests
  */
 class QueryForest {
 public:
+    virtual ~QueryForest() = default;
+
     virtual bool query(node u, node v) const = 0;
 
     virtual count compSize(node v) const = 0;
@@ -20,7 +31,27 @@ public:
 
     virtual void addEdge(node u, node v) = 0;
 
+    virtual void addForest(std::span<const edge> edges) = 0;
+
     virtual void deleteEdge(node u, node v) = 0;
+
+    virtual MemoryUsage memoryUsage() const = 0;
+
+    /**
+     * Creates an empty forest on @n nodes
+     * @param type the kind of forest
+     * @param n the number of nodes
+     * @return the forest
+     */
+    static std::unique_ptr<QueryForest> create(QueryForestType type, count n);
+
+    /**
+     * Get the number of bytes a forest of kind @type needs once it is a spanning tree on @n nodes
+     * @param type the kind of forest
+     * @param n the number of nodes
+     * @return the projected memory usage
+     */
+    static MemoryUsage projectMemoryUsage(QueryForestType type, count n);
 };
 
 #endif //GKKT_QUERYFOREST_HPP
@@ -1,12 +1,14 @@
 #ifndef GKKT_QUERYFORESTAVL_HPP
 #define GKKT_QUERYFORESTAVL_HPP
 
+#include <span>
 #include <vector>
 
 #include "base.hpp"
+#include "MemoryUsage.hpp"
 #include "QueryForest.hpp"
 #include "AVLTree.hpp"
-#include "ETForestCutSet.hpp"
+#include "ETForestQuery.hpp"
 
 class QueryForestAVL : public QueryForest {
 public:
@@ -55,6 +57,13 @@ public:
      */
     void addEdge(node u, node v) override;
 
+    /**
+     * Adds all edges of the forest @edges at once, the forest must not have any edges yet
+     * The Euler tours are built bottom-up in O(|edges|) instead of inserting the edges one by one
+     * @param edges the edges of a forest
+     */
+    void addForest(std::span<const edge> edges) override;
+
     /**
      * Removes the edge {u,v} from the forest
      * @param u node u
@@ -62,13 +71,26 @@ public:
      */
     void deleteEdge(node u, node v) override;
 
+    /**
+     * Get the number of bytes currently used by the forest, split by component
+     * @return the memory usage
+     */
+    MemoryUsage memoryUsage() const override;
+
+    /**
+     * Get the number of bytes the forest needs once it is a spanning tree on @n nodes
+     * @param n the number of nodes
+     * @return the projected memory usage
+     */
+    static MemoryUsage projectMemoryUsage(count n);
+
 protected:
     count n;
     count numConnectedComponents;
 
-    std::vector<AVLTree<node, address>> treeEdges;
+    std::vector<AVLTree<node, addressQuery>> treeEdges;
 
-    ETForestCutSet forest;
+    ETForestQuery forest;
 };
 
 #endif //GKKT_QUERYFORESTAVL_HPP
@@ -0,0 +1,96 @@
+#ifndef GKKT_QUERYFORESTBTREE_HPP
+#define GKKT_QUERYFORESTBTREE_HPP
+
+#include <span>
+#include <vector>
+
+#include "base.hpp"
+#include "MemoryUsage.hpp"
+#include "QueryForest.hpp"
+#include "AVLTree.hpp"
+#include "ETForestBTree.hpp"
+
+class QueryForestBTree : public QueryForest {
+public:
+    QueryForestBTree(count n);
+
+    /**
+     * Queries if @u and @v are connected in the forest in O(log(n))
+     * @param u node u
+     * @param v node v
+     * @return true iff u and v are connected in the forest
+     */
+    bool query(node u, node v) const override;
+
+    /**
+     * Find the size of the tree containing @v
+     * @param v the node
+     * @return the size of the tree containing @v
+     */
+    count compSize(node v) const override;
+
+    /**
+     * Find a representative of the tree of @v. So long as no edges change the representative is the same for all nodes in the tree
+     * @param v the node
+     * @return a node in the tree of @v representing it
+     */
+    count compRepresentative(node v) const override;
+
+    /**
+     * Get the number of connected components
+     * @return the number of connected components
+     */
+    count numberOfComponents() const override;
+
+    /**
+     * Check if the edge {u, v} is a tree edge
+     * @param u
+     * @param v
+     * @return true iff {u, v} is a tree edge
+     */
+    bool isTreeEdge(node u, node v) const override;
+
+    /**
+     * Adds edge {@u,@v} to the forest (the two must not have been connected before)
+     * @param u node u
+     * @param v node v
+     */
+    void addEdge(node u, node v) override;
+
+    /**
+     * Adds all edges of the forest @edges at once, the forest must not have any edges yet
+     * The Euler tours are built bottom-up in O(|edges|) instead of inserting the edges one by one
+     * @param edges the edges of a forest
+     */
+    void addForest(std::span<const edge> edges) override;
+
+    /**
+     * Removes the edge {u,v} from the forest
+     * @param u node u
+     * @param v node v
+     */
+    void deleteEdge(node u, node v) override;
+
+    /**
+     * Get the number of bytes currently used by the forest, split by component
+     * @return the memory usage
+     */
+    MemoryUsage memoryUsage() const override;
+
+    /**
+     * Get the number of bytes the forest needs once it is a spanning tree on @n nodes
+     * @param n the number of nodes
+     * @return the projected memory usage
+     */
+    static MemoryUsage projectMemoryUsage(count n);
+
+protected:
+    count n;
+    count numConnectedComponents;
+
+    std::vector<AVLTree<node, ETForestBTree::Handle>> treeEdges;
+
+    ETForestBTree forest;
+};
+
+#endif //GKKT_QUERYFORESTBTREE_HPP
@@ -0,0 +1,188 @@
+#ifndef GKKT_SKETCHARENA_HPP
+#define GKKT_SKETCHARENA_HPP
+
+#include <vector>
+
+#include "base.hpp"
+#include "SketchWord.hpp"
+
+//! Size of a cache line in bytes, every sketch starts at a multiple of this
+constexpr count cacheLineSize = 64;
+//! Allocations of at least this many bytes are mapped directly from the OS, whose fresh pages are already zero
+constexpr count zeroPageThreshold = count(1) << 20;
+
+/**
+ * How edges are stored in the slots of a sketch line. An edge hashed to starting level s is stored
+ * cumulative: in every slot k >= s, so slot k directly holds the xor of all edges with starting level <= k
+ * delta: only in slot s, the cumulative value of slot k is the xor of slots 0 to k
+ * Both encodings are linear, so sketches of either kind can be xored together as usual
+ */
+enum class SketchEncoding { cumulative, delta };
+
+/**
+ * Allocates @numEntries zeroed sketch words aligned to a cache line
+ * Large allocations come as anonymous pages from the OS, which are zero without being written and only use memory once touched
+ * @param numEntries the number of sketch words
+ * @return pointer to the first word, nullptr if @numEntries is 0
+ */
+sketchWord* allocateSketchMemory(count numEntries);
+
+/**
+ * Frees memory obtained from allocateSketchMemory
+ * @param data the pointer returned by allocateSketchMemory (may be nullptr)
+ * @param numEntries the number of sketch words that were allocated
+ */
+void freeSketchMemory(sketchWord* data, count numEntries);
+
+/**
+ * Read-only view of a single sketch that is stored elsewhere (in a SketchArena or an ETForestCutSet node)
+ * The view does not own any memory and never copies the sketch
+ */
+class SketchView {
+public:
+    SketchView(const sketchWord* pData, count pLognsqr) : data(pData), lognsqr(pLognsqr) {}
+
+    /**
+     * Get slot @slot of line @line of the viewed sketch
+     * @param line the boost line
+     * @param slot the slot within the line
+     * @return a const reference to the slot
+     */
+    const sketchWord& operator()(count line, count slot) const {
+        return data[line * lognsqr + slot];
+    }
+
+    /**
+     * Get the first slot of line @line
+     * @param line the boost line
+     * @return pointer to the first slot of the line
+     */
+    const sketchWord* getLine(count line) const {
+        return data + line * lognsqr;
+    }
+
+protected:
+    const sketchWord* data;
+    count lognsqr;
+};
+
+/**
+ * This class stores many xor sketches of the cutset data structure in a single contiguous block of memory
+ * A sketch consists of boostLevel lines with lognsqr slots each, slot j of line i is stored at offset i * lognsqr + j
+ * Every sketch starts on its own cache line
+ */
+class SketchArena {
+public:
+    SketchArena() = default;
+
+    /**
+     * Creates an arena of @pNumSketches zeroed sketches
+     * @param pNumSketches the number of sketches
+     * @param pBoostLevel the number of lines per sketch
+     * @param pLognsqr the number of slots per line
+     */
+    SketchArena(count pNumSketches, count pBoostLevel, count pLognsqr);
+
+    SketchArena(const SketchArena &other) = delete;
+    SketchArena& operator=(const SketchArena &other) = delete;
+
+    SketchArena(SketchArena &&other) noexcept;
+    SketchArena& operator=(SketchArena &&other) noexcept;
+
+    ~SketchArena();
+
+    /**
+     * Get the sketch with index @index
+     * @param index the index of the sketch
+     * @return pointer to the first slot of the sketch
+     */
+    sketchWord* getSketch(count index) {
+        return data + index * stride;
+    }
+
+    const sketchWord* getSketch(count index) const {
+        return data + index * stride;
+    }
+
+    /**
+     * Get the number of sketch words between the starts of two consecutive sketches
+     * @return the stride
+     */
+    count getStride() const {
+        return stride;
+    }
+
+    /**
+     * Get the number of bytes allocated for the sketches
+     * @return the number of bytes
+     */
+    count getNumBytes() const {
+        return numSketches * stride * sizeof(sketchWord);
+    }
+
+    /**
+     * Get the number of sketch words that have to be reserved per sketch such that every sketch starts on a cache line
+     * @param boostLevel the number of lines per sketch
+     * @param lognsqr the number of slots per line
+     * @return the padded size of a sketch
+     */
+    static count sketchStride(count boostLevel, count lognsqr);
+
+protected:
+    count numSketches = 0;
+    count stride = 0;
+
+    sketchWord* data = nullptr;
+};
+
+/**
+ * Hands out zeroed sketches one at a time, for sketches that are only created when they are first needed
+ * Sketches are carved from SketchArenas that never move, so their addresses never change
+ * Every arena is twice as large as the one before (up to a limit), so large pools are backed by few zero page mappings
+ */
+class SketchPool {
+public:
+    SketchPool() = default;
+
+    /**
+     * Creates an empty pool, no memory is allocated until the first sketch is requested
+     * @param pBoostLevel the number of lines per sketch
+     * @param pLognsqr the number of slots per line
+     */
+    SketchPool(count pBoostLevel, count pLognsqr) : boostLevel(pBoostLevel), lognsqr(pLognsqr) {}
+
+    /**
+     * Get a new zeroed sketch that stays valid as long as the pool exists
+     * @return pointer to the first slot of the sketch
+     */
+    sketchWord* allocate();
+
+    /**
+     * Get the number of bytes allocated for the sketches (including sketches that weren't handed out yet)
+     * @return the number of bytes
+     */
+    count getNumBytes() const;
+
+    /**
+     * Get the number of sketches a pool has allocated once @numSketches sketches were handed out
+     * @param numSketches the number of sketches handed out
+     * @return the number of sketches allocated
+     */
+    static count projectNumSketches(count numSketches);
+
+protected:
+    //! Number of sketches in the first arena of the pool
+    static constexpr count minSketchesPerBlock = 64;
+    //! Largest number of sketches in one arena
+    static constexpr count maxSketchesPerBlock = count(1) << 16;
+
+    count boostLevel = 0;
+    count lognsqr = 0;
+    //! Number of sketches in the last arena and how many of them were already handed out
+    count blockCapacity = 0;
+    count usedInBlock = 0;
+
+    std::vector<SketchArena> blocks;
+};
+
+#endif //GKKT_SKETCHARENA_HPP
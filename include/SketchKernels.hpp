@@ -0,0 +1,52 @@
+#ifndef GKKT_SKETCHKERNELS_HPP
+#define GKKT_SKETCHKERNELS_HPP
+
+#include "base.hpp"
+#include "SketchWord.hpp"
+
+/**
+ * Vectorized kernels for the xor operations on sketches of the cutset data structure
+ * The instruction set is picked at program start (AVX2 if the cpu supports it, SSE2 otherwise on x86-64, scalar elsewhere)
+ */
+enum class SketchISA { scalar, sse2, avx2 };
+
+/**
+ * Get the instruction set currently used by the sketch kernels
+ * @return the instruction set
+ */
+SketchISA getSketchISA();
+
+/**
+ * Force the sketch kernels to use @isa, mainly used to test and compare the implementations
+ * @param isa the instruction set
+ * @return true iff @isa is supported by this build and cpu (otherwise nothing changes)
+ */
+bool setSketchISA(SketchISA isa);
+
+/**
+ * Xors @e into every one of the @length slots starting at @data
+ * @param data the first slot
+ * @param e the sketch word
+ * @param length the number of slots
+ */
+void xorEdgeIntoRange(sketchWord* data, sketchWord e, count length);
+
+/**
+ * Xors the @length slots starting at @src into the ones starting at @dst
+ * @param dst the first target slot
+ * @param src the first source slot
+ * @param length the number of slots
+ */
+void xorSketchInto(sketchWord* dst, const sketchWord* src, count length);
+
+/**
+ * Sets @dst to the xor of @own, @left and @right, each of which may be nullptr to stand for an empty sketch
+ * @param dst the target sketch
+ * @param own the first source sketch
+ * @param left the second source sketch
+ * @param right the third source sketch
+ * @param length the number of slots
+ */
+void combineSketches(sketchWord* dst, const sketchWord* own, const sketchWord* left, const sketchWord* right, count length);
+
+#endif //GKKT_SKETCHKERNELS_HPP
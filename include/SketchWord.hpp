@@ -0,0 +1,56 @@
+#ifndef GKKT_SKETCHWORD_HPP
+#define GKKT_SKETCHWORD_HPP
+
+#include "base.hpp"
+
+/**
+ * The type of a single slot of an xor sketch
+ * By default a slot is a full edge (two 64 bit endpoints). Building with GKKT_PACKED_SKETCHES (cmake option PACKED_SKETCHES)
+ * stores both endpoints in one 64 bit word instead, which halves the memory of all sketches but limits n to 2^32
+ * Sketches are only converted back to edges when a candidate is read from them
+ */
+#ifdef GKKT_PACKED_SKETCHES
+struct sketchWord {
+    uint64_t bits = 0;
+
+    constexpr sketchWord& operator^=(const sketchWord& s){
+        bits ^= s.bits;
+        return *this;
+    }
+};
+
+constexpr sketchWord operator^(sketchWord s1, const sketchWord& s2){
+    return s1 ^= s2;
+}
+
+constexpr bool operator==(const sketchWord& s1, const sketchWord& s2){
+    return s1.bits == s2.bits;
+}
+
+//! Largest number of nodes whose edges fit into a sketch word
+constexpr count maxSketchNodes = count(1) << 32;
+
+constexpr sketchWord toSketchWord(edge e){
+    return {(e.v & 0xffffffffu) | (e.w << 32)};
+}
+
+constexpr edge toEdge(sketchWord s){
+    return {s.bits & 0xffffffffu, s.bits >> 32};
+}
+#else
+using sketchWord = edge;
+
+constexpr count maxSketchNodes = std::numeric_limits<count>::max();
+
+constexpr sketchWord toSketchWord(edge e){
+    return e;
+}
+
+constexpr edge toEdge(sketchWord s){
+    return s;
+}
+#endif
+
+constexpr sketchWord noSketchWord = toSketchWord(noEdge);
+
+#endif //GKKT_SKETCHWORD_HPP
@@ -22,6 +22,12 @@ public:
      */
     node hash(edge e);
 
+    //! Get the number of bytes used by the hash tables
+    count getNumBytes() const;
+
+    //! Get the number of bytes the hash tables of a TabularHash(@n, seed, @pBlockSize) use
+    static count projectNumBytes(count n, uint pBlockSize);
+
 protected:
     uint blockSize;
     uint blockNum;
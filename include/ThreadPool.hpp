@@ -0,0 +1,77 @@
+#ifndef GKKT_THREADPOOL_HPP
+#define GKKT_THREADPOOL_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "base.hpp"
+
+/**
+ * A small pool of persistent worker threads that runs parallel for loops over index ranges
+ * The calling thread takes part in every loop, so a pool of size t starts t - 1 workers
+ * Only one loop may run at a time, parallelFor must not be called from within a loop body
+ */
+class ThreadPool {
+public:
+    /**
+     * Creates a pool that splits loops across @pNumThreads threads (including the caller)
+     * @param pNumThreads the number of threads, 0 is treated as 1
+     */
+    explicit ThreadPool(count pNumThreads);
+
+    ThreadPool(const ThreadPool &other) = delete;
+    ThreadPool& operator=(const ThreadPool &other) = delete;
+
+    ~ThreadPool();
+
+    /**
+     * Get the number of threads loops are split across (including the caller)
+     * @return the number of threads
+     */
+    count getNumThreads() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Calls @body(i) for every i in [@begin, @end), split into contiguous chunks of at least @minChunk indices
+     * If the range is too small for two chunks everything runs on the calling thread
+     * Returns once every call has finished, if any call threw the first exception caught is rethrown after that
+     * @param begin the first index
+     * @param end one past the last index
+     * @param minChunk the minimal number of indices handed to a thread
+     * @param body the loop body
+     */
+    void parallelFor(count begin, count end, count minChunk, const std::function<void(count)> &body);
+
+protected:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    //! Signals the workers that a new loop was published or that they should stop
+    std::condition_variable jobReady;
+    //! Signals the caller that the last worker finished its chunk
+    std::condition_variable jobDone;
+
+    //! The loop that is currently running, chunk c covers [begin + c * chunkSize, begin + (c+1) * chunkSize) clipped to end
+    const std::function<void(count)> *job = nullptr;
+    count jobBegin = 0, jobEnd = 0, chunkSize = 0, numChunks = 0;
+    //! Increased for every loop so that workers notice new jobs
+    count generation = 0;
+    //! Number of workers that still have to finish the current loop
+    count pending = 0;
+    bool stop = false;
+    //! The first exception thrown by a chunk of the current loop, nullptr if none was thrown
+    std::exception_ptr error;
+
+    //! Main loop of worker @id, which handles chunk @id + 1 of every loop (chunk 0 belongs to the caller)
+    void workerLoop(count id);
+
+    //! Runs chunk @chunk of the current loop, an exception ends the chunk and is stored in error if it is the first one
+    void runChunk(count chunk);
+};
+
+#endif //GKKT_THREADPOOL_HPP
@@ -7,7 +7,6 @@
 #include "LinkCutTrees.hpp"
 #include "CutSet.hpp"
 #include "QueryForest.hpp"
-#include "QueryForestAVL.hpp"
 #include "AVLTree.hpp"
 
 class Wang : public DynConnectivity {
@@ -22,16 +21,18 @@ public:
      * @param G the starting graph
      * @param c the precision. Queries are wrong with likelihood <= 1/n^c, the runtime is quadratic in c
      * @param seed the seed for the randomized values
+     * @param queryForestType the forest that answers connectivity queries
      */
-    Wang(Graph &G, float c, uint seed, count boostLevel = 1, Mode mode = base);
+    Wang(Graph &G, float c, uint seed, count boostLevel = 1, Mode mode = base, QueryForestType queryForestType = QueryForestType::btree);
 
     /**
      * Constructs an instance of the algorithm for dynamic connectivity by Gibb, Kapron, King and Thorn on an empty graph with @n vertices
      * @param n the number of vertices in
      * @param c the precision. Queries are wrong with likelihood <= 1/n^c, the runtime is quadratic in c
      * @param seed the seed for the randomized values
+     * @param queryForestType the forest that answers connectivity queries
      */
-    Wang(count n, float c, uint seed, count boostLevel = 1, Mode mode = base);
+    Wang(count n, float c, uint seed, count boostLevel = 1, Mode mode = base, QueryForestType queryForestType = QueryForestType::btree);
 
     /**
      * Queries if node @u and @v are connected in time O(log(n)). Gives false negatives with likelihood at most 1/n^c
@@ -68,7 +69,7 @@ protected:
     double p = 0;
 
     std::vector<AVLTree<node, bool>> adjacencyTrees;
-    std::unique_ptr<QueryForestAVL> queryForest;
+    std::unique_ptr<QueryForest> queryForest;
     std::unique_ptr<CutSet> cutSet;
     std::unique_ptr<LinkCutTrees> linkCutTrees;
 
@@ -77,6 +78,9 @@ protected:
     //! Checks if on @level the tree of @v has an edge leaving it and if so inserts the edge for all levels > @level
     void searchAndInsert(node v, count level);
 
+    //! Adds all edges of @G at once, the ET trees of every level are built bottom-up from a spanning forest instead of edge by edge
+    void build(const Graph &G);
+
 
     //! Sanity check if everything is fine
     void sanityCheck();
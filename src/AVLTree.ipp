@@ -198,6 +198,11 @@ bool AVLTree<Key, Val>::empty() const {
     return root == nullptr;
 }
 
+template<class Key, class Val>
+count AVLTree<Key, Val>::size() const {
+    return (root == nullptr) ? 0 : root->size;
+}
+
 template<class Key, class Val>
 std::vector<std::pair<Key, Val>> AVLTree<Key, Val>::getSortedSet() const {
     if(root == nullptr) return {};
@@ -1,174 +1,653 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
 #include "CutSet.hpp"
+#include "SketchKernels.hpp"
 
-CutSet::CutSet(count pn, count pBoostLevel, count pNumLevels, count seed, const std::vector<AVLTree<node, bool>> &pAdjacencyTrees): adjacencyTrees(pAdjacencyTrees) {
+CutSet::CutSet(count pn, count pBoostLevel, count pNumLevels, count seed, const std::vector<AVLTree<node, bool>> &pAdjacencyTrees,
+               SketchEncoding pEncoding, count numThreads, ETBalancing balancing): adjacencyTrees(pAdjacencyTrees) {
     n = pn;
     boostLevel = pBoostLevel;
     numLevels = pNumLevels;
+    encoding = pEncoding;
     lognsqr = std::ceil(2.0 * std::log2(n)) + 1;
+    assert(n <= maxSketchNodes);
 
     std::mt19937 rng(seed);
     std::uniform_int_distribution<count> dis(0, std::numeric_limits<count>::max());
+    fingerprintSeed = dis(rng);
 
     treeEdges.resize(numLevels);
     activeEdges.resize(numLevels);
-    forests.resize(numLevels, {boostLevel, n});
-    xOrEdgeVectors.resize(numLevels);
+    forests.reserve(numLevels);
     hashes.resize(numLevels);
+    levelBoostLevels.resize(numLevels, boostLevel);
+    boostWindows.resize(numLevels);
+    signatureIndices.resize(n);
+    scratchSketch.resize(2 * boostLevel * lognsqr);
 
-    for(count i = 0; i < numLevels; i++){
-        treeEdges[i].resize(n);
-        activeEdges[i].resize(n, nullptr);
-        xOrEdgeVectors[i].resize(n);
+    //The per vertex storage of a level is only created once the level gets its first tree edge
+    sketches.resize(numLevels);
+    firstSlots.resize(numLevels);
+    sketchPools.reserve(numLevels);
+
+    for(count i = 0; i < numLevels; i++) {
+        forests.emplace_back(boostLevel, n, false, encoding, balancing);
+        sketchPools.emplace_back(2 * boostLevel, lognsqr);
+    }
+
+    //The seeds are drawn up front in a fixed order, so the hash functions don't depend on the number of threads
+    std::vector<count> hashSeeds(numLevels * boostLevel);
+    for(count &hashSeed : hashSeeds) hashSeed = dis(rng);
+
+    setNumThreads(numThreads);
+    forEachLevel(0, numLevels, [this, &hashSeeds](count i){
         hashes[i].reserve(boostLevel);
-        for(count j = 0; j < boostLevel; j++) hashes[i].emplace_back(n, dis(rng), blockSize);
+        for(count j = 0; j < boostLevel; j++) hashes[i].emplace_back(n, hashSeeds[i * boostLevel + j], blockSize);
+    });
+}
+
+void CutSet::setNumThreads(count numThreads) {
+    if(numThreads <= 1) threadPool.reset();
+    else threadPool = std::make_unique<ThreadPool>(numThreads);
+}
+
+edge CutSet::search(node v, count level, bool record) {
+    //Look the root up once, the sketch and the first slot both hang off it
+    address root = record ? getTreeRoot(level, v) : findTreeRoot(level, v);
+    SketchView accumulatedEdges = getTreeSketch(v, level, root);
+    count lines = levelBoostLevels[level];
+    //All slots below the first one are empty, so they can neither hold an edge nor change the prefix
+    count firstSlot = getTreeFirstSlot(v, level, root);
+    //Counters of the boost lines of this level, nullptr if no statistics are collected
+    SearchStats *stats = (searchStats.empty() || not record) ? nullptr : searchStats.data() + level * boostLevel;
+
+    edge found = noEdge;
+    //The line that found an edge and whether any line held edges at all, for adaptive boosting
+    count foundLine = lines;
+    bool nonEmpty = false;
 
-        for(count j = 0; j < n; j++){
-            xOrEdgeVectors[i][j].resize(boostLevel);
-            for(count k = 0; k < boostLevel; k++){
-                xOrEdgeVectors[i][j][k].resize(lognsqr, {0,0});
+    //Try through all the various boost level
+    for(count i = 0; i < lines && foundLine == lines; i++){
+        if(stats != nullptr) stats[i].searches++;
+
+        //With delta encoding the cumulative slot values are rebuilt by a prefix xor
+        sketchWord prefix = noSketchWord, printPrefix = noSketchWord;
+        //Check the levels from sparce to dense
+        count j = firstSlot;
+        for(; j < lognsqr; j++){
+            if(encoding == SketchEncoding::delta) {
+                prefix ^= accumulatedEdges(i, j);
+                printPrefix ^= accumulatedEdges(lines + i, j);
+            }
+            else {
+                prefix = accumulatedEdges(i, j);
+                printPrefix = accumulatedEdges(lines + i, j);
+            }
+
+            if(prefix != noSketchWord){
+                nonEmpty = true;
+                //If the edge isn't {0,0} check if its a valid solution
+                edge candidate = toEdge(prefix);
+                //The slot holds exactly one edge iff the fingerprints match (up to a chance of 2^-64), after a trivial invalidity check
+                //Since edges inside the tree cancel out in its sketch that edge is real and leaves the component of v
+                if(candidate.v < n && candidate.w < n && fingerprint(candidate) == printPrefix){
+                    assert(adjacencyTrees[candidate.v].contains(candidate.w));
+                    assert(checkConnected(candidate.v, v, level) != checkConnected(candidate.w, v, level));
+                    if(stats != nullptr) stats[i].successes++;
+                    found = candidate;
+                    foundLine = i;
+                    break;
+                }
+
+                if(stats != nullptr) stats[i].rejected++;
+                break;
             }
         }
+
+        //Every slot of the line was empty
+        if(stats != nullptr && j == lognsqr) stats[i].empty++;
     }
+
+    //An empty sketch says nothing about the lines, since the tree has no outgoing edges anyway
+    if(targetFailureRate > 0 && nonEmpty && record) recordBoostOutcome(level, foundLine);
+
+    return found;
 }
 
-CutSet::~CutSet() {
-    //Ensure that every tree edge is properly deleted
-    for(count i = 0; i < numLevels; i++){
-        for(node v = 0; v < n; v++){
-            std::vector<std::pair<node, address>> killList = treeEdges[i][v].getSortedSet();
-            for(std::pair<node, address> e : killList) delete e.second;
+void CutSet::recordBoostOutcome(count level, count foundLine) {
+    BoostWindow &window = boostWindows[level];
+    count lines = levelBoostLevels[level];
+
+    window.searches++;
+    if(foundLine == lines) window.failures++;
+    else if(foundLine + 1 == lines) window.lastLineSuccesses++;
+
+    if(window.searches < boostAdaptationWindow) return;
+
+    double failureRate = double(window.failures) / window.searches;
+    //Without the last line every search that needed it would have failed as well
+    double reducedFailureRate = double(window.failures + window.lastLineSuccesses) / window.searches;
+    window = {};
+
+    if(failureRate > targetFailureRate && lines < boostLevel) setLevelBoostLevel(level, lines + 1);
+    else if(2 * reducedFailureRate < targetFailureRate && lines > minBoostLevel) setLevelBoostLevel(level, lines - 1);
+}
+
+void CutSet::setAdaptiveBoost(double pTargetFailureRate) {
+    targetFailureRate = pTargetFailureRate;
+    std::fill(boostWindows.begin(), boostWindows.end(), BoostWindow{});
+}
+
+void CutSet::setMinBoostLevel(count lines) {
+    assert(lines >= 1 && lines <= boostLevel);
+    minBoostLevel = lines;
+}
+
+void CutSet::setLevelBoostLevel(count level, count lines) {
+    assert(lines <= boostLevel);
+    if(lines == levelBoostLevels[level]) return;
+    levelBoostLevels[level] = lines;
+    boostWindows[level] = {};
+
+    //The old sketches stay alive until the ET trees point to the new ones
+    SketchPool pool(2 * lines, lognsqr);
+
+    std::vector<address> activeNodes;
+    std::vector<const sketchWord*> ownData;
+    std::vector<uint8_t> ownFirstSlots;
+    for(node v = 0; v < sketches[level].size(); v++){
+        if(sketches[level][v] == nullptr) continue;
+
+        sketches[level][v] = pool.allocate();
+        firstSlots[level][v] = buildSketch(level, v, sketches[level][v]);
+        if(activeEdges[level][v] != ETForestCutSet::noHandle){
+            activeNodes.push_back(activeEdges[level][v]);
+            ownData.push_back(sketches[level][v]);
+            ownFirstSlots.push_back(firstSlots[level][v]);
         }
     }
+
+    forests[level].setBoostLevel(lines, activeNodes, ownData, ownFirstSlots);
+    sketchPools[level] = std::move(pool);
 }
 
-edge CutSet::search(node v, count level) {
-    std::vector<std::vector<edge>> accumulatedEdges;
+void CutSet::setSearchStatsEnabled(bool enabled) {
+    if(enabled) searchStats.assign(numLevels * boostLevel, {});
+    else searchStats.clear();
+}
 
-    if(activeEdges[level][v] == nullptr){
-        accumulatedEdges = xOrEdgeVectors[level][v];
+void CutSet::resetSearchStats() {
+    std::fill(searchStats.begin(), searchStats.end(), SearchStats{});
+}
+
+CutSet::SearchStats CutSet::getSearchStats(count level, count line) const {
+    if(searchStats.empty()) return {};
+    return searchStats[level * boostLevel + line];
+}
+
+void CutSet::setRootCacheEnabled(bool enabled) {
+    rootCache.clear();
+    rootCacheStats.clear();
+    if(enabled){
+        rootCache.resize(numLevels);
+        rootCacheStats.resize(numLevels);
     }
-    else {
-        accumulatedEdges = forests[level].getTrackingData(forests[level].getRoot(activeEdges[level][v])).accumulatedData;
+    for(ETForestCutSet &forest : forests) forest.setVersioning(enabled);
+}
+
+CutSet::RootCacheStats CutSet::getRootCacheStats(count level) const {
+    if(rootCacheStats.empty()) return {};
+    return rootCacheStats[level];
+}
+
+address CutSet::getTreeRoot(count level, node v) {
+    address active = getActiveEdge(level, v);
+    if(rootCache.empty() || active == ETForestCutSet::noHandle) return forests[level].getRoot(active);
+
+    //Levels are updated in parallel, but every level only touches its own cache and statistics
+    if(rootCache[level].empty()) rootCache[level].resize(n);
+    RootCacheEntry &entry = rootCache[level][v];
+    //A tree edge of v keeps v in the same tree until the next link or cut, which changes the version of its root
+    if(entry.root != ETForestCutSet::noHandle && forests[level].isRoot(entry.root) && forests[level].getVersion(entry.root) == entry.version){
+        rootCacheStats[level].hits++;
+        return entry.root;
     }
 
-    node vRoot = compRepresentative(v, level);
+    rootCacheStats[level].misses++;
+    entry.root = forests[level].getRoot(active);
+    entry.version = forests[level].getVersion(entry.root);
+    return entry.root;
+}
 
-    //Try through all the various boost level
-    for(count i = 0; i < boostLevel; i++){
-        //Check the levels from sparce to dense
-        for(count j = 0; j < lognsqr; j++){
-            if(accumulatedEdges[i][j] != noEdge){
-                //If the edge isn't {0,0} check if its a valid solution
-                edge candidate = accumulatedEdges[i][j];
-                //Trivial invalidity check
-                if(candidate.v >= n || candidate.w >= n) break;
-                //exactly one of the endpoints has to be in the same component as v and the edge has to be real
-                if(adjacencyTrees[candidate.v].contains(candidate.w) && ((compRepresentative(candidate.v, level) == vRoot) != (compRepresentative(candidate.w, level) == vRoot))){
-                    //This edge is real and leaves the component of v
-                    return candidate;
-                }
-                else break;
+std::vector<edge> CutSet::searchMany(node v, count level, count k) {
+    address root = getTreeRoot(level, v);
+    SketchView accumulatedEdges = getTreeSketch(v, level, root);
+    std::vector<edge> found;
+
+    count lines = levelBoostLevels[level];
+    count firstSlot = getTreeFirstSlot(v, level, root);
+
+    for(count i = 0; i < lines && found.size() < k; i++){
+        sketchWord prefix = noSketchWord, printPrefix = noSketchWord;
+        for(count j = firstSlot; j < lognsqr && found.size() < k; j++){
+            if(encoding == SketchEncoding::delta) {
+                prefix ^= accumulatedEdges(i, j);
+                printPrefix ^= accumulatedEdges(lines + i, j);
+            }
+            else {
+                prefix = accumulatedEdges(i, j);
+                printPrefix = accumulatedEdges(lines + i, j);
             }
-        }
 
+            if(prefix == noSketchWord) continue;
+
+            //Keep going after slots that hold several edges, denser slots further on may still hold a single one
+            edge candidate = toEdge(prefix);
+            if(candidate.v >= n || candidate.w >= n || fingerprint(candidate) != printPrefix) continue;
+
+            //The same edge can be isolated in several slots and lines
+            if(std::find(found.begin(), found.end(), candidate) == found.end()) found.push_back(candidate);
+        }
     }
 
-    return noEdge;
+    return found;
+}
+
+SketchView CutSet::getTreeSketch(node v, count level, address root) {
+    //Read the sketch of the whole tree in place, no copies are made unless v is a singleton without a sketch of its own
+    if(root != ETForestCutSet::noHandle) return forests[level].getAccumulatedSketch(root);
+    return {getSingletonSketch(level, v), lognsqr};
+}
+
+count CutSet::getTreeFirstSlot(node v, count level, address root) {
+    if(root != ETForestCutSet::noHandle) return forests[level].getFirstSlot(root);
+    //Singletons without a sketch of their own are built from scratch, nothing is known about them
+    if(getSketch(level, v) == nullptr) return 0;
+    return std::min<count>(firstSlots[level][v], lognsqr);
 }
 
 void CutSet::deleteEdge(edge e) {
-    if(treeEdges[numLevels - 1][e.v].contains(e.w)) makeNonTreeEdge(e);
+    if(isTreeEdge(e, numLevels - 1)) makeNonTreeEdge(e);
 
-    //Since for bitwise xor addition and subtraction is the same we can just use addToXor to also remove it
-    addEdgeToSet(e);
+    //Since for bitwise xor addition and subtraction is the same we can just xor it in again to remove it
+    if(e.v >= e.w) e = {e.w, e.v};
+    xorEdgeIntoSets(e);
+    releaseSignature(e);
+}
+
+void CutSet::deleteEdges(std::span<const edge> edges) {
+    for(edge e : edges){
+        if(isTreeEdge(e, numLevels - 1)) makeNonTreeEdge(e);
+    }
+
+    std::vector<edge> ordered;
+    ordered.reserve(edges.size());
+    for(edge e : edges) ordered.push_back((e.v < e.w) ? e : edge{e.w, e.v});
+
+    //Like for a single edge removing the edges from the sets is the same as adding them
+    xorEdgesIntoSets(ordered);
+    for(edge e : ordered) releaseSignature(e);
 }
 
 void CutSet::makeNonTreeEdge(edge e) {
     //Ensure that it's actually a tree edge
-    assert(treeEdges[numLevels - 1][e.v].contains(e.w) && treeEdges[numLevels - 1][e.w].contains(e.v));
+    assert(isTreeEdge(e, numLevels - 1) && isTreeEdge({e.w, e.v}, numLevels - 1));
 
-    //Move down the levels and remove the edges
-    for(int i = numLevels - 1; i >= 0; i--){
-        if(treeEdges[i][e.v].contains(e.w)){
-            address edge = treeEdges[i][e.v].remove(e.w), backEdge = treeEdges[i][e.w].remove(e.v);
-            forests[i].deleteETEdge(edge, backEdge);
+    //A tree edge is a tree edge on all levels from some lowest level upwards, find that level
+    count lowestLevel = numLevels - 1;
+    while(lowestLevel > 0 && isTreeEdge(e, lowestLevel - 1)) lowestLevel--;
 
-            //If either of the deleted edges was an active edge replace it
-            if(activeEdges[i][e.v] == edge) refreshActiveInstance(i, e.v);
-            if(activeEdges[i][e.w] == backEdge) refreshActiveInstance(i, e.w);
-        }
-        else break;
-    }
+    forEachLevel(lowestLevel, numLevels, [this, e](count i){ makeNonTreeEdgeOnLevel(e, i); });
+}
+
+void CutSet::makeNonTreeEdgeOnLevel(edge e, count level) {
+    address edge = treeEdges[level][e.v].remove(e.w), backEdge = treeEdges[level][e.w].remove(e.v);
+    forests[level].deleteETEdge(edge, backEdge);
+
+    //If either of the deleted edges was an active edge replace it
+    if(activeEdges[level][e.v] == edge) refreshActiveInstance(level, e.v);
+    if(activeEdges[level][e.w] == backEdge) refreshActiveInstance(level, e.w);
 }
 
 void CutSet::refreshActiveInstance(count level, node v){
-    if(treeEdges[level][v].empty()) activeEdges[level][v] = nullptr;
+    if(treeEdges[level][v].empty()) activeEdges[level][v] = ETForestCutSet::noHandle;
     else {
         activeEdges[level][v] = treeEdges[level][v].getAnyEntry().second;
-        forests[level].setTrackingData(activeEdges[level][v], &(xOrEdgeVectors[level][v]));
+        forests[level].setTrackingData(activeEdges[level][v], getSketch(level, v), firstSlots[level][v]);
     }
 }
 
 void CutSet::makeTreeEdge(edge e, count level) {
-    for(count i = level; i < numLevels; i++){
-        assert(compRepresentative(e.v, i) != compRepresentative(e.w, i));
+    forEachLevel(level, numLevels, [this, e](count i){ makeTreeEdgeOnLevel(e, i); });
+}
 
-        //Insert the edge
-        address vEdge = activeEdges[i][e.v], wEdge = activeEdges[i][e.w];
-        std::pair<address, address> newTreeEdges = forests[i].insertETEdge(e.v, e.w, vEdge, wEdge);
+void CutSet::makeTreeEdgeOnLevel(edge e, count level) {
+    assert(not checkConnected(e.v, e.w, level));
+    materializeLevel(level);
 
-        //Store the new tree edges
-        treeEdges[i][e.v].insert(e.w, newTreeEdges.first);
-        treeEdges[i][e.w].insert(e.v, newTreeEdges.second);
+    //Insert the edge
+    address vEdge = activeEdges[level][e.v], wEdge = activeEdges[level][e.w];
+    std::pair<address, address> newTreeEdges = forests[level].insertETEdge(e.v, e.w, vEdge, wEdge);
 
-        //Check if these edges are the new active instances
-        if(vEdge == nullptr) {
-            activeEdges[i][e.v] = newTreeEdges.first;
-            forests[i].setTrackingData(newTreeEdges.first, &(xOrEdgeVectors[i][e.v]));
+    //Store the new tree edges
+    treeEdges[level][e.v].insert(e.w, newTreeEdges.first);
+    treeEdges[level][e.w].insert(e.v, newTreeEdges.second);
+
+    //Check if these edges are the new active instances
+    if(vEdge == ETForestCutSet::noHandle) {
+        activeEdges[level][e.v] = newTreeEdges.first;
+        sketchWord *sketch = materializeSketch(level, e.v);
+        forests[level].setTrackingData(newTreeEdges.first, sketch, firstSlots[level][e.v]);
+    }
+    if(wEdge == ETForestCutSet::noHandle) {
+        activeEdges[level][e.w] = newTreeEdges.second;
+        sketchWord *sketch = materializeSketch(level, e.w);
+        forests[level].setTrackingData(newTreeEdges.second, sketch, firstSlots[level][e.w]);
+    }
+}
+
+void CutSet::buildTreeEdges(std::span<const edge> edges, std::span<const count> lowestLevels) {
+    assert(edges.size() == lowestLevels.size());
+
+    forEachLevel(0, numLevels, [this, edges, lowestLevels](count level){
+        std::vector<edge> levelEdges;
+        for(count k = 0; k < edges.size(); k++){
+            if(lowestLevels[k] <= level) levelEdges.push_back(edges[k]);
         }
-        if(wEdge == nullptr) {
-            activeEdges[i][e.w] = newTreeEdges.second;
-            forests[i].setTrackingData(newTreeEdges.second, &(xOrEdgeVectors[i][e.w]));
+        if(levelEdges.empty()) return;
+
+        materializeLevel(level);
+        for(edge e : levelEdges){
+            materializeSketch(level, e.v);
+            materializeSketch(level, e.w);
         }
-    }
+
+        //The first new edge of a vertex gets its sketch, like makeTreeEdgeOnLevel does it
+        std::vector<std::pair<address, address>> newTreeEdges = forests[level].buildForest(levelEdges, sketches[level], firstSlots[level]);
+        for(count k = 0; k < levelEdges.size(); k++){
+            edge e = levelEdges[k];
+            treeEdges[level][e.v].insert(e.w, newTreeEdges[k].first);
+            treeEdges[level][e.w].insert(e.v, newTreeEdges[k].second);
+            if(activeEdges[level][e.v] == ETForestCutSet::noHandle) activeEdges[level][e.v] = newTreeEdges[k].first;
+            if(activeEdges[level][e.w] == ETForestCutSet::noHandle) activeEdges[level][e.w] = newTreeEdges[k].second;
+        }
+    });
 }
 
 void CutSet::addEdgeToSet(edge e) {
     assert(e.v < n && e.w < n && e.v != e.w);
     if(e.v >= e.w) e = {e.w, e.v};
 
-    for(count i = 0; i < numLevels; i++){
-        std::vector<uint8_t> startingLevel(boostLevel, 0);
-
-        for(count j = 0; j < boostLevel; j++){
-            count hashVal = hashes[i][j].hash(e);
-            //Stores 2^k
-            count binPotk = 1;
-            //Skip all the xOrLevels that e doesn't get inserted into
-            while (hashVal >= binPotk){
-                startingLevel[j]++;
-                binPotk *= 2;
-            }
+    xorEdgeIntoSets(e);
+}
+
+void CutSet::xorEdgeIntoSets(edge e) {
+    count signature = acquireSignature(e);
+
+    forEachLevel(0, numLevels, [this, e, signature](count i){ addEdgeToLevel(e, i, getSignature(signature, i)); });
+}
+
+void CutSet::addEdgeToLevel(edge e, count level, const uint8_t *startingLevel) {
+    sketchWord word = toSketchWord(e), print = fingerprint(e);
+
+    //Vertices without a sketch on this level are singletons, their sketch is computed from their adjacent edges when needed
+    for(node x : {e.v, e.w}){
+        sketchWord *sketch = getSketch(level, x);
+        if(sketch == nullptr) continue;
+
+        xorEdgeIntoSketch(level, sketch, word, print, startingLevel);
+        firstSlots[level][x] = std::min(firstSlots[level][x], getFirstSlot(level, startingLevel));
+
+        //Inform the etForest that some edges were added
+        if(activeEdges[level][x] != ETForestCutSet::noHandle) forests[level].addEdgeToData(activeEdges[level][x], word, print, startingLevel);
+    }
+}
+
+void CutSet::addEdgesToSet(std::span<const edge> edges) {
+    std::vector<edge> ordered;
+    ordered.reserve(edges.size());
+    for(edge e : edges){
+        assert(e.v < n && e.w < n && e.v != e.w);
+        if(e.v >= e.w) e = {e.w, e.v};
+        ordered.push_back(e);
+    }
+
+    xorEdgesIntoSets(ordered);
+}
+
+void CutSet::xorEdgesIntoSets(std::span<const edge> edges) {
+    //All signatures are looked up before the levels are handled, since acquiring them may reallocate the storage
+    std::vector<count> edgeSignatures(edges.size());
+    for(count k = 0; k < edges.size(); k++) edgeSignatures[k] = acquireSignature(edges[k]);
+
+    forEachLevel(0, numLevels, [this, edges, &edgeSignatures](count i){ addEdgesToLevel(edges, edgeSignatures, i); });
+}
+
+void CutSet::addEdgesToLevel(std::span<const edge> edges, const std::vector<count> &edgeSignatures, count level) {
+    count sketchSize = 2 * levelBoostLevels[level] * lognsqr;
+
+    //Collects the combined delta of every active edge touched by the batch, the delta of activeNodes[k] is at k * sketchSize
+    std::vector<address> activeNodes;
+    std::vector<sketchWord> deltas;
+    std::vector<uint8_t> deltaFirstSlots;
+    std::unordered_map<address, count> deltaIndex;
 
-            //e will get inserted into all levels from this point on
-            for(uint8_t k = startingLevel[j]; k < lognsqr; k++){
-                xOrEdgeVectors[i][e.v][j][k] ^= e;
-                xOrEdgeVectors[i][e.w][j][k] ^= e;
+    auto getDelta = [&](address active) -> count {
+        auto it = deltaIndex.find(active);
+        if(it != deltaIndex.end()) return it->second;
+
+        deltaIndex[active] = activeNodes.size();
+        activeNodes.push_back(active);
+        deltas.resize(deltas.size() + sketchSize);
+        deltaFirstSlots.push_back(ETForestCutSet::noFirstSlot);
+        return activeNodes.size() - 1;
+    };
+
+    for(count k = 0; k < edges.size(); k++){
+        edge e = edges[k];
+        const uint8_t *startingLevel = getSignature(edgeSignatures[k], level);
+        sketchWord word = toSketchWord(e), print = fingerprint(e);
+        uint8_t first = getFirstSlot(level, startingLevel);
+
+        for(node x : {e.v, e.w}){
+            sketchWord *sketch = getSketch(level, x);
+            if(sketch == nullptr) continue;
+
+            xorEdgeIntoSketch(level, sketch, word, print, startingLevel);
+            firstSlots[level][x] = std::min(firstSlots[level][x], first);
+
+            if(activeEdges[level][x] != ETForestCutSet::noHandle){
+                count index = getDelta(activeEdges[level][x]);
+                xorEdgeIntoSketch(level, deltas.data() + index * sketchSize, word, print, startingLevel);
+                deltaFirstSlots[index] = std::min(deltaFirstSlots[index], first);
             }
         }
+    }
 
-        //Inform the etForest that some edges were added
-        if(activeEdges[i][e.v] != nullptr) forests[i].addEdgeToData(activeEdges[i][e.v], e, startingLevel);
-        if(activeEdges[i][e.w] != nullptr) forests[i].addEdgeToData(activeEdges[i][e.w], e, startingLevel);
+    //Push the combined deltas up the ET trees in one go
+    std::vector<const sketchWord*> deltaRefs(activeNodes.size());
+    for(count k = 0; k < activeNodes.size(); k++) deltaRefs[k] = deltas.data() + k * sketchSize;
+    forests[level].addSketchesToData(activeNodes, deltaRefs, deltaFirstSlots);
+}
+
+void CutSet::computeStartingLevels(edge e, count level, uint8_t *startingLevel) {
+    for(count j = 0; j < boostLevel; j++){
+        count hashVal = hashes[level][j].hash(e);
+        startingLevel[j] = 0;
+        //Stores 2^k
+        count binPotk = 1;
+        //Skip all the xOrLevels that e doesn't get inserted into
+        while (hashVal >= binPotk){
+            startingLevel[j]++;
+            binPotk *= 2;
+        }
+    }
+}
+
+count CutSet::acquireSignature(edge e) {
+    count signatureSize = numLevels * boostLevel;
+    //Without boost lines there is nothing to store
+    if(signatureSize == 0) return 0;
+
+    if(signatureIndices[e.v].contains(e.w)) return signatureIndices[e.v].findVal(e.w);
+
+    count index;
+    if(freeSignatures.empty()){
+        index = signatures.size() / signatureSize;
+        signatures.resize(signatures.size() + signatureSize);
+    }
+    else {
+        index = freeSignatures.back();
+        freeSignatures.pop_back();
     }
+
+    for(count i = 0; i < numLevels; i++) computeStartingLevels(e, i, signatures.data() + (index * numLevels + i) * boostLevel);
+    signatureIndices[e.v].insert(e.w, index);
+
+    return index;
+}
+
+void CutSet::releaseSignature(edge e) {
+    if(not signatureIndices[e.v].contains(e.w)) return;
+    freeSignatures.push_back(signatureIndices[e.v].remove(e.w));
+}
+
+void CutSet::xorEdgeIntoSketch(count level, sketchWord *sketch, sketchWord e, sketchWord print, const uint8_t *startingLevel) {
+    count lines = levelBoostLevels[level];
+    sketchWord *prints = sketch + lines * lognsqr;
+
+    for(count j = 0; j < lines; j++){
+        //e will get inserted into all levels from this point on (only into its starting level with delta encoding)
+        count rangeLength = (encoding == SketchEncoding::delta) ? 1 : lognsqr - startingLevel[j];
+        xorEdgeIntoRange(sketch + j * lognsqr + startingLevel[j], e, rangeLength);
+        xorEdgeIntoRange(prints + j * lognsqr + startingLevel[j], print, rangeLength);
+    }
+}
+
+sketchWord CutSet::fingerprint(edge e) const {
+    //Two rounds of the splitmix64 finalizer over the seeded endpoints
+    auto mix = [](uint64_t x){
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    };
+    uint64_t h = mix(mix(e.v ^ fingerprintSeed) ^ e.w);
+
+    return toSketchWord({h & 0xffffffffu, h >> 32});
 }
 
 node CutSet::compRepresentative(node v, count level) {
-    if(activeEdges[level][v] == nullptr) return v;
-    return forests[level].getRoot(activeEdges[level][v])->getV();
+    address root = getTreeRoot(level, v);
+    if(root == ETForestCutSet::noHandle) return v;
+    return forests[level].getV(root);
 }
 
 count CutSet::compSize(node v, count level) {
-    if(activeEdges[level][v] == nullptr) return 1;
-    return forests[level].getRoot(activeEdges[level][v])->getSize();
-}
\ No newline at end of file
+    address root = getTreeRoot(level, v);
+    if(root == ETForestCutSet::noHandle) return 1;
+    return forests[level].getSize(root);
+}
+
+bool CutSet::checkConnected(node v, node w, count level) const {
+    if(v == w) return true;
+    address root = findTreeRoot(level, v);
+    return root != ETForestCutSet::noHandle && root == findTreeRoot(level, w);
+}
+
+count CutSet::checkCompSize(node v, count level) const {
+    address root = findTreeRoot(level, v);
+    if(root == ETForestCutSet::noHandle) return 1;
+    return forests[level].getSize(root);
+}
+
+void CutSet::materializeLevel(count level) {
+    if(not treeEdges[level].empty()) return;
+
+    treeEdges[level].resize(n);
+    activeEdges[level].resize(n, ETForestCutSet::noHandle);
+    sketches[level].resize(n, nullptr);
+    firstSlots[level].resize(n, ETForestCutSet::noFirstSlot);
+}
+
+sketchWord* CutSet::materializeSketch(count level, node v) {
+    if(sketches[level][v] == nullptr){
+        sketches[level][v] = sketchPools[level].allocate();
+        firstSlots[level][v] = buildSketch(level, v, sketches[level][v]);
+    }
+
+    return sketches[level][v];
+}
+
+const sketchWord* CutSet::getSingletonSketch(count level, node v) {
+    const sketchWord *sketch = getSketch(level, v);
+    if(sketch != nullptr) return sketch;
+
+    std::fill(scratchSketch.begin(), scratchSketch.end(), noSketchWord);
+    buildSketch(level, v, scratchSketch.data());
+    return scratchSketch.data();
+}
+
+uint8_t CutSet::buildSketch(count level, node v, sketchWord *sketch) {
+    std::vector<uint8_t> startingLevel(boostLevel);
+    uint8_t first = ETForestCutSet::noFirstSlot;
+
+    for(std::pair<node, bool> neighbour : adjacencyTrees[v].getSortedSet()){
+        edge e = (v < neighbour.first) ? edge{v, neighbour.first} : edge{neighbour.first, v};
+
+        //Edges added through the cutset have a signature, anything else is hashed here
+        const uint8_t *levels;
+        if(signatureIndices[e.v].contains(e.w)) levels = getSignature(signatureIndices[e.v].findVal(e.w), level);
+        else {
+            computeStartingLevels(e, level, startingLevel.data());
+            levels = startingLevel.data();
+        }
+
+        xorEdgeIntoSketch(level, sketch, toSketchWord(e), fingerprint(e), levels);
+        first = std::min(first, getFirstSlot(level, levels));
+    }
+
+    return first;
+}
+MemoryUsage CutSet::memoryUsage() const {
+    MemoryUsage usage;
+
+    usage.sketches = scratchSketch.capacity() * sizeof(sketchWord);
+    for(const SketchPool &pool : sketchPools) usage.sketches += pool.getNumBytes();
+
+    for(const ETForestCutSet &forest : forests) usage.etNodes += forest.getNumBytes();
+
+    for(count i = 0; i < numLevels; i++){
+        for(const AVLTree<node, address> &tree : treeEdges[i]) usage.avlNodes += tree.getNumBytes();
+
+        for(const TabularHash &hash : hashes[i]) usage.hashes += hash.getNumBytes();
+
+        usage.other += treeEdges[i].capacity() * sizeof(AVLTree<node, address>) + activeEdges[i].capacity() * sizeof(address)
+                       + sketches[i].capacity() * sizeof(sketchWord*) + firstSlots[i].capacity() * sizeof(uint8_t);
+        if(not rootCache.empty()) usage.other += rootCache[i].capacity() * sizeof(RootCacheEntry);
+    }
+    for(const AVLTree<node, count> &tree : signatureIndices) usage.avlNodes += tree.getNumBytes();
+
+    usage.hashes += signatures.capacity() * sizeof(uint8_t) + freeSignatures.capacity() * sizeof(count);
+    usage.other += signatureIndices.capacity() * sizeof(AVLTree<node, count>);
+
+    return usage;
+}
+
+MemoryUsage CutSet::projectMemoryUsage(count n, count boostLevel, count numLevels, count m) {
+    MemoryUsage usage;
+    count lognsqr = std::ceil(2.0 * std::log2(n)) + 1;
+    //A spanning tree has n - 1 edges, each of which is stored twice
+    count treeNodes = (n == 0) ? 0 : 2 * (n - 1);
+    count pooledSketches = SketchPool::projectNumSketches(n);
+
+    usage.sketches = (numLevels * pooledSketches + 1) * SketchArena::sketchStride(2 * boostLevel, lognsqr) * sizeof(sketchWord);
+    usage.etNodes = numLevels * ETForestCutSet::projectNumBytes(treeNodes, boostLevel, lognsqr, false);
+    usage.avlNodes = numLevels * treeNodes * AVLTree<node, address>::getNodeBytes() + m * AVLTree<node, count>::getNodeBytes();
+    usage.hashes = numLevels * boostLevel * (TabularHash::projectNumBytes(n, blockSize) + m);
+    usage.other = numLevels * n * (sizeof(AVLTree<node, address>) + sizeof(address) + sizeof(sketchWord*) + sizeof(uint8_t))
+                  + n * sizeof(AVLTree<node, count>);
+
+    return usage;
+}
@@ -4,6 +4,7 @@
 
 #include "DTree.hpp"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
 
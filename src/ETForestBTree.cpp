@@ -0,0 +1,474 @@
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <stdexcept>
+
+#include "ETForestBTree.hpp"
+#include "EulerTour.hpp"
+
+//Children of a block are copied here before blocks are allocated, since that may move all blocks
+using ChildArray = std::array<uint32_t, ETForestBTree::maxFanout + 1>;
+
+//Get the number of blocks of a tree with @numEdges edges whose blocks are all minimally filled
+count projectNumBlocks(count numEdges) {
+    count numBlocks = 0;
+    for (count level = numEdges; level > 1; level = (level + ETForestBTree::minFanout - 1) / ETForestBTree::minFanout) {
+        numBlocks += (level + ETForestBTree::minFanout - 1) / ETForestBTree::minFanout;
+    }
+    return std::max<count>(numBlocks, (numEdges == 0) ? 0 : 1);
+}
+
+ETForestBTree::ETForestBTree(count n) {
+    //A spanning forest has at most 2 * (n - 1) edges
+    maxOccurrences = (n > 1) ? 2 * (n - 1) : 0;
+    if (maxOccurrences >= noHandle) throw std::length_error("ETForestBTree: too many edges for 32 bit handles");
+}
+
+count ETForestBTree::projectNumBytes(count numEdges) {
+    return numEdges * sizeof(Occurrence) + projectNumBlocks(numEdges) * sizeof(Block);
+}
+
+ETForestBTree::BlockIndex ETForestBTree::getRoot(Handle e) const {
+    if (e == noHandle) return noHandle;
+    BlockIndex b = occurrences[e].leaf;
+    while (blocks[b].parent != noHandle) b = blocks[b].parent;
+    return b;
+}
+
+ETForestBTree::Handle ETForestBTree::getFirst(BlockIndex root) const {
+    BlockIndex b = root;
+    while (blocks[b].height > 0) b = blocks[b].children[0];
+    return blocks[b].children[0];
+}
+
+std::vector<std::pair<node, node>> ETForestBTree::getTour(Handle e) const {
+    std::vector<std::pair<node, node>> ret;
+
+    std::function<void(BlockIndex)> writeTour = [&](BlockIndex b) {
+        for (count i = 0; i < blocks[b].num; i++) {
+            uint32_t child = blocks[b].children[i];
+            if (blocks[b].height == 0) ret.emplace_back(occurrences[child].v, occurrences[child].w);
+            else writeTour(child);
+        }
+    };
+    writeTour(getRoot(e));
+
+    return ret;
+}
+
+std::pair<ETForestBTree::Handle, ETForestBTree::Handle> ETForestBTree::insertETEdge(node v, node w, Handle vEdge, Handle wEdge) {
+    if (vEdge != noHandle) assert(getRoot(vEdge) != getRoot(wEdge));
+
+    BlockIndex vTree = noHandle, wTree = noHandle;
+    //Ensure that the Eulertours start and end with v and w respectively
+    if (vEdge != noHandle) vTree = makeFront(vEdge);
+    if (wEdge != noHandle) wTree = makeFront(wEdge);
+
+    Handle vwEdge = allocateOccurrence(v, w);
+    Handle wvEdge = allocateOccurrence(w, v);
+
+    //Glue the Euler tours together with the new edges
+    BlockIndex root = join(vTree, occurrences[vwEdge].leaf);
+    root = join(root, wTree);
+    root = join(root, occurrences[wvEdge].leaf);
+
+    checkTreeValidity(root);
+
+    return {vwEdge, wvEdge};
+}
+
+std::vector<std::pair<ETForestBTree::Handle, ETForestBTree::Handle>> ETForestBTree::buildForest(std::span<const edge> edges) {
+    assert(occurrences.empty());
+    std::vector<count> tourStarts;
+    std::vector<count> tour = eulerTours(edges, tourStarts);
+
+    //The edges are created in tour order, so the leaves of a tour hold consecutive edges
+    occurrences.reserve(std::max<count>(maxOccurrences, tour.size()));
+    blocks.reserve(projectNumBlocks(occurrences.capacity()));
+
+    std::vector<std::pair<Handle, Handle>> newEdges(edges.size());
+    for (count i = 0; i < tour.size(); i++) {
+        edge e = edges[tour[i] / 2];
+        assert(e.v < noHandle && e.w < noHandle);
+        Handle h = occurrences.size();
+        occurrences.emplace_back();
+        if (tour[i] % 2 == 0) {
+            occurrences[h].v = e.v;
+            occurrences[h].w = e.w;
+            newEdges[tour[i] / 2].first = h;
+        } else {
+            occurrences[h].v = e.w;
+            occurrences[h].w = e.v;
+            newEdges[tour[i] / 2].second = h;
+        }
+    }
+
+    std::vector<uint32_t> kids, parents;
+    for (count t = 0; t + 1 < tourStarts.size(); t++) {
+        kids.resize(tourStarts[t + 1] - tourStarts[t]);
+        for (count i = 0; i < kids.size(); i++) kids[i] = tourStarts[t] + i;
+
+        //Group the blocks of one height into the fewest blocks above them until a single root remains
+        for (uint8_t height = 0; ; height++) {
+            count numBlocks = (kids.size() + maxFanout - 1) / maxFanout;
+            parents.resize(numBlocks);
+            //Spread the children evenly, with more than one block each gets at least minFanout of them
+            for (count i = 0; i < numBlocks; i++) {
+                count first = kids.size() * i / numBlocks, last = kids.size() * (i + 1) / numBlocks;
+                parents[i] = makeFragment(kids.data() + first, last - first, height);
+            }
+            if (numBlocks == 1) break;
+            std::swap(kids, parents);
+        }
+        checkTreeValidity(parents[0]);
+    }
+
+    return newEdges;
+}
+
+void ETForestBTree::deleteETEdge(Handle edge, Handle backEdge) {
+    assert(edge != noHandle && backEdge != noHandle);
+
+    //Rotate the edge to the front so the backedge is a clean cut
+    makeFront(edge);
+    split(backEdge);
+
+    //Now both edges are the first edges of their trees
+    BlockIndex first = erase(edge);
+    BlockIndex second = erase(backEdge);
+
+    if (first != noHandle) checkTreeValidity(first);
+    if (second != noHandle) checkTreeValidity(second);
+
+    occurrences[edge].leaf = backEdge;
+    occurrences[backEdge].leaf = firstFreeOccurrence;
+    firstFreeOccurrence = edge;
+}
+
+ETForestBTree::Handle ETForestBTree::allocateOccurrence(node v, node w) {
+    assert(v < noHandle && w < noHandle);
+
+    Handle e;
+    if (firstFreeOccurrence != noHandle) {
+        e = firstFreeOccurrence;
+        firstFreeOccurrence = occurrences[e].leaf;
+    } else {
+        //Space for a spanning forest is allocated in one go once the first edge arrives
+        if (occurrences.capacity() == 0) {
+            occurrences.reserve(maxOccurrences);
+            blocks.reserve(projectNumBlocks(maxOccurrences));
+        }
+        //Callers that insert more edges than a spanning forest has would otherwise wrap around into noHandle
+        if (occurrences.size() >= noHandle) throw std::length_error("ETForestBTree: too many edges for 32 bit handles");
+        e = occurrences.size();
+        occurrences.emplace_back();
+    }
+
+    occurrences[e].v = v;
+    occurrences[e].w = w;
+
+    BlockIndex leaf = allocateBlock(0);
+    blocks[leaf].children[0] = e;
+    blocks[leaf].num = 1;
+    refresh(leaf);
+
+    return e;
+}
+
+ETForestBTree::BlockIndex ETForestBTree::allocateBlock(uint8_t height) {
+    BlockIndex b;
+    if (firstFreeBlock != noHandle) {
+        b = firstFreeBlock;
+        firstFreeBlock = blocks[b].parent;
+    } else {
+        if (blocks.size() >= noHandle) throw std::length_error("ETForestBTree: too many blocks for 32 bit handles");
+        b = blocks.size();
+        blocks.emplace_back();
+    }
+
+    blocks[b] = Block();
+    blocks[b].height = height;
+
+    return b;
+}
+
+void ETForestBTree::freeBlock(BlockIndex b) {
+    blocks[b].num = 0;
+    blocks[b].parent = firstFreeBlock;
+    firstFreeBlock = b;
+}
+
+void ETForestBTree::refresh(BlockIndex b) {
+    Block &block = blocks[b];
+    if (block.height == 0) {
+        block.size = block.num;
+        for (count i = 0; i < block.num; i++) occurrences[block.children[i]].leaf = b;
+        return;
+    }
+
+    block.size = 0;
+    for (count i = 0; i < block.num; i++) {
+        block.size += blocks[block.children[i]].size;
+        blocks[block.children[i]].parent = b;
+    }
+}
+
+count ETForestBTree::indexOf(BlockIndex parent, uint32_t child) const {
+    const Block &block = blocks[parent];
+    count i = 0;
+    while (block.children[i] != child) i++;
+    assert(i < block.num);
+    return i;
+}
+
+void ETForestBTree::insertChild(BlockIndex parent, count index, uint32_t child) {
+    Block &block = blocks[parent];
+    assert(block.num <= maxFanout && index <= block.num);
+    std::copy_backward(block.children + index, block.children + block.num, block.children + block.num + 1);
+    block.children[index] = child;
+    block.num++;
+}
+
+ETForestBTree::BlockIndex ETForestBTree::makeFront(Handle e) {
+    std::pair<BlockIndex, BlockIndex> sequenceParts = split(e);
+    return join(sequenceParts.second, sequenceParts.first);
+}
+
+std::pair<ETForestBTree::BlockIndex, ETForestBTree::BlockIndex> ETForestBTree::split(Handle e) {
+    ChildArray kids;
+    BlockIndex b = occurrences[e].leaf;
+    count index = indexOf(b, e);
+
+    //Going up we collect everything left of the path to e in the left tree and everything right of it in the right tree
+    //Every block on the path keeps the children right of the path, the ones left of it move to a new fragment
+    BlockIndex left = noHandle, right = noHandle;
+    bool atLeaf = true;
+    while (b != noHandle) {
+        BlockIndex parent = blocks[b].parent;
+        count parentIndex = (parent != noHandle) ? indexOf(parent, b) : 0;
+
+        count num = blocks[b].num;
+        uint8_t height = blocks[b].height;
+        std::copy(blocks[b].children, blocks[b].children + num, kids.begin());
+
+        //At the leaf e itself stays in the block, above it the child on the path was already taken out
+        count keepFrom = atLeaf ? index : index + 1;
+        blocks[b].num = num - keepFrom;
+        std::copy(kids.begin() + keepFrom, kids.begin() + num, blocks[b].children);
+        blocks[b].parent = noHandle;
+
+        BlockIndex rightFragment;
+        if (blocks[b].num == 0) {
+            freeBlock(b);
+            rightFragment = noHandle;
+        } else {
+            refresh(b);
+            rightFragment = collapseRoot(b);
+        }
+        BlockIndex leftFragment = makeFragment(kids.data(), index, height);
+
+        left = join(leftFragment, left);
+        right = join(right, rightFragment);
+
+        b = parent;
+        index = parentIndex;
+        atLeaf = false;
+    }
+
+    return {left, right};
+}
+
+ETForestBTree::BlockIndex ETForestBTree::join(BlockIndex left, BlockIndex right) {
+    if (left == noHandle) return right;
+    if (right == noHandle) return left;
+    assert(left != right);
+    assert(blocks[left].parent == noHandle && blocks[right].parent == noHandle);
+
+    uint8_t leftHeight = blocks[left].height, rightHeight = blocks[right].height;
+
+    if (leftHeight == rightHeight) {
+        if (blocks[left].num + blocks[right].num <= maxFanout) {
+            //Both fit into a single block
+            std::copy(blocks[right].children, blocks[right].children + blocks[right].num, blocks[left].children + blocks[left].num);
+            blocks[left].num += blocks[right].num;
+            freeBlock(right);
+            refresh(left);
+            return left;
+        }
+
+        BlockIndex root = allocateBlock(leftHeight + 1);
+        blocks[root].children[0] = left;
+        blocks[root].children[1] = right;
+        blocks[root].num = 2;
+        //Roots may be underfull, children of the new root may not
+        if (blocks[left].num < minFanout || blocks[right].num < minFanout) mergeWithSibling(root, 0);
+        refresh(root);
+        return root;
+    }
+
+    //Hang the lower tree into the outer path of the higher one, where it has siblings of the same height
+    BlockIndex pos;
+    count index;
+    if (leftHeight > rightHeight) {
+        pos = left;
+        while (blocks[pos].height > rightHeight + 1) pos = blocks[pos].children[blocks[pos].num - 1];
+        index = blocks[pos].num;
+        insertChild(pos, index, right);
+    } else {
+        pos = right;
+        while (blocks[pos].height > leftHeight + 1) pos = blocks[pos].children[0];
+        index = 0;
+        insertChild(pos, index, left);
+    }
+
+    BlockIndex lower = blocks[pos].children[index];
+    blocks[lower].parent = pos;
+    if (blocks[lower].num < minFanout) mergeWithSibling(pos, index);
+
+    return fixUpwards(pos);
+}
+
+ETForestBTree::BlockIndex ETForestBTree::erase(Handle e) {
+    BlockIndex leaf = occurrences[e].leaf;
+    Block &block = blocks[leaf];
+    count index = indexOf(leaf, e);
+    std::copy(block.children + index + 1, block.children + block.num, block.children + index);
+    block.num--;
+
+    return fixUpwards(leaf);
+}
+
+ETForestBTree::BlockIndex ETForestBTree::makeFragment(const uint32_t *kids, count num, uint8_t height) {
+    if (num == 0) return noHandle;
+    if (height > 0 && num == 1) {
+        blocks[kids[0]].parent = noHandle;
+        return kids[0];
+    }
+
+    BlockIndex b = allocateBlock(height);
+    std::copy(kids, kids + num, blocks[b].children);
+    blocks[b].num = num;
+    refresh(b);
+    return b;
+}
+
+ETForestBTree::BlockIndex ETForestBTree::collapseRoot(BlockIndex b) {
+    while (blocks[b].height > 0 && blocks[b].num == 1) {
+        BlockIndex child = blocks[b].children[0];
+        freeBlock(b);
+        blocks[child].parent = noHandle;
+        b = child;
+    }
+
+    if (blocks[b].num == 0) {
+        freeBlock(b);
+        return noHandle;
+    }
+
+    blocks[b].parent = noHandle;
+    return b;
+}
+
+void ETForestBTree::mergeWithSibling(BlockIndex parent, count index) {
+    count siblingIndex = (index > 0) ? index - 1 : index + 1;
+    assert(siblingIndex < blocks[parent].num);
+    count leftIndex = std::min(index, siblingIndex);
+    BlockIndex left = blocks[parent].children[leftIndex], right = blocks[parent].children[leftIndex + 1];
+    Block &leftBlock = blocks[left], &rightBlock = blocks[right];
+    count total = leftBlock.num + rightBlock.num;
+
+    if (total <= maxFanout) {
+        //The right block is absorbed into the left one
+        std::copy(rightBlock.children, rightBlock.children + rightBlock.num, leftBlock.children + leftBlock.num);
+        leftBlock.num = total;
+        refresh(left);
+
+        Block &parentBlock = blocks[parent];
+        std::copy(parentBlock.children + leftIndex + 2, parentBlock.children + parentBlock.num, parentBlock.children + leftIndex + 1);
+        parentBlock.num--;
+        freeBlock(right);
+        return;
+    }
+
+    //Both blocks get half of the children, which is at least minFanout since together they overflow a block
+    std::array<uint32_t, 2 * (maxFanout + 1)> all;
+    std::copy(leftBlock.children, leftBlock.children + leftBlock.num, all.begin());
+    std::copy(rightBlock.children, rightBlock.children + rightBlock.num, all.begin() + leftBlock.num);
+    count leftNum = total / 2;
+    std::copy(all.begin(), all.begin() + leftNum, leftBlock.children);
+    std::copy(all.begin() + leftNum, all.begin() + total, rightBlock.children);
+    leftBlock.num = leftNum;
+    rightBlock.num = total - leftNum;
+    refresh(left);
+    refresh(right);
+}
+
+ETForestBTree::BlockIndex ETForestBTree::fixUpwards(BlockIndex b) {
+    while (true) {
+        if (blocks[b].num > maxFanout) {
+            //Move the upper half into a new sibling
+            BlockIndex sibling = allocateBlock(blocks[b].height);
+            count keep = blocks[b].num / 2;
+            std::copy(blocks[b].children + keep, blocks[b].children + blocks[b].num, blocks[sibling].children);
+            blocks[sibling].num = blocks[b].num - keep;
+            blocks[b].num = keep;
+            refresh(b);
+            refresh(sibling);
+
+            BlockIndex parent = blocks[b].parent;
+            if (parent == noHandle) {
+                BlockIndex root = allocateBlock(blocks[b].height + 1);
+                blocks[root].children[0] = b;
+                blocks[root].children[1] = sibling;
+                blocks[root].num = 2;
+                refresh(root);
+                return root;
+            }
+
+            insertChild(parent, indexOf(parent, b) + 1, sibling);
+            b = parent;
+            continue;
+        }
+
+        refresh(b);
+        BlockIndex parent = blocks[b].parent;
+        if (parent == noHandle) return collapseRoot(b);
+        if (blocks[b].num < minFanout) mergeWithSibling(parent, indexOf(parent, b));
+        b = parent;
+    }
+}
+
+void ETForestBTree::checkTreeValidity([[maybe_unused]] BlockIndex root) const {
+#ifndef NDEBUG //This code is only executed in debug mode
+    assert(blocks[root].parent == noHandle);
+    assert(blocks[root].num >= ((blocks[root].height == 0) ? 1 : 2));
+
+    std::function<void(BlockIndex)> checkBlock = [&](BlockIndex b) {
+        const Block &block = blocks[b];
+        assert(block.num <= maxFanout);
+        if (b != root) assert(block.num >= minFanout);
+
+        count size = 0;
+        for (count i = 0; i < block.num; i++) {
+            uint32_t child = block.children[i];
+            if (block.height == 0) {
+                assert(occurrences[child].leaf == b);
+                size++;
+            } else {
+                //All leaves have the same depth
+                assert(blocks[child].parent == b);
+                assert(blocks[child].height + 1 == block.height);
+                checkBlock(child);
+                size += blocks[child].size;
+            }
+        }
+        assert(block.size == size);
+    };
+    checkBlock(root);
+
+    //Check if everything is ordered
+    std::vector<std::pair<node, node>> tour = getTour(getFirst(root));
+    for (count i = 0; i + 1 < tour.size(); i++) assert(tour[i].second == tour[i + 1].first);
+#endif
+}
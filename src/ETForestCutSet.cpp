@@ -1,168 +1,470 @@
+#include <bit>
 #include <cassert>
-#include <deque>
 #include <cmath>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include "ETForestCutSet.hpp"
+#include "EulerTour.hpp"
+#include "SketchKernels.hpp"
 
 constexpr bool LEFT = true;
 constexpr bool RIGHT = false;
 
-ETForestCutSet::ETForestCutSet(count pBoostLevel, count n, bool pNoTracking) {
+/**
+ * Calls @function with the boost level as a compile time constant if it is one of the common ones (1 to 4), so the loops over
+ * the lines of a sketch can be unrolled. Any other boost level is passed as the constant 0, which stands for the runtime value
+ */
+template<typename Function>
+void withFixedBoostLevel(count boostLevel, Function &&function) {
+    switch (boostLevel) {
+        case 1: function(std::integral_constant<count, 1>()); break;
+        case 2: function(std::integral_constant<count, 2>()); break;
+        case 3: function(std::integral_constant<count, 3>()); break;
+        case 4: function(std::integral_constant<count, 4>()); break;
+        default: function(std::integral_constant<count, 0>());
+    }
+}
+
+ETForestCutSet::ETForestCutSet(count pBoostLevel, count n, bool pNoTracking, SketchEncoding pEncoding, ETBalancing pBalancing) {
     boostLevel = pBoostLevel;
     if (n != 0) lognsqr = std::ceil(2.0 * std::log2(n)) + 1;
     else lognsqr = 0;
+    sketchSize = 2 * boostLevel * lognsqr;
     noTracking = pNoTracking;
+    encoding = pEncoding;
+    balancing = pBalancing;
+    sketchCapacity = noTracking ? 0 : sketchSize;
+    slotSize = getSlotSize(sketchCapacity);
+    //A spanning forest has at most 2 * (n - 1) nodes
+    if (n > 1 && 2 * (n - 1) >= noHandle) throw std::length_error("ETForestCutSet: too many nodes for 32 bit handles");
 }
 
-address ETForestCutSet::getRoot(ETForestCutSet::Node *v) const {
-    if (v == nullptr) return nullptr;
-    while (v->parent != nullptr) v = v->parent;
-    return v;
+count ETForestCutSet::getSlotSize(count sketchCapacity) {
+    constexpr count wordsPerLine = cacheLineSize / sizeof(sketchWord);
+    return (sketchCapacity + wordsPerLine - 1) / wordsPerLine * wordsPerLine;
 }
 
-const ETForestCutSet::Node::TrackingData &ETForestCutSet::getTrackingData(ETForestCutSet::Node *edge) {
-    return edge->trackingData;
+count ETForestCutSet::nextChunkCapacity(count chunkCapacity, count slotSize) {
+    count capacity = (chunkCapacity == 0) ? minSlotsPerChunk : 2 * chunkCapacity;
+    return std::max<count>(1, std::min(capacity, maxChunkBytes / (slotSize * sizeof(sketchWord))));
 }
 
-void ETForestCutSet::setTrackingData(ETForestCutSet::Node *e, std::vector<std::vector<edge>> *trackingDataRef) {
-    e->trackingData.ownData = trackingDataRef;
-    refreshTrackingDataUpwards(e);
+count ETForestCutSet::projectNumBytes(count numNodes, count boostLevel, count lognsqr, bool noTracking) {
+    //The node arrays grow by doubling
+    count capacity = (numNodes == 0) ? 0 : std::bit_ceil(numNodes);
+    count numBytes = capacity * sizeof(Node);
+    count slotSize = getSlotSize(2 * boostLevel * lognsqr);
+    if (noTracking) return numBytes;
+
+    numBytes += 2 * capacity * sizeof(sketchWord *);
+    if (slotSize == 0) return numBytes;
+    count allocated = 0;
+    for (count chunk = nextChunkCapacity(0, slotSize); allocated < numNodes; chunk = nextChunkCapacity(chunk, slotSize)) allocated += chunk;
+    return numBytes + allocated * slotSize * sizeof(sketchWord);
 }
 
-void ETForestCutSet::addEdgeToData(ETForestCutSet::Node *e, edge newEdge, const std::vector<uint8_t> &startingLevels) {
-    while (e != nullptr) {
-        for (uint8_t i = 0; i < boostLevel; i++) {
-            for (uint8_t j = startingLevels[i]; j < lognsqr; j++) {
-                e->trackingData.accumulatedData[i][j] ^= newEdge;
+address ETForestCutSet::allocateNode(node v, node w) {
+    assert(v < noHandle && w < noHandle);
+
+    Handle e;
+    if (firstFree != noHandle) {
+        e = firstFree;
+        firstFree = at(e).parent;
+        //Fresh chunks are zero already, recycled sketches have to be cleared
+        if (not noTracking && sketchCapacity != 0) {
+            std::fill(accumulatedData[e], accumulatedData[e] + sketchSize, noSketchWord);
+        }
+    } else {
+        //Callers that insert more edges than a spanning forest has would otherwise wrap around into noHandle
+        if (nodes.size() >= noHandle) throw std::length_error("ETForestCutSet: too many nodes for 32 bit handles");
+        e = nodes.size();
+        nodes.emplace_back();
+
+        if (not noTracking) {
+            sketchWord *sketch = nullptr;
+            if (sketchCapacity != 0) {
+                if (usedInChunk == chunkCapacity) {
+                    chunkCapacity = nextChunkCapacity(chunkCapacity, slotSize);
+                    chunks.emplace_back(allocateSketchMemory(chunkCapacity * slotSize), ChunkDeleter{chunkCapacity * slotSize});
+                    numSlots += chunkCapacity;
+                    usedInChunk = 0;
+                }
+                sketch = chunks.back().get() + usedInChunk++ * slotSize;
             }
+            accumulatedData.push_back(sketch);
+            ownData.push_back(nullptr);
         }
-
-        e = e->parent;
+        if (versioning) versions.push_back(0);
     }
+
+    at(e) = Node();
+    at(e).v = v;
+    at(e).w = w;
+    if (not noTracking) ownData[e] = nullptr;
+
+    return e;
 }
 
-std::vector<std::pair<node, node>> ETForestCutSet::getTour(ETForestCutSet::Node *e) {
-    Node *root = getRoot(e);
-    Node *n = root;
+void ETForestCutSet::freeNode(Handle v) {
+    at(v).parent = firstFree;
+    firstFree = v;
+    //The last free node has no parent either, so it must not keep the version of a tree
+    if (versioning) versions[v] = 0;
+}
 
-    std::deque<Node *> stack;
+void ETForestCutSet::setVersioning(bool enabled) {
+    versioning = enabled;
+    if (enabled) versions.assign(nodes.size(), ++lastVersion);
+    else versions = std::vector<count>();
+}
 
-    std::vector<std::pair<node, node>> ret;
+void ETForestCutSet::newVersion(Handle root) {
+    if (not versioning || root == noHandle) return;
+    versions[root] = ++lastVersion;
+}
+
+address ETForestCutSet::getRoot(Handle e) {
+    if (e == noHandle) return noHandle;
+    Handle root = e;
+    count depth = 0;
+    for (; at(root).parent != noHandle; depth++) root = at(root).parent;
+
+    //Nothing else pays for walks up a splay tree, a long one splays e up, which roughly halves the depth of the path it took
+    //e stops below the root, so the root and with it the representative and version of the tree stay the same
+    if (balancing == ETBalancing::splay && depth > maxRootWalk()) splayBelowRoot(e, root);
+    return root;
+}
 
-    while ((not stack.empty()) || (n != nullptr)) {
-        if (n != nullptr) {
-            stack.push_back(n);
-            n = n->leftChild;
+address ETForestCutSet::findRoot(Handle e) const {
+    if (e == noHandle) return noHandle;
+    while (at(e).parent != noHandle) e = at(e).parent;
+    return e;
+}
+
+void ETForestCutSet::splayBelowRoot(Handle v, Handle root) {
+    splay(v, root);
+    //The rotations marked the nodes they moved dirty, the root is the only ancestor left that has to follow
+    if (not noTracking) at(root).dirty = true;
+}
+
+uint8_t ETForestCutSet::getFirstSlot(Handle e) {
+    if (not noTracking) cleanTracking(e);
+    return at(e).firstSlot;
+}
+
+SketchView ETForestCutSet::getAccumulatedSketch(Handle e) {
+    assert(not noTracking);
+    cleanTracking(e);
+    return {accumulatedData[e], lognsqr};
+}
+
+void ETForestCutSet::setTrackingData(Handle e, const sketchWord *trackingDataRef, count ownFirstSlot) {
+    assert(not noTracking);
+    ownData[e] = trackingDataRef;
+    at(e).ownFirstSlot = (trackingDataRef == nullptr) ? noFirstSlot : std::min(ownFirstSlot, lognsqr);
+    markDirtyUpwards(e);
+}
+
+void ETForestCutSet::addEdgeToData(Handle e, sketchWord newEdge, sketchWord fingerprint, const uint8_t *startingLevels) {
+    withFixedBoostLevel(boostLevel, [&](auto fixedBoostLevel) {
+        addEdgeToDataLines<fixedBoostLevel()>(e, newEdge, fingerprint, startingLevels);
+    });
+}
+
+template<count FixedBoostLevel>
+void ETForestCutSet::addEdgeToDataLines(Handle e, sketchWord newEdge, sketchWord fingerprint, const uint8_t *startingLevels) {
+    const count boost = (FixedBoostLevel == 0) ? boostLevel : FixedBoostLevel;
+    //Offset from a slot to the slot of its fingerprint
+    count fingerprintOffset = boost * lognsqr;
+
+    uint8_t first = noFirstSlot;
+    for (count i = 0; i < boost; i++) first = std::min(first, startingLevels[i]);
+    at(e).ownFirstSlot = std::min(at(e).ownFirstSlot, first);
+    //Dirty nodes and their ancestors are recombined from the own sketches anyway, so the edge only goes into the clean nodes below them
+    for (Handle a = e; a != noHandle && not at(a).dirty; a = at(a).parent) at(a).firstSlot = std::min(at(a).firstSlot, first);
+
+    Handle start = e, last = e;
+    count steps = 0;
+    if (encoding == SketchEncoding::delta) {
+        for (; e != noHandle && not at(e).dirty; steps++) {
+            sketchWord *data = accumulatedData[e];
+            for (count i = 0; i < boost; i++, data += lognsqr) {
+                data[startingLevels[i]] ^= newEdge;
+                data[fingerprintOffset + startingLevels[i]] ^= fingerprint;
+            }
+
+            last = e;
+            e = at(e).parent;
+        }
+    } else {
+        for (; e != noHandle && not at(e).dirty; steps++) {
+            sketchWord *data = accumulatedData[e];
+            for (count i = 0; i < boost; i++, data += lognsqr) {
+                xorEdgeIntoRange(data + startingLevels[i], newEdge, lognsqr - startingLevels[i]);
+                xorEdgeIntoRange(data + fingerprintOffset + startingLevels[i], fingerprint, lognsqr - startingLevels[i]);
+            }
+
+            last = e;
+            e = at(e).parent;
+        }
+    }
+
+    //Like in getRoot a long walk pays for splaying its start, the sketches it just updated are recombined once they are read
+    if (balancing == ETBalancing::splay && steps > maxRootWalk()) splayBelowRoot(start, findRoot(last));
+}
+
+void ETForestCutSet::addSketchesToData(const std::vector<Handle> &nodes, const std::vector<const sketchWord *> &deltas,
+                                       const std::vector<uint8_t> &firstSlots) {
+    assert(nodes.size() == deltas.size() && nodes.size() == firstSlots.size());
+    if (sketchSize == 0) return;
+
+    //Pending deltas are stored flat, the delta of a node is at pendingIndex[node] * sketchSize
+    std::vector<sketchWord> pending(nodes.size() * sketchSize);
+    std::vector<uint8_t> pendingFirstSlots(firstSlots);
+    std::unordered_map<Handle, count> pendingIndex;
+    //Nodes are handled from deep to shallow, so a node is only updated after all its descendants passed their deltas on
+    std::priority_queue<std::pair<count, Handle>> queue;
+
+    for (count i = 0; i < nodes.size(); i++) {
+        count depth = 0;
+        for (Handle a = at(nodes[i]).parent; a != noHandle; a = at(a).parent) depth++;
+
+        pendingIndex[nodes[i]] = i;
+        std::copy(deltas[i], deltas[i] + sketchSize, pending.begin() + i * sketchSize);
+        queue.emplace(depth, nodes[i]);
+        //The deltas change the sketches of the vertices the nodes are the active edges of
+        at(nodes[i]).ownFirstSlot = std::min(at(nodes[i]).ownFirstSlot, firstSlots[i]);
+    }
+
+    while (not queue.empty()) {
+        auto [depth, e] = queue.top();
+        queue.pop();
+
+        //A dirty node and all its ancestors are recombined from the own sketches anyway
+        if (at(e).dirty) continue;
+
+        count index = pendingIndex[e];
+        uint8_t first = pendingFirstSlots[index];
+        xorSlotsInto(accumulatedData[e], pending.data() + index * sketchSize, first);
+        at(e).firstSlot = std::min(at(e).firstSlot, first);
+
+        Handle parent = at(e).parent;
+        if (parent == noHandle) continue;
+
+        auto it = pendingIndex.find(parent);
+        if (it == pendingIndex.end()) {
+            //First delta reaching the parent, it gets its own pending delta
+            count parentIndex = pending.size() / sketchSize;
+            pending.resize(pending.size() + sketchSize);
+            std::copy(pending.begin() + index * sketchSize, pending.begin() + (index + 1) * sketchSize, pending.begin() + parentIndex * sketchSize);
+            pendingFirstSlots.push_back(first);
+            pendingIndex[parent] = parentIndex;
+            queue.emplace(depth - 1, parent);
         } else {
-            n = stack.back();
-            stack.pop_back();
-            ret.emplace_back(n->v, n->w);
-            n = n->rightChild;
+            xorSlotsInto(pending.data() + it->second * sketchSize, pending.data() + index * sketchSize, first);
+            pendingFirstSlots[it->second] = std::min(pendingFirstSlots[it->second], first);
         }
     }
+}
+
+void ETForestCutSet::setBoostLevel(count pBoostLevel, const std::vector<Handle> &activeNodes, const std::vector<const sketchWord *> &ownSketches,
+                                   const std::vector<uint8_t> &ownFirstSlots) {
+    assert(activeNodes.size() == ownSketches.size() && activeNodes.size() == ownFirstSlots.size());
+    assert(2 * pBoostLevel * lognsqr <= sketchCapacity);
+    boostLevel = pBoostLevel;
+    sketchSize = 2 * boostLevel * lognsqr;
+
+    for (count i = 0; i < activeNodes.size(); i++) {
+        ownData[activeNodes[i]] = ownSketches[i];
+        at(activeNodes[i]).ownFirstSlot = ownFirstSlots[i];
+    }
+
+    //Every tree holds at least one node with tracking data, so this reaches every tree of the forest
+    std::unordered_set<Handle> roots;
+    for (Handle e : activeNodes) {
+        Handle root = getRoot(e);
+        if (roots.insert(root).second) rebuildTracking(root);
+    }
+}
+
+void ETForestCutSet::rebuildTracking(Handle root) {
+    //Collect the tree top down, walking the list backwards handles every node after its children
+    std::vector<Handle> order = {root};
+    for (count i = 0; i < order.size(); i++) {
+        if (at(order[i]).leftChild != noHandle) order.push_back(at(order[i]).leftChild);
+        if (at(order[i]).rightChild != noHandle) order.push_back(at(order[i]).rightChild);
+    }
 
+    //The sketches stay in their slots, which are large enough for any boost level up to the initial one
+    for (auto it = order.rbegin(); it != order.rend(); it++) {
+        sketchWord *sketch = accumulatedData[*it];
+        std::fill(sketch, sketch + sketchSize, noSketchWord);
+        at(*it).firstSlot = noFirstSlot;
+        at(*it).dirty = false;
+        refreshTracking(*it);
+    }
+}
+
+std::vector<std::pair<node, node>> ETForestCutSet::getTour(Handle e) const {
+    std::vector<std::pair<node, node>> ret;
+    if (e != noHandle) writeTour(findRoot(e), &ret);
     return ret;
 }
 
-std::pair<address, address> ETForestCutSet::insertETEdge(node v, node w, ETForestCutSet::Node *vEdge, ETForestCutSet::Node *wEdge) {
-    if (vEdge != nullptr) assert(getRoot(vEdge) != getRoot(wEdge));
+std::pair<address, address> ETForestCutSet::insertETEdge(node v, node w, Handle vEdge, Handle wEdge) {
+    //Restructuring here would make debug builds shape the trees differently
+    if (vEdge != noHandle) assert(findRoot(vEdge) != findRoot(wEdge));
 
-    Node *vTree = nullptr, *wTree = nullptr;
+    Handle vTree = noHandle, wTree = noHandle;
     //Ensure that the Eulertours start and end with v and w respectively
-    if (vEdge != nullptr) vTree = makeFront(vEdge);
-    if (wEdge != nullptr) wTree = makeFront(wEdge);
+    if (vEdge != noHandle) vTree = makeFront(vEdge);
+    if (wEdge != noHandle) wTree = makeFront(wEdge);
 
-    Node *vwEdge = new Node(v, w, {std::vector<std::vector<edge>>(boostLevel, std::vector<edge>(lognsqr)), nullptr});
-    Node *wvEdge = new Node(w, v, {std::vector<std::vector<edge>>(boostLevel, std::vector<edge>(lognsqr)), nullptr});
+    Handle vwEdge = allocateNode(v, w);
+    Handle wvEdge = allocateNode(w, v);
 
     //Join the Euler tours with the new edges
     vTree = join(vTree, wTree, vwEdge);
     vTree = trivialInsert(wvEdge, vTree, false);
+    numNodes += 2;
+    newVersion(vTree);
 
     return {vwEdge, wvEdge};
 }
 
-void ETForestCutSet::deleteETEdge(ETForestCutSet::Node *edge, ETForestCutSet::Node *backEdge) {
-    assert(edge != nullptr && backEdge != nullptr);
+std::vector<std::pair<address, address>> ETForestCutSet::buildForest(std::span<const edge> edges, const std::vector<sketchWord *> &ownSketches,
+                                                                     const std::vector<uint8_t> &ownFirstSlots) {
+    assert(numNodes == 0);
+    std::vector<count> tourStarts;
+    std::vector<count> tour = eulerTours(edges, tourStarts);
+
+    std::vector<std::pair<Handle, Handle>> newEdges(edges.size());
+    std::vector<Handle> order(tour.size());
+    for (count i = 0; i < tour.size(); i++) {
+        edge e = edges[tour[i] / 2];
+        if (tour[i] % 2 == 0) order[i] = newEdges[tour[i] / 2].first = allocateNode(e.v, e.w);
+        else order[i] = newEdges[tour[i] / 2].second = allocateNode(e.w, e.v);
+    }
+    numNodes += tour.size();
+
+    //Attach the sketches before the trees are built, so every accumulated sketch is combined exactly once
+    if (not noTracking) {
+        std::vector<bool> attached(ownSketches.size(), false);
+        for (count k = 0; k < edges.size(); k++) {
+            for (auto [v, e] : {std::pair(edges[k].v, newEdges[k].first), std::pair(edges[k].w, newEdges[k].second)}) {
+                if (attached[v]) continue;
+                attached[v] = true;
+                ownData[e] = ownSketches[v];
+                at(e).ownFirstSlot = (ownSketches[v] == nullptr) ? noFirstSlot : std::min<count>(ownFirstSlots[v], lognsqr);
+            }
+        }
+    }
+
+    for (count t = 0; t + 1 < tourStarts.size(); t++) {
+        newVersion(buildBalanced(order.data() + tourStarts[t], tourStarts[t + 1] - tourStarts[t]));
+    }
+
+    return newEdges;
+}
+
+void ETForestCutSet::deleteETEdge(Handle edge, Handle backEdge) {
+    assert(edge != noHandle && backEdge != noHandle);
 
     //Rotate the edge to the front so the backedge is a clean cut
     makeFront(edge);
-    std::pair<Node *, Node *> splitTour = split(backEdge);
+    std::pair<Handle, Handle> splitTour = split(backEdge);
 
-    //Now we simply have to remove edge and backedge and delete them
-    std::pair<Node *, Node *> edgePair = trivialDelete(splitTour.first, true);
+    //Now we simply have to remove edge and backedge and free their nodes
+    [[maybe_unused]] std::pair<Handle, Handle> edgePair = trivialDelete(splitTour.first, true);
     assert(edgePair.first == edge);
-    delete edge;
-    std::pair<Node *, Node *> backEdgePair = trivialDelete(splitTour.second, true);
+    freeNode(edge);
+    [[maybe_unused]] std::pair<Handle, Handle> backEdgePair = trivialDelete(splitTour.second, true);
     assert(backEdgePair.first == backEdge);
-    delete backEdge;
+    freeNode(backEdge);
+    numNodes -= 2;
+
+    //Both remaining trees changed, every other tree kept its root and version
+    newVersion(edgePair.second);
+    newVersion(backEdgePair.second);
 }
 
-address ETForestCutSet::makeFront(ETForestCutSet::Node *newFront) {
-    assert(newFront != nullptr);
-    std::pair<Node *, Node *> sequenceParts = split(newFront);
-    if (sequenceParts.first == nullptr) return sequenceParts.second;
+address ETForestCutSet::makeFront(Handle newFront) {
+    assert(newFront != noHandle);
+    std::pair<Handle, Handle> sequenceParts = split(newFront);
+    if (sequenceParts.first == noHandle) return sequenceParts.second;
 
     //We wish to swap around the order of stuff, so we use the first node in the front path as the join node
-    std::pair<Node *, Node *> splitFirst = trivialDelete(sequenceParts.first, true);
+    std::pair<Handle, Handle> splitFirst = trivialDelete(sequenceParts.first, true);
     //Now we just glue together the two parts the other way around
-    Node *newTree = join(sequenceParts.second, splitFirst.second, splitFirst.first);
+    Handle newTree = join(sequenceParts.second, splitFirst.second, splitFirst.first);
 
     checkTreeValidity(newTree);
 
     return newTree;
 }
 
-std::pair<address, address> ETForestCutSet::split(ETForestCutSet::Node *v) {
-    assert(v != nullptr);
+std::pair<address, address> ETForestCutSet::split(Handle v) {
+    assert(v != noHandle);
+
+    if (balancing == ETBalancing::splay) {
+        //Everything before v is the left subtree of v once v is the root
+        splay(v);
+        Handle leftTree = separateDirChild(v, LEFT);
+        refreshSubtreeInfo(v);
+        return {leftTree, v};
+    }
 
     //Get the starting trees
-    Node *leftTree = separateDirChild(v, true);
-    Node *rightTree = separateDirChild(v, false);
+    Handle leftTree = separateDirChild(v, LEFT);
+    Handle rightTree = separateDirChild(v, RIGHT);
 
     //Trivial case that this was it
-    if (v->parent == nullptr) {
-        if (rightTree != nullptr) rightTree = trivialInsert(v, rightTree, true);
+    if (at(v).parent == noHandle) {
+        if (rightTree != noHandle) rightTree = trivialInsert(v, rightTree, true);
         else {
             cleanNode(v);
             rightTree = v;
         }
 
-        if (leftTree != nullptr) checkTreeValidity(leftTree);
+        if (leftTree != noHandle) checkTreeValidity(leftTree);
         checkTreeValidity(rightTree);
 
         return {leftTree, rightTree};
     }
 
     //Other Case: Now we move up the tree and join all the left/right subtrees
-    Node *pos = v->parent;
-    Node *parent;
-    Node *joinTree;
+    Handle pos = at(v).parent;
+    Handle parent;
+    Handle joinTree;
     bool left, nextLeft;
 
     //Cut off v from its parent
-    if (pos->leftChild == v) {
-        pos->leftChild = nullptr;
+    if (at(pos).leftChild == v) {
+        at(pos).leftChild = noHandle;
         left = false;
     } else {
-        pos->rightChild = nullptr;
+        at(pos).rightChild = noHandle;
         left = true;
     }
-    rightTree = join(nullptr, rightTree, v);
+    rightTree = join(noHandle, rightTree, v);
 
-    while (pos != nullptr) {
-        parent = pos->parent;
+    while (pos != noHandle) {
+        parent = at(pos).parent;
         //Cut off pos from parent
-        if (parent != nullptr) {
-            if (parent->leftChild == pos) {
-                parent->leftChild = nullptr;
+        if (parent != noHandle) {
+            if (at(parent).leftChild == pos) {
+                at(parent).leftChild = noHandle;
                 nextLeft = false;
             } else {
-                parent->rightChild = nullptr;
+                at(parent).rightChild = noHandle;
                 nextLeft = true;
             }
-            pos->parent = nullptr;
+            at(pos).parent = noHandle;
         }
 
         //Get the tree we want to join in
@@ -183,23 +485,35 @@ std::pair<address, address> ETForestCutSet::split(ETForestCutSet::Node *v) {
     return {leftTree, rightTree};
 }
 
-address ETForestCutSet::join(ETForestCutSet::Node *leftTree, ETForestCutSet::Node *rightTree, ETForestCutSet::Node *joinNode) {
-    assert(joinNode != nullptr);
+address ETForestCutSet::join(Handle leftTree, Handle rightTree, Handle joinNode) {
+    assert(joinNode != noHandle);
     assert(leftTree != joinNode && joinNode != rightTree);
-    if (leftTree != nullptr) assert(leftTree != rightTree);
-    if (leftTree != nullptr) assert(leftTree->parent == nullptr);
-    if (rightTree != nullptr) assert(rightTree->parent == nullptr);
+    if (leftTree != noHandle) assert(leftTree != rightTree);
+    if (leftTree != noHandle) assert(at(leftTree).parent == noHandle);
+    if (rightTree != noHandle) assert(at(rightTree).parent == noHandle);
     cleanNode(joinNode);
-    if (leftTree == nullptr && rightTree == nullptr) return joinNode;
-    if (leftTree == nullptr) return trivialInsert(joinNode, rightTree, true);
-    if (rightTree == nullptr) return trivialInsert(joinNode, leftTree, false);
+    if (leftTree == noHandle && rightTree == noHandle) return joinNode;
+
+    if (balancing == ETBalancing::splay) {
+        //The join node simply becomes the new root
+        at(joinNode).leftChild = leftTree;
+        at(joinNode).rightChild = rightTree;
+        if (leftTree != noHandle) at(leftTree).parent = joinNode;
+        if (rightTree != noHandle) at(rightTree).parent = joinNode;
+        refreshSubtreeInfo(joinNode);
+        return joinNode;
+    }
+
+    if (leftTree == noHandle) return trivialInsert(joinNode, rightTree, true);
+    if (rightTree == noHandle) return trivialInsert(joinNode, leftTree, false);
 
     //Trivial case that both are roughly equal in height
-    if (leftTree->height <= rightTree->height + 1 && rightTree->height <= leftTree->height + 1) {
-        joinNode->leftChild = leftTree;
-        joinNode->rightChild = rightTree;
-        leftTree->parent = joinNode;
-        rightTree->parent = joinNode;
+    count leftHeight = at(leftTree).height, rightHeight = at(rightTree).height;
+    if (leftHeight <= rightHeight + 1 && rightHeight <= leftHeight + 1) {
+        at(joinNode).leftChild = leftTree;
+        at(joinNode).rightChild = rightTree;
+        at(leftTree).parent = joinNode;
+        at(rightTree).parent = joinNode;
 
         refreshSubtreeInfo(joinNode);
 
@@ -208,36 +522,36 @@ address ETForestCutSet::join(ETForestCutSet::Node *leftTree, ETForestCutSet::Nod
         return joinNode;
     }
 
-    Node *pos;
+    Handle pos;
 
     //Case of a left join
-    if (leftTree->height > rightTree->height) {
+    if (leftHeight > rightHeight) {
         pos = leftTree;
-        while (getHeight(pos->rightChild) > rightTree->height) pos = pos->rightChild;
+        while (getHeight(at(pos).rightChild) > rightHeight) pos = at(pos).rightChild;
         //Now the right child of pos is equal or 1 smaller then right tree
-        Node *smallTree = separateDirChild(pos, false);
+        Handle smallTree = separateDirChild(pos, RIGHT);
 
-        joinNode->leftChild = smallTree;
-        if (smallTree != nullptr) smallTree->parent = joinNode;
-        joinNode->rightChild = rightTree;
-        rightTree->parent = joinNode;
+        at(joinNode).leftChild = smallTree;
+        if (smallTree != noHandle) at(smallTree).parent = joinNode;
+        at(joinNode).rightChild = rightTree;
+        at(rightTree).parent = joinNode;
         refreshSubtreeInfo(joinNode);
-        pos->rightChild = joinNode;
-        joinNode->parent = pos;
+        at(pos).rightChild = joinNode;
+        at(joinNode).parent = pos;
         pos = rebalance(pos);
     } else {
         pos = rightTree;
-        while (getHeight(pos->leftChild) > leftTree->height) pos = pos->leftChild;
-        //Now the right child of pos is equal or 1 smaller then right tree
-        Node *smallTree = separateDirChild(pos, true);
-
-        joinNode->rightChild = smallTree;
-        if (smallTree != nullptr) smallTree->parent = joinNode;
-        joinNode->leftChild = leftTree;
-        leftTree->parent = joinNode;
+        while (getHeight(at(pos).leftChild) > leftHeight) pos = at(pos).leftChild;
+        //Now the left child of pos is equal or 1 smaller then left tree
+        Handle smallTree = separateDirChild(pos, LEFT);
+
+        at(joinNode).rightChild = smallTree;
+        if (smallTree != noHandle) at(smallTree).parent = joinNode;
+        at(joinNode).leftChild = leftTree;
+        at(leftTree).parent = joinNode;
         refreshSubtreeInfo(joinNode);
-        pos->leftChild = joinNode;
-        joinNode->parent = pos;
+        at(pos).leftChild = joinNode;
+        at(joinNode).parent = pos;
         pos = rebalance(pos);
     }
 
@@ -246,22 +560,32 @@ address ETForestCutSet::join(ETForestCutSet::Node *leftTree, ETForestCutSet::Nod
     return pos;
 }
 
-address ETForestCutSet::trivialInsert(Node *newNode, ETForestCutSet::Node *root, bool first) {
-    assert(root != nullptr);
-    assert(newNode != nullptr);
+address ETForestCutSet::trivialInsert(Handle newNode, Handle root, bool first) {
+    assert(root != noHandle);
+    assert(newNode != noHandle);
     cleanNode(newNode);
-    //Step 1: Move down until we find the place where the new pair belongs
-    Node *pos = root;
+
+    if (balancing == ETBalancing::splay) {
+        //The new node becomes the root with the old tree on the side it is not inserted on
+        if (first) at(newNode).rightChild = root;
+        else at(newNode).leftChild = root;
+        at(root).parent = newNode;
+        refreshSubtreeInfo(newNode);
+        return newNode;
+    }
+
+    //Move down until we find the place where the new node belongs
+    Handle pos = root;
 
     if (first) {
-        while (pos->leftChild != nullptr) pos = pos->leftChild;
-        pos->leftChild = newNode;
+        while (at(pos).leftChild != noHandle) pos = at(pos).leftChild;
+        at(pos).leftChild = newNode;
     } else {
-        while (pos->rightChild != nullptr) pos = pos->rightChild;
-        pos->rightChild = newNode;
+        while (at(pos).rightChild != noHandle) pos = at(pos).rightChild;
+        at(pos).rightChild = newNode;
     }
 
-    newNode->parent = pos;
+    at(newNode).parent = pos;
 
     pos = rebalance(pos);
 
@@ -270,73 +594,62 @@ address ETForestCutSet::trivialInsert(Node *newNode, ETForestCutSet::Node *root,
     return pos;
 }
 
-std::pair<address, address> ETForestCutSet::trivialDelete(ETForestCutSet::Node *root, bool first) {
-    assert(root != nullptr);
+std::pair<address, address> ETForestCutSet::trivialDelete(Handle root, bool first) {
+    assert(root != noHandle);
 
-    Node *u = root;
+    Handle u = root;
 
     //Locating the relevant node
     if (first) {
-        while (u->leftChild != nullptr) u = u->leftChild;
+        while (at(u).leftChild != noHandle) u = at(u).leftChild;
     } else {
-        while (u->rightChild != nullptr) u = u->rightChild;
+        while (at(u).rightChild != noHandle) u = at(u).rightChild;
     }
 
-    //u has at most 1 child
-    Node *parent = u->parent;
-    if (u->leftChild == nullptr && u->rightChild == nullptr) {
-        if (parent != nullptr) {
-            if (parent->leftChild == u) parent->leftChild = nullptr;
-            else parent->rightChild = nullptr;
-            root = rebalance(parent);
-        } else root = nullptr;
-    } else if (u->leftChild != nullptr) {
-        if (parent != nullptr) {
-            if (parent->leftChild == u) parent->leftChild = u->leftChild;
-            else parent->rightChild = u->leftChild;
-            u->leftChild->parent = parent;
-            root = rebalance(parent);
-        } else {
-            u->leftChild->parent = nullptr;
-            root = u->leftChild;
-        }
-    } else if (u->rightChild != nullptr) {
-        if (parent != nullptr) {
-            if (parent->leftChild == u) parent->leftChild = u->rightChild;
-            else parent->rightChild = u->rightChild;
-            u->rightChild->parent = parent;
-            root = rebalance(parent);
-        } else {
-            u->rightChild->parent = nullptr;
-            root = u->rightChild;
-        }
+    if (balancing == ETBalancing::splay) {
+        //Once u is the root the rest of the tree is its only child
+        splay(u);
+        root = separateDirChild(u, not first);
+        cleanNode(u);
+        return {u, root};
     }
 
+    //u has at most 1 child
+    Handle parent = at(u).parent;
+    Handle child = (at(u).leftChild != noHandle) ? at(u).leftChild : at(u).rightChild;
+    if (child != noHandle) at(child).parent = parent;
+    if (parent != noHandle) {
+        if (at(parent).leftChild == u) at(parent).leftChild = child;
+        else at(parent).rightChild = child;
+        root = rebalance(parent);
+    } else root = child;
+
     cleanNode(u);
 
-    if (root != nullptr) checkTreeValidity(root);
+    if (root != noHandle) checkTreeValidity(root);
 
     return {u, root};
 }
 
-address ETForestCutSet::rebalance(address start) {
-    Node *prev = start;
-    while (start != nullptr) {
+address ETForestCutSet::rebalance(Handle start) {
+    Handle prev = start;
+    while (start != noHandle) {
         prev = start;
-        start = start->parent;
+        start = at(start).parent;
         refreshSubtreeInfo(prev);
-        if (getHeight(prev->leftChild) > getHeight(prev->rightChild) + 1) {
+        Handle left = at(prev).leftChild, right = at(prev).rightChild;
+        if (getHeight(left) > getHeight(right) + 1) {
             //Right rotation necessary
-            if (getHeight(prev->leftChild->rightChild) > getHeight(prev->leftChild->leftChild)) {
+            if (getHeight(at(left).rightChild) > getHeight(at(left).leftChild)) {
                 //Left-Right-Rotation necessary
-                rotate(prev->leftChild, LEFT);
+                rotate(left, LEFT);
             }
             prev = rotate(prev, RIGHT);
-        } else if (getHeight(prev->rightChild) > getHeight(prev->leftChild) + 1) {
-            //Right rotation necessary
-            if (getHeight(prev->rightChild->leftChild) > getHeight(prev->rightChild->rightChild)) {
-                //Left-Right-Rotation necessary
-                rotate(prev->rightChild, RIGHT);
+        } else if (getHeight(right) > getHeight(left) + 1) {
+            //Left rotation necessary
+            if (getHeight(at(right).leftChild) > getHeight(at(right).rightChild)) {
+                //Right-Left-Rotation necessary
+                rotate(right, RIGHT);
             }
             prev = rotate(prev, LEFT);
         }
@@ -345,182 +658,264 @@ address ETForestCutSet::rebalance(address start) {
     return prev;
 }
 
-address ETForestCutSet::rotate(ETForestCutSet::Node *head, bool left) {
-    Node *parent = head->parent;
-    Node *kid;
+address ETForestCutSet::rotate(Handle head, bool left) {
+    Handle parent = at(head).parent;
+    Handle kid;
 
     //Standard rotate of AVL-Trees
     if (left) {
-        assert(head->rightChild != nullptr);
-        //assert(head->rightChild->rightChild != nullptr);
+        assert(at(head).rightChild != noHandle);
         kid = separateDirChild(head, RIGHT);
-        Node *innerGrandKid = separateDirChild(kid, LEFT);
-        kid->leftChild = head;
-        head->parent = kid;
-        head->rightChild = innerGrandKid;
-        if (innerGrandKid != nullptr) innerGrandKid->parent = head;
+        Handle innerGrandKid = separateDirChild(kid, LEFT);
+        at(kid).leftChild = head;
+        at(head).parent = kid;
+        at(head).rightChild = innerGrandKid;
+        if (innerGrandKid != noHandle) at(innerGrandKid).parent = head;
     } else {
-        assert(head->leftChild != nullptr);
-        //assert(head->leftChild->leftChild != nullptr);
+        assert(at(head).leftChild != noHandle);
         kid = separateDirChild(head, LEFT);
-        Node *innerGrandKid = separateDirChild(kid, RIGHT);
-        kid->rightChild = head;
-        head->parent = kid;
-        head->leftChild = innerGrandKid;
-        if (innerGrandKid != nullptr) innerGrandKid->parent = head;
+        Handle innerGrandKid = separateDirChild(kid, RIGHT);
+        at(kid).rightChild = head;
+        at(head).parent = kid;
+        at(head).leftChild = innerGrandKid;
+        if (innerGrandKid != noHandle) at(innerGrandKid).parent = head;
     }
 
     refreshSubtreeInfo(head);
     refreshSubtreeInfo(kid);
 
     //Fix connection to parents
-    kid->parent = parent;
+    at(kid).parent = parent;
 
-    if (parent != nullptr) {
-        if (parent->leftChild == head) parent->leftChild = kid;
-        else parent->rightChild = kid;
+    if (parent != noHandle) {
+        if (at(parent).leftChild == head) at(parent).leftChild = kid;
+        else at(parent).rightChild = kid;
     }
 
     return kid;
 }
 
-void ETForestCutSet::cleanNode(ETForestCutSet::Node *v) {
-    v->parent = nullptr;
-    v->leftChild = nullptr;
-    v->rightChild = nullptr;
-    v->height = 1;
-    v->size = 1;
-    if (not noTracking) refreshTracking(v);
+void ETForestCutSet::splay(Handle v, Handle top) {
+    while (at(v).parent != top) {
+        Handle parent = at(v).parent;
+        Handle grandParent = at(parent).parent;
+        bool isLeft = at(parent).leftChild == v;
+
+        if (grandParent == top) {
+            rotate(parent, not isLeft);
+        } else if ((at(grandParent).leftChild == parent) == isLeft) {
+            //Zig-zig, the parent is rotated up first
+            rotate(grandParent, not isLeft);
+            rotate(parent, not isLeft);
+        } else {
+            //Zig-zag
+            rotate(parent, not isLeft);
+            rotate(grandParent, isLeft);
+        }
+    }
 }
 
-void ETForestCutSet::refreshSubtreeInfo(ETForestCutSet::Node *v) {
-    v->size = 1;
-    v->height = 1;
-    if (v->leftChild != nullptr) {
-        v->size += v->leftChild->size;
-        v->height = v->leftChild->height + 1;
-    }
-    if (v->rightChild != nullptr) {
-        v->size += v->rightChild->size;
-        v->height = std::max(v->height, v->rightChild->height + 1);
-    }
+void ETForestCutSet::cleanNode(Handle v) {
+    Node &data = at(v);
+    data.parent = noHandle;
+    data.leftChild = noHandle;
+    data.rightChild = noHandle;
+    data.height = 1;
+    data.size = 1;
+    if (not noTracking) data.dirty = true;
+}
+
+void ETForestCutSet::refreshSubtreeInfo(Handle v) {
+    Node &data = at(v);
+    data.size = 1 + getSubtreeSize(data.leftChild) + getSubtreeSize(data.rightChild);
+    //Splay trees never look at heights, which could exceed the 8 bits of a node
+    if (balancing == ETBalancing::avl) data.height = std::max(getHeight(data.leftChild), getHeight(data.rightChild)) + 1;
 
-    if (not noTracking) refreshTracking(v);
+    //The sketches are only recombined once someone reads them, so sequences of links and cuts don't pay for intermediate aggregates
+    if (not noTracking) data.dirty = true;
 }
 
-void ETForestCutSet::refreshTrackingDataUpwards(ETForestCutSet::Node *v) {
-    while (v != nullptr) {
-        refreshTracking(v);
-        v = v->parent;
+void ETForestCutSet::markDirtyUpwards(Handle v) {
+    while (v != noHandle && not at(v).dirty) {
+        at(v).dirty = true;
+        v = at(v).parent;
     }
 }
 
-void ETForestCutSet::refreshTracking(ETForestCutSet::Node *v) {
-    assert(not noTracking);
+void ETForestCutSet::cleanTracking(Handle v) {
+    if (not at(v).dirty) return;
 
-    assert(v->trackingData.ownData == nullptr || v->trackingData.ownData->size() == boostLevel);
-    assert(v->trackingData.accumulatedData.size() == boostLevel);
+    //Collect the dirty nodes top down, children of clean nodes are clean, so this only descends into the parts of the tree that changed
+    //Splay trees can be deep, so this doesn't recurse
+    dirtyNodes.assign(1, v);
+    for (count i = 0; i < dirtyNodes.size(); i++) {
+        for (Handle child : {at(dirtyNodes[i]).leftChild, at(dirtyNodes[i]).rightChild}) {
+            if (child != noHandle && at(child).dirty) dirtyNodes.push_back(child);
+        }
+    }
 
-    if (v->trackingData.ownData != nullptr)
-        for (count i = 0; i < boostLevel; i++)
-            for (count j = 0; j < lognsqr; j++)
-                v->trackingData.accumulatedData[i][j] = (*v->trackingData.ownData)[i][j];
-    else
-        for (count i = 0; i < boostLevel; i++)
-            for (count j = 0; j < lognsqr; j++)
-                v->trackingData.accumulatedData[i][j] = noEdge;
+    for (auto it = dirtyNodes.rbegin(); it != dirtyNodes.rend(); it++) {
+        refreshTracking(*it);
+        at(*it).dirty = false;
+    }
+}
 
-    if (v->leftChild != nullptr)
-        for (count i = 0; i < boostLevel; i++)
-            for (count j = 0; j < lognsqr; j++)
-                v->trackingData.accumulatedData[i][j] ^= v->leftChild->trackingData.accumulatedData[i][j];
+void ETForestCutSet::refreshTracking(Handle v) {
+    withFixedBoostLevel(boostLevel, [&](auto fixedBoostLevel) {
+        refreshTrackingLines<fixedBoostLevel()>(v);
+    });
+}
 
-    if (v->rightChild != nullptr)
-        for (count i = 0; i < boostLevel; i++)
-            for (count j = 0; j < lognsqr; j++)
-                v->trackingData.accumulatedData[i][j] ^= v->rightChild->trackingData.accumulatedData[i][j];
+template<count FixedBoostLevel>
+void ETForestCutSet::refreshTrackingLines(Handle v) {
+    const count boost = (FixedBoostLevel == 0) ? boostLevel : FixedBoostLevel;
+    assert(not noTracking);
+    assert(sketchSize == 0 || accumulatedData[v] != nullptr);
+
+    Node &data = at(v);
+    sketchWord *accumulated = accumulatedData[v];
+    const sketchWord *own = ownData[v];
+    const sketchWord *left = (data.leftChild != noHandle) ? accumulatedData[data.leftChild] : nullptr;
+    const sketchWord *right = (data.rightChild != noHandle) ? accumulatedData[data.rightChild] : nullptr;
+
+    count first = std::min<count>(data.ownFirstSlot, lognsqr);
+    if (data.leftChild != noHandle) first = std::min<count>(first, at(data.leftChild).firstSlot);
+    if (data.rightChild != noHandle) first = std::min<count>(first, at(data.rightChild).firstSlot);
+
+    //Own sketch xor both child aggregates in a single vectorized pass
+    if (first == 0) {
+        combineSketches(accumulated, own, left, right, 2 * boost * lognsqr);
+        data.firstSlot = 0;
+        return;
+    }
+
+    //Slots that were in use before but are 0 in every input now have to be cleared
+    count oldFirst = std::min<count>(data.firstSlot, lognsqr);
+    for (count line = 0; line < 2 * boost; line++) {
+        count offset = line * lognsqr;
+        if (oldFirst < first) std::fill(accumulated + offset + oldFirst, accumulated + offset + first, noSketchWord);
+        combineSketches(accumulated + offset + first,
+                        (own != nullptr) ? own + offset + first : nullptr,
+                        (left != nullptr) ? left + offset + first : nullptr,
+                        (right != nullptr) ? right + offset + first : nullptr,
+                        lognsqr - first);
+    }
+    data.firstSlot = first;
 }
 
-address ETForestCutSet::separateDirChild(ETForestCutSet::Node *v, bool left) {
-    Node *kid;
-    if (left) {
-        if (v->leftChild == nullptr) return nullptr;
-        kid = v->leftChild;
-        kid->parent = nullptr;
-        v->leftChild = nullptr;
-    } else {
-        if (v->rightChild == nullptr) return nullptr;
-        kid = v->rightChild;
-        kid->parent = nullptr;
-        v->rightChild = nullptr;
+void ETForestCutSet::xorSlotsInto(sketchWord *dst, const sketchWord *src, count firstSlot) {
+    if (firstSlot >= lognsqr) return;
+    if (firstSlot == 0) {
+        xorSketchInto(dst, src, sketchSize);
+        return;
     }
 
+    for (count offset = firstSlot; offset < sketchSize; offset += lognsqr) xorSketchInto(dst + offset, src + offset, lognsqr - firstSlot);
+}
+
+address ETForestCutSet::separateDirChild(Handle v, bool left) {
+    Handle &child = left ? at(v).leftChild : at(v).rightChild;
+    Handle kid = child;
+    if (kid == noHandle) return noHandle;
+
+    at(kid).parent = noHandle;
+    child = noHandle;
+
     return kid;
 }
 
-count ETForestCutSet::getHeight(ETForestCutSet::Node *v) {
-    if (v == nullptr) return 0;
-    return v->height;
+address ETForestCutSet::buildBalanced(const Handle *order, count num) {
+    if (num == 0) return noHandle;
+
+    //Halving the sequence keeps the heights of both subtrees within one of each other
+    count mid = num / 2;
+    Handle root = order[mid];
+    at(root).leftChild = buildBalanced(order, mid);
+    at(root).rightChild = buildBalanced(order + mid + 1, num - mid - 1);
+    if (at(root).leftChild != noHandle) at(at(root).leftChild).parent = root;
+    if (at(root).rightChild != noHandle) at(at(root).rightChild).parent = root;
+
+    refreshSubtreeInfo(root);
+    if (not noTracking) {
+        refreshTracking(root);
+        at(root).dirty = false;
+    }
+
+    return root;
 }
 
-count ETForestCutSet::getSize(ETForestCutSet::Node *v) {
-    if (v == nullptr) return 0;
-    return v->size;
+count ETForestCutSet::getHeight(Handle v) const {
+    if (v == noHandle) return 0;
+    return at(v).height;
 }
 
-ETForestCutSet::Node::Node(node pv, node pw, ETForestCutSet::Node::TrackingData pTrackingData) {
-    v = pv;
-    w = pw;
-    trackingData = std::move(pTrackingData);
+count ETForestCutSet::getSubtreeSize(Handle v) const {
+    if (v == noHandle) return 0;
+    return at(v).size;
 }
 
-void ETForestCutSet::checkTreeValidity(ETForestCutSet::Node *v) {
+void ETForestCutSet::checkTreeValidity([[maybe_unused]] Handle v) {
 #ifndef NDEBUG //This code is only executed in debug mode
-    //Check if size and height are calculated correctly
-    assert(v->height == (std::max(getHeight(v->leftChild), getHeight(v->rightChild)) + 1));
-    assert(v->size == (getSize(v->leftChild) + getSize(v->rightChild) + 1));
-
-    //Check if parents and children are fine
-    if(v->leftChild != nullptr) assert(v->leftChild->parent == v);
-    if(v->rightChild != nullptr) assert(v->rightChild->parent == v);
-
-    //Check if everything is balanced properly
-    assert(v->height - getHeight(v->leftChild) <= 2);
-    assert(v->height - getHeight(v->rightChild) <= 2);
-
-    //Check if tracking is done properly
-    assert(v->trackingData.ownData == nullptr || v->trackingData.ownData->size() == boostLevel);
-    assert(v->trackingData.accumulatedData.size() == boostLevel);
-    for(int i = 0; i < boostLevel; i++){
-        assert(v->trackingData.ownData == nullptr || (*v->trackingData.ownData)[i].size() == lognsqr);
-        assert(v->trackingData.accumulatedData[i].size() == lognsqr);
-        for(int j = 0; j < lognsqr; j++){
-            edge exp = (v->trackingData.ownData != nullptr) ? (*v->trackingData.ownData) [i][j] : noEdge;
-            if(v->leftChild != nullptr) exp ^= v->leftChild->trackingData.accumulatedData[i][j];
-            if(v->rightChild != nullptr) exp ^= v->rightChild->trackingData.accumulatedData[i][j];
-
-            assert(v->trackingData.accumulatedData[i][j] == exp);
+    //Walk the subtree in order, consecutive nodes of a tour have to share their vertex
+    std::vector<Handle> stack;
+    Handle prevInOrder = noHandle;
+    for (Handle u = v; u != noHandle || not stack.empty();) {
+        if (u != noHandle) {
+            stack.push_back(u);
+            u = at(u).leftChild;
+            continue;
+        }
+        u = stack.back();
+        stack.pop_back();
+
+        const Node &data = at(u);
+        //Check if size and height are calculated correctly
+        assert(data.size == (getSubtreeSize(data.leftChild) + getSubtreeSize(data.rightChild) + 1));
+
+        //Check if parents and children are fine
+        if(data.leftChild != noHandle) assert(at(data.leftChild).parent == u);
+        if(data.rightChild != noHandle) assert(at(data.rightChild).parent == u);
+
+        //Check if everything is balanced properly
+        if(balancing == ETBalancing::avl){
+            assert(data.height == (std::max(getHeight(data.leftChild), getHeight(data.rightChild)) + 1));
+            assert(data.height - getHeight(data.leftChild) <= 2);
+            assert(data.height - getHeight(data.rightChild) <= 2);
         }
-    }
 
-    //Check if everything is ordered
-    if(v->leftChild != nullptr){
-        Node* prevInOrder = v->leftChild;
-        while (prevInOrder->rightChild != nullptr) prevInOrder = prevInOrder->rightChild;
-        assert(prevInOrder->w == v->v);
-        checkTreeValidity(v->leftChild);
-    }
-    if(v->rightChild != nullptr){
-        Node* nextInOrder = v->rightChild;
-        while (nextInOrder->leftChild != nullptr) nextInOrder = nextInOrder->leftChild;
-        assert(v->w == nextInOrder->v);
-        checkTreeValidity(v->rightChild);
+        //Check if tracking is done properly, outdated sketches are only recombined once they are read
+        if(not noTracking && data.parent != noHandle && data.dirty) assert(at(data.parent).dirty);
+        if(not noTracking && not data.dirty){
+            const sketchWord *own = ownData[u];
+            for(count i = 0; i < sketchSize; i++){
+                sketchWord exp = (own != nullptr) ? own[i] : noSketchWord;
+                if(data.leftChild != noHandle) exp ^= accumulatedData[data.leftChild][i];
+                if(data.rightChild != noHandle) exp ^= accumulatedData[data.rightChild][i];
+
+                assert(accumulatedData[u][i] == exp);
+            }
+        }
+
+        //Check if everything is ordered
+        if(prevInOrder != noHandle) assert(at(prevInOrder).w == data.v);
+        prevInOrder = u;
+        u = data.rightChild;
     }
 #endif
 }
 
-void ETForestCutSet::writeTour(Node *root, std::vector<std::pair<node, node>> *path) {
-    if (root->leftChild != nullptr) writeTour(root->leftChild, path);
-    path->push_back({root->v, root->w});
-    if (root->rightChild != nullptr) writeTour(root->rightChild, path);
-}
\ No newline at end of file
+void ETForestCutSet::writeTour(Handle root, std::vector<std::pair<node, node>> *path) const {
+    //Splay trees can be deep, so this doesn't recurse
+    std::vector<Handle> stack;
+    for (Handle u = root; u != noHandle || not stack.empty();) {
+        if (u != noHandle) {
+            stack.push_back(u);
+            u = at(u).leftChild;
+            continue;
+        }
+        u = stack.back();
+        stack.pop_back();
+        path->push_back({at(u).v, at(u).w});
+        u = at(u).rightChild;
+    }
+}
@@ -1,100 +1,127 @@
 #include <cassert>
 #include <deque>
+#include <stdexcept>
 #include <utility>
 
 #include "ETForestHDT.hpp"
+#include "EulerTour.hpp"
 
 constexpr bool LEFT = true;
 constexpr bool RIGHT = false;
 
-addressHDT ETForestHDT::getRoot(ETForestHDT::Node *v) const {
-    if (v == nullptr) return nullptr;
-    while (v->parent != nullptr) v = v->parent;
-    return v;
+addressHDT ETForestHDT::allocateNode(node v, node w, bool onLevel, count nonTreeEdgesOnLevel) {
+    assert(v < noHandle && w < noHandle && nonTreeEdgesOnLevel < noHandle);
+
+    Handle e;
+    if (firstFree != noHandle) {
+        e = firstFree;
+        firstFree = nodes[e].parent;
+    } else {
+        //All levels share the array, so unlike a spanning forest it can outgrow the handles
+        if (nodes.size() >= noHandle) throw std::length_error("ETForestHDT: too many nodes for 32 bit handles");
+        e = nodes.size();
+        nodes.emplace_back();
+    }
+
+    nodes[e] = Node();
+    nodes[e].v = v;
+    nodes[e].w = w;
+    nodes[e].trackingData.own_isOnLevel = onLevel;
+    nodes[e].trackingData.own_numNonTreeEdgesOnLevel = nonTreeEdgesOnLevel;
+
+    return e;
 }
 
-const ETForestHDT::Node::TrackingData &ETForestHDT::getTrackingData(ETForestHDT::Node *edge) {
-    return edge->trackingData;
+addressHDT ETForestHDT::getRoot(Handle e) const {
+    if (e == noHandle) return noHandle;
+    while (nodes[e].parent != noHandle) e = nodes[e].parent;
+    return e;
 }
 
-void ETForestHDT::setEdgeOnLevel(ETForestHDT::Node *e, bool onLevel) {
-    e->trackingData.own_isOnLevel = onLevel;
+const TrackingDataHDT &ETForestHDT::getTrackingData(Handle edge) const {
+    return nodes[edge].trackingData;
+}
+
+void ETForestHDT::setEdgeOnLevel(Handle e, bool onLevel) {
+    nodes[e].trackingData.own_isOnLevel = onLevel;
     refreshTrackingDataUpwards(e);
 }
 
-void ETForestHDT::setEdgeNontreeEdges(ETForestHDT::Node *e, count nonTreeEdgesOnLevel) {
-    e->trackingData.own_numNonTreeEdgesOnLevel = nonTreeEdgesOnLevel;
+void ETForestHDT::setEdgeNontreeEdges(Handle e, count nonTreeEdgesOnLevel) {
+    assert(nonTreeEdgesOnLevel < noHandle);
+    nodes[e].trackingData.own_numNonTreeEdgesOnLevel = nonTreeEdgesOnLevel;
     refreshTrackingDataUpwards(e);
 }
 
-std::vector<std::pair<node, node>> ETForestHDT::getTour(ETForestHDT::Node *e) {
-    Node *root = getRoot(e);
-    Node *n = root;
+std::vector<std::pair<node, node>> ETForestHDT::getTour(Handle e) const {
+    Handle n = getRoot(e);
 
-    std::deque<Node *> stack;
+    std::deque<Handle> stack;
 
     std::vector<std::pair<node, node>> ret;
 
-    while ((not stack.empty()) || (n != nullptr)) {
-        if (n != nullptr) {
+    while ((not stack.empty()) || (n != noHandle)) {
+        if (n != noHandle) {
             stack.push_back(n);
-            n = n->leftChild;
+            n = nodes[n].leftChild;
         } else {
             n = stack.back();
             stack.pop_back();
-            ret.emplace_back(n->v, n->w);
-            n = n->rightChild;
+            ret.emplace_back(nodes[n].v, nodes[n].w);
+            n = nodes[n].rightChild;
         }
     }
 
     return ret;
 }
 
-edge ETForestHDT::getOnLevelTreeEdge(Node *e) {
-    assert(e != nullptr);
+edge ETForestHDT::getOnLevelTreeEdge(Handle e) const {
+    assert(e != noHandle);
     e = getRoot(e);
 
-    if (e->trackingData.accumulated_numTreeEdgesOnLevel == 0)
+    if (nodes[e].trackingData.accumulated_numTreeEdgesOnLevel == 0)
         return noEdge;
 
-    while (! e->trackingData.own_isOnLevel) {
-        if (e->leftChild != nullptr && e->leftChild->trackingData.accumulated_numTreeEdgesOnLevel != 0)
-            e = e->leftChild;
+    while (! nodes[e].trackingData.own_isOnLevel) {
+        Handle left = nodes[e].leftChild;
+        if (left != noHandle && nodes[left].trackingData.accumulated_numTreeEdgesOnLevel != 0)
+            e = left;
         else
-            e = e->rightChild;
+            e = nodes[e].rightChild;
     }
 
-    return {e->v, e->w};
+    return {nodes[e].v, nodes[e].w};
 }
 
-node ETForestHDT::getNodeWithOnLevelNontreeEdge(Node* e) {
-    assert(e != nullptr);
+node ETForestHDT::getNodeWithOnLevelNontreeEdge(Handle e) const {
+    assert(e != noHandle);
     e = getRoot(e);
 
-    if (e->trackingData.accumulated_numNonTreeEdgesOnLevel == 0)
+    if (nodes[e].trackingData.accumulated_numNonTreeEdgesOnLevel == 0)
         return none;
 
-    while (e->trackingData.own_numNonTreeEdgesOnLevel == 0) {
-        if (e->leftChild != nullptr && e->leftChild->trackingData.accumulated_numNonTreeEdgesOnLevel != 0)
-            e = e->leftChild;
+    while (nodes[e].trackingData.own_numNonTreeEdgesOnLevel == 0) {
+        Handle left = nodes[e].leftChild;
+        if (left != noHandle && nodes[left].trackingData.accumulated_numNonTreeEdgesOnLevel != 0)
+            e = left;
         else
-            e = e->rightChild;
+            e = nodes[e].rightChild;
     }
 
-    return e->v;
+    return nodes[e].v;
 }
 
-std::pair<addressHDT, addressHDT> ETForestHDT::insertETEdge(node v, node w, Node* vEdge, Node* wEdge, bool vOnLevel, bool wOnLevel,
-                                                      count vNonTreeEdgesOnLevel, count wNonTreeEdgesOnLevel) {
-    if (vEdge != nullptr) assert(getRoot(vEdge) != getRoot(wEdge));
+std::pair<addressHDT, addressHDT> ETForestHDT::insertETEdge(node v, node w, Handle vEdge, Handle wEdge, bool vOnLevel, bool wOnLevel,
+                                                            count vNonTreeEdgesOnLevel, count wNonTreeEdgesOnLevel) {
+    if (vEdge != noHandle) assert(getRoot(vEdge) != getRoot(wEdge));
 
-    Node *vTree = nullptr, *wTree = nullptr;
+    Handle vTree = noHandle, wTree = noHandle;
     //Ensure that the Eulertours start and end with v and w respectively
-    if (vEdge != nullptr) vTree = makeFront(vEdge);
-    if (wEdge != nullptr) wTree = makeFront(wEdge);
+    if (vEdge != noHandle) vTree = makeFront(vEdge);
+    if (wEdge != noHandle) wTree = makeFront(wEdge);
 
-    Node *vwEdge = new Node(v, w, {vOnLevel, vNonTreeEdgesOnLevel, 0, 0});
-    Node *wvEdge = new Node(w, v, {wOnLevel, wNonTreeEdgesOnLevel, 0, 0});
+    Handle vwEdge = allocateNode(v, w, vOnLevel, vNonTreeEdgesOnLevel);
+    Handle wvEdge = allocateNode(w, v, wOnLevel, wNonTreeEdgesOnLevel);
 
     //Join the Euler tours with the new edges
     vTree = join(vTree, wTree, vwEdge);
@@ -103,86 +130,116 @@ std::pair<addressHDT, addressHDT> ETForestHDT::insertETEdge(node v, node w, Node
     return {vwEdge, wvEdge};
 }
 
-void ETForestHDT::deleteETEdge(ETForestHDT::Node *edge, ETForestHDT::Node *backEdge) {
-    assert(edge != nullptr && backEdge != nullptr);
+std::vector<std::pair<addressHDT, addressHDT>> ETForestHDT::buildForest(std::span<const edge> edges, bool onLevel,
+                                                                       const std::vector<count> &nonTreeEdgesOnLevel) {
+    std::vector<count> tourStarts;
+    std::vector<count> tour = eulerTours(edges, tourStarts);
+
+    std::vector<std::pair<Handle, Handle>> newEdges(edges.size());
+    std::vector<Handle> order(tour.size());
+    for (count i = 0; i < tour.size(); i++) {
+        edge e = edges[tour[i] / 2];
+        if (tour[i] % 2 == 0) order[i] = newEdges[tour[i] / 2].first = allocateNode(e.v, e.w, onLevel, 0);
+        else order[i] = newEdges[tour[i] / 2].second = allocateNode(e.w, e.v, onLevel, 0);
+    }
+
+    std::vector<bool> attached(nonTreeEdgesOnLevel.size(), false);
+    for (count k = 0; k < edges.size(); k++) {
+        for (auto [v, e] : {std::pair(edges[k].v, newEdges[k].first), std::pair(edges[k].w, newEdges[k].second)}) {
+            if (attached[v]) continue;
+            attached[v] = true;
+            assert(nonTreeEdgesOnLevel[v] < noHandle);
+            nodes[e].trackingData.own_numNonTreeEdgesOnLevel = nonTreeEdgesOnLevel[v];
+        }
+    }
+
+    for (count t = 0; t + 1 < tourStarts.size(); t++) buildBalanced(order.data() + tourStarts[t], tourStarts[t + 1] - tourStarts[t]);
+
+    return newEdges;
+}
+
+void ETForestHDT::deleteETEdge(Handle edge, Handle backEdge) {
+    assert(edge != noHandle && backEdge != noHandle);
 
     //Rotate the edge to the front so the backedge is a clean cut
     makeFront(edge);
-    std::pair<Node *, Node *> splitTour = split(backEdge);
+    std::pair<Handle, Handle> splitTour = split(backEdge);
 
-    //Now we simply have to remove edge and backedge and delete them
-    std::pair<Node *, Node *> edgePair = trivialDelete(splitTour.first, true);
+    //Now we simply have to remove edge and backedge and free their nodes
+    [[maybe_unused]] std::pair<Handle, Handle> edgePair = trivialDelete(splitTour.first, true);
     assert(edgePair.first == edge);
-    delete edge;
-    std::pair<Node *, Node *> backEdgePair = trivialDelete(splitTour.second, true);
+    [[maybe_unused]] std::pair<Handle, Handle> backEdgePair = trivialDelete(splitTour.second, true);
     assert(backEdgePair.first == backEdge);
-    delete backEdge;
+
+    nodes[edge].parent = backEdge;
+    nodes[backEdge].parent = firstFree;
+    firstFree = edge;
 }
 
-addressHDT ETForestHDT::makeFront(ETForestHDT::Node *newFront) {
-    assert(newFront != nullptr);
-    std::pair<Node *, Node *> sequenceParts = split(newFront);
-    if (sequenceParts.first == nullptr) return sequenceParts.second;
+addressHDT ETForestHDT::makeFront(Handle newFront) {
+    assert(newFront != noHandle);
+    std::pair<Handle, Handle> sequenceParts = split(newFront);
+    if (sequenceParts.first == noHandle) return sequenceParts.second;
 
     //We wish to swap around the order of stuff, so we use the first node in the front path as the join node
-    std::pair<Node *, Node *> splitFirst = trivialDelete(sequenceParts.first, true);
+    std::pair<Handle, Handle> splitFirst = trivialDelete(sequenceParts.first, true);
     //Now we just glue together the two parts the other way around
-    Node *newTree = join(sequenceParts.second, splitFirst.second, splitFirst.first);
+    Handle newTree = join(sequenceParts.second, splitFirst.second, splitFirst.first);
 
     checkTreeValidity(newTree);
 
     return newTree;
 }
 
-std::pair<addressHDT, addressHDT> ETForestHDT::split(ETForestHDT::Node *v) {
-    assert(v != nullptr);
+std::pair<addressHDT, addressHDT> ETForestHDT::split(Handle v) {
+    assert(v != noHandle);
 
     //Get the starting trees
-    Node *leftTree = separateDirChild(v, true);
-    Node *rightTree = separateDirChild(v, false);
+    Handle leftTree = separateDirChild(v, LEFT);
+    Handle rightTree = separateDirChild(v, RIGHT);
 
     //Trivial case that this was it
-    if (v->parent == nullptr) {
-        if (rightTree != nullptr) rightTree = trivialInsert(v, rightTree, true);
+    if (nodes[v].parent == noHandle) {
+        if (rightTree != noHandle) rightTree = trivialInsert(v, rightTree, true);
         else {
             cleanNode(v);
             rightTree = v;
         }
 
-        if (leftTree != nullptr) checkTreeValidity(leftTree);
+        if (leftTree != noHandle) checkTreeValidity(leftTree);
         checkTreeValidity(rightTree);
 
         return {leftTree, rightTree};
     }
 
     //Other Case: Now we move up the tree and join all the left/right subtrees
-    Node *pos = v->parent;
-    Node *parent;
-    Node *joinTree;
+    Handle pos = nodes[v].parent;
+    Handle parent;
+    Handle joinTree;
     bool left, nextLeft;
 
     //Cut off v from its parent
-    if (pos->leftChild == v) {
-        pos->leftChild = nullptr;
+    if (nodes[pos].leftChild == v) {
+        nodes[pos].leftChild = noHandle;
         left = false;
     } else {
-        pos->rightChild = nullptr;
+        nodes[pos].rightChild = noHandle;
         left = true;
     }
-    rightTree = join(nullptr, rightTree, v);
+    rightTree = join(noHandle, rightTree, v);
 
-    while (pos != nullptr) {
-        parent = pos->parent;
+    while (pos != noHandle) {
+        parent = nodes[pos].parent;
         //Cut off pos from parent
-        if (parent != nullptr) {
-            if (parent->leftChild == pos) {
-                parent->leftChild = nullptr;
+        if (parent != noHandle) {
+            if (nodes[parent].leftChild == pos) {
+                nodes[parent].leftChild = noHandle;
                 nextLeft = false;
             } else {
-                parent->rightChild = nullptr;
+                nodes[parent].rightChild = noHandle;
                 nextLeft = true;
             }
-            pos->parent = nullptr;
+            nodes[pos].parent = noHandle;
         }
 
         //Get the tree we want to join in
@@ -203,23 +260,24 @@ std::pair<addressHDT, addressHDT> ETForestHDT::split(ETForestHDT::Node *v) {
     return {leftTree, rightTree};
 }
 
-addressHDT ETForestHDT::join(ETForestHDT::Node *leftTree, ETForestHDT::Node *rightTree, ETForestHDT::Node *joinNode) {
-    assert(joinNode != nullptr);
+addressHDT ETForestHDT::join(Handle leftTree, Handle rightTree, Handle joinNode) {
+    assert(joinNode != noHandle);
     assert(leftTree != joinNode && joinNode != rightTree);
-    if (leftTree != nullptr) assert(leftTree != rightTree);
-    if (leftTree != nullptr) assert(leftTree->parent == nullptr);
-    if (rightTree != nullptr) assert(rightTree->parent == nullptr);
+    if (leftTree != noHandle) assert(leftTree != rightTree);
+    if (leftTree != noHandle) assert(nodes[leftTree].parent == noHandle);
+    if (rightTree != noHandle) assert(nodes[rightTree].parent == noHandle);
     cleanNode(joinNode);
-    if (leftTree == nullptr && rightTree == nullptr) return joinNode;
-    if (leftTree == nullptr) return trivialInsert(joinNode, rightTree, true);
-    if (rightTree == nullptr) return trivialInsert(joinNode, leftTree, false);
+    if (leftTree == noHandle && rightTree == noHandle) return joinNode;
+    if (leftTree == noHandle) return trivialInsert(joinNode, rightTree, true);
+    if (rightTree == noHandle) return trivialInsert(joinNode, leftTree, false);
 
     //Trivial case that both are roughly equal in height
-    if (leftTree->height <= rightTree->height + 1 && rightTree->height <= leftTree->height + 1) {
-        joinNode->leftChild = leftTree;
-        joinNode->rightChild = rightTree;
-        leftTree->parent = joinNode;
-        rightTree->parent = joinNode;
+    count leftHeight = nodes[leftTree].height, rightHeight = nodes[rightTree].height;
+    if (leftHeight <= rightHeight + 1 && rightHeight <= leftHeight + 1) {
+        nodes[joinNode].leftChild = leftTree;
+        nodes[joinNode].rightChild = rightTree;
+        nodes[leftTree].parent = joinNode;
+        nodes[rightTree].parent = joinNode;
 
         refreshSubtreeInfo(joinNode);
 
@@ -228,36 +286,36 @@ addressHDT ETForestHDT::join(ETForestHDT::Node *leftTree, ETForestHDT::Node *rig
         return joinNode;
     }
 
-    Node *pos;
+    Handle pos;
 
     //Case of a left join
-    if (leftTree->height > rightTree->height) {
+    if (leftHeight > rightHeight) {
         pos = leftTree;
-        while (getHeight(pos->rightChild) > rightTree->height) pos = pos->rightChild;
+        while (getHeight(nodes[pos].rightChild) > rightHeight) pos = nodes[pos].rightChild;
         //Now the right child of pos is equal or 1 smaller then right tree
-        Node *smallTree = separateDirChild(pos, false);
+        Handle smallTree = separateDirChild(pos, RIGHT);
 
-        joinNode->leftChild = smallTree;
-        if (smallTree != nullptr) smallTree->parent = joinNode;
-        joinNode->rightChild = rightTree;
-        rightTree->parent = joinNode;
+        nodes[joinNode].leftChild = smallTree;
+        if (smallTree != noHandle) nodes[smallTree].parent = joinNode;
+        nodes[joinNode].rightChild = rightTree;
+        nodes[rightTree].parent = joinNode;
         refreshSubtreeInfo(joinNode);
-        pos->rightChild = joinNode;
-        joinNode->parent = pos;
+        nodes[pos].rightChild = joinNode;
+        nodes[joinNode].parent = pos;
         pos = rebalance(pos);
     } else {
         pos = rightTree;
-        while (getHeight(pos->leftChild) > leftTree->height) pos = pos->leftChild;
-        //Now the right child of pos is equal or 1 smaller then right tree
-        Node *smallTree = separateDirChild(pos, true);
-
-        joinNode->rightChild = smallTree;
-        if (smallTree != nullptr) smallTree->parent = joinNode;
-        joinNode->leftChild = leftTree;
-        leftTree->parent = joinNode;
+        while (getHeight(nodes[pos].leftChild) > leftHeight) pos = nodes[pos].leftChild;
+        //Now the left child of pos is equal or 1 smaller then left tree
+        Handle smallTree = separateDirChild(pos, LEFT);
+
+        nodes[joinNode].rightChild = smallTree;
+        if (smallTree != noHandle) nodes[smallTree].parent = joinNode;
+        nodes[joinNode].leftChild = leftTree;
+        nodes[leftTree].parent = joinNode;
         refreshSubtreeInfo(joinNode);
-        pos->leftChild = joinNode;
-        joinNode->parent = pos;
+        nodes[pos].leftChild = joinNode;
+        nodes[joinNode].parent = pos;
         pos = rebalance(pos);
     }
 
@@ -266,22 +324,22 @@ addressHDT ETForestHDT::join(ETForestHDT::Node *leftTree, ETForestHDT::Node *rig
     return pos;
 }
 
-addressHDT ETForestHDT::trivialInsert(Node *newNode, ETForestHDT::Node *root, bool first) {
-    assert(root != nullptr);
-    assert(newNode != nullptr);
+addressHDT ETForestHDT::trivialInsert(Handle newNode, Handle root, bool first) {
+    assert(root != noHandle);
+    assert(newNode != noHandle);
     cleanNode(newNode);
-    //Step 1: Move down until we find the place where the new pair belongs
-    Node *pos = root;
+    //Move down until we find the place where the new node belongs
+    Handle pos = root;
 
     if (first) {
-        while (pos->leftChild != nullptr) pos = pos->leftChild;
-        pos->leftChild = newNode;
+        while (nodes[pos].leftChild != noHandle) pos = nodes[pos].leftChild;
+        nodes[pos].leftChild = newNode;
     } else {
-        while (pos->rightChild != nullptr) pos = pos->rightChild;
-        pos->rightChild = newNode;
+        while (nodes[pos].rightChild != noHandle) pos = nodes[pos].rightChild;
+        nodes[pos].rightChild = newNode;
     }
 
-    newNode->parent = pos;
+    nodes[newNode].parent = pos;
 
     pos = rebalance(pos);
 
@@ -290,73 +348,54 @@ addressHDT ETForestHDT::trivialInsert(Node *newNode, ETForestHDT::Node *root, bo
     return pos;
 }
 
-std::pair<addressHDT, addressHDT> ETForestHDT::trivialDelete(ETForestHDT::Node *root, bool first) {
-    assert(root != nullptr);
+std::pair<addressHDT, addressHDT> ETForestHDT::trivialDelete(Handle root, bool first) {
+    assert(root != noHandle);
 
-    Node *u = root;
+    Handle u = root;
 
     //Locating the relevant node
     if (first) {
-        while (u->leftChild != nullptr) u = u->leftChild;
+        while (nodes[u].leftChild != noHandle) u = nodes[u].leftChild;
     } else {
-        while (u->rightChild != nullptr) u = u->rightChild;
+        while (nodes[u].rightChild != noHandle) u = nodes[u].rightChild;
     }
 
     //u has at most 1 child
-    Node *parent = u->parent;
-    if (u->leftChild == nullptr && u->rightChild == nullptr) {
-        if (parent != nullptr) {
-            if (parent->leftChild == u) parent->leftChild = nullptr;
-            else parent->rightChild = nullptr;
-            root = rebalance(parent);
-        } else root = nullptr;
-    } else if (u->leftChild != nullptr) {
-        if (parent != nullptr) {
-            if (parent->leftChild == u) parent->leftChild = u->leftChild;
-            else parent->rightChild = u->leftChild;
-            u->leftChild->parent = parent;
-            root = rebalance(parent);
-        } else {
-            u->leftChild->parent = nullptr;
-            root = u->leftChild;
-        }
-    } else if (u->rightChild != nullptr) {
-        if (parent != nullptr) {
-            if (parent->leftChild == u) parent->leftChild = u->rightChild;
-            else parent->rightChild = u->rightChild;
-            u->rightChild->parent = parent;
-            root = rebalance(parent);
-        } else {
-            u->rightChild->parent = nullptr;
-            root = u->rightChild;
-        }
-    }
+    Handle parent = nodes[u].parent;
+    Handle child = (nodes[u].leftChild != noHandle) ? nodes[u].leftChild : nodes[u].rightChild;
+    if (child != noHandle) nodes[child].parent = parent;
+    if (parent != noHandle) {
+        if (nodes[parent].leftChild == u) nodes[parent].leftChild = child;
+        else nodes[parent].rightChild = child;
+        root = rebalance(parent);
+    } else root = child;
 
     cleanNode(u);
 
-    if (root != nullptr) checkTreeValidity(root);
+    if (root != noHandle) checkTreeValidity(root);
 
     return {u, root};
 }
 
-addressHDT ETForestHDT::rebalance(addressHDT start) {
-    Node *prev = start;
-    while (start != nullptr) {
+addressHDT ETForestHDT::rebalance(Handle start) {
+    Handle prev = start;
+    while (start != noHandle) {
         prev = start;
-        start = start->parent;
+        start = nodes[start].parent;
         refreshSubtreeInfo(prev);
-        if (getHeight(prev->leftChild) > getHeight(prev->rightChild) + 1) {
+        Handle left = nodes[prev].leftChild, right = nodes[prev].rightChild;
+        if (getHeight(left) > getHeight(right) + 1) {
             //Right rotation necessary
-            if (getHeight(prev->leftChild->rightChild) > getHeight(prev->leftChild->leftChild)) {
+            if (getHeight(nodes[left].rightChild) > getHeight(nodes[left].leftChild)) {
                 //Left-Right-Rotation necessary
-                rotate(prev->leftChild, LEFT);
+                rotate(left, LEFT);
             }
             prev = rotate(prev, RIGHT);
-        } else if (getHeight(prev->rightChild) > getHeight(prev->leftChild) + 1) {
-            //Right rotation necessary
-            if (getHeight(prev->rightChild->leftChild) > getHeight(prev->rightChild->rightChild)) {
-                //Left-Right-Rotation necessary
-                rotate(prev->rightChild, RIGHT);
+        } else if (getHeight(right) > getHeight(left) + 1) {
+            //Left rotation necessary
+            if (getHeight(nodes[right].leftChild) > getHeight(nodes[right].rightChild)) {
+                //Right-Left-Rotation necessary
+                rotate(right, RIGHT);
             }
             prev = rotate(prev, LEFT);
         }
@@ -365,170 +404,160 @@ addressHDT ETForestHDT::rebalance(addressHDT start) {
     return prev;
 }
 
-addressHDT ETForestHDT::rotate(ETForestHDT::Node *head, bool left) {
-    Node *parent = head->parent;
-    Node *kid;
+addressHDT ETForestHDT::rotate(Handle head, bool left) {
+    Handle parent = nodes[head].parent;
+    Handle kid;
 
     //Standard rotate of AVL-Trees
     if (left) {
-        assert(head->rightChild != nullptr);
-        //assert(head->rightChild->rightChild != nullptr);
+        assert(nodes[head].rightChild != noHandle);
         kid = separateDirChild(head, RIGHT);
-        Node *innerGrandKid = separateDirChild(kid, LEFT);
-        kid->leftChild = head;
-        head->parent = kid;
-        head->rightChild = innerGrandKid;
-        if (innerGrandKid != nullptr) innerGrandKid->parent = head;
+        Handle innerGrandKid = separateDirChild(kid, LEFT);
+        nodes[kid].leftChild = head;
+        nodes[head].parent = kid;
+        nodes[head].rightChild = innerGrandKid;
+        if (innerGrandKid != noHandle) nodes[innerGrandKid].parent = head;
     } else {
-        assert(head->leftChild != nullptr);
-        //assert(head->leftChild->leftChild != nullptr);
+        assert(nodes[head].leftChild != noHandle);
         kid = separateDirChild(head, LEFT);
-        Node *innerGrandKid = separateDirChild(kid, RIGHT);
-        kid->rightChild = head;
-        head->parent = kid;
-        head->leftChild = innerGrandKid;
-        if (innerGrandKid != nullptr) innerGrandKid->parent = head;
+        Handle innerGrandKid = separateDirChild(kid, RIGHT);
+        nodes[kid].rightChild = head;
+        nodes[head].parent = kid;
+        nodes[head].leftChild = innerGrandKid;
+        if (innerGrandKid != noHandle) nodes[innerGrandKid].parent = head;
     }
 
     refreshSubtreeInfo(head);
     refreshSubtreeInfo(kid);
 
     //Fix connection to parents
-    kid->parent = parent;
+    nodes[kid].parent = parent;
 
-    if (parent != nullptr) {
-        if (parent->leftChild == head) parent->leftChild = kid;
-        else parent->rightChild = kid;
+    if (parent != noHandle) {
+        if (nodes[parent].leftChild == head) nodes[parent].leftChild = kid;
+        else nodes[parent].rightChild = kid;
     }
 
     return kid;
 }
 
-void ETForestHDT::cleanNode(ETForestHDT::Node *v) {
-    v->parent = nullptr;
-    v->leftChild = nullptr;
-    v->rightChild = nullptr;
-    v->height = 1;
-    v->size = 1;
+void ETForestHDT::cleanNode(Handle v) {
+    Node &data = nodes[v];
+    data.parent = noHandle;
+    data.leftChild = noHandle;
+    data.rightChild = noHandle;
+    data.height = 1;
+    data.size = 1;
     refreshTracking(v);
 }
 
-void ETForestHDT::refreshSubtreeInfo(ETForestHDT::Node *v) {
-    v->size = 1;
-    v->height = 1;
-    if (v->leftChild != nullptr) {
-        v->size += v->leftChild->size;
-        v->height = v->leftChild->height + 1;
-    }
-    if (v->rightChild != nullptr) {
-        v->size += v->rightChild->size;
-        v->height = std::max(v->height, v->rightChild->height + 1);
-    }
+void ETForestHDT::refreshSubtreeInfo(Handle v) {
+    Node &data = nodes[v];
+    data.size = 1 + getSubtreeSize(data.leftChild) + getSubtreeSize(data.rightChild);
+    data.height = std::max(getHeight(data.leftChild), getHeight(data.rightChild)) + 1;
 
     refreshTracking(v);
 }
 
-void ETForestHDT::refreshTrackingDataUpwards(ETForestHDT::Node *v) {
-    while (v != nullptr) {
+void ETForestHDT::refreshTrackingDataUpwards(Handle v) {
+    while (v != noHandle) {
         refreshTracking(v);
-        v = v->parent;
+        v = nodes[v].parent;
     }
 }
 
-void ETForestHDT::refreshTracking(ETForestHDT::Node *v) {
-    v->trackingData.accumulated_numTreeEdgesOnLevel = v->trackingData.own_isOnLevel ? 1 : 0;
-    v->trackingData.accumulated_numNonTreeEdgesOnLevel = v->trackingData.own_numNonTreeEdgesOnLevel;
-
-    if (v->leftChild != nullptr) {
-        v->trackingData.accumulated_numTreeEdgesOnLevel += v->leftChild->trackingData.accumulated_numTreeEdgesOnLevel;
-        v->trackingData.accumulated_numNonTreeEdgesOnLevel += v->leftChild->trackingData.accumulated_numNonTreeEdgesOnLevel;
-    }
+void ETForestHDT::refreshTracking(Handle v) {
+    TrackingData &data = nodes[v].trackingData;
+    data.accumulated_numTreeEdgesOnLevel = data.own_isOnLevel ? 1 : 0;
+    data.accumulated_numNonTreeEdgesOnLevel = data.own_numNonTreeEdgesOnLevel;
 
-    if (v->rightChild != nullptr) {
-        v->trackingData.accumulated_numTreeEdgesOnLevel += v->rightChild->trackingData.accumulated_numTreeEdgesOnLevel;
-        v->trackingData.accumulated_numNonTreeEdgesOnLevel += v->rightChild->trackingData.accumulated_numNonTreeEdgesOnLevel;
+    for (Handle child : {nodes[v].leftChild, nodes[v].rightChild}) {
+        if (child == noHandle) continue;
+        data.accumulated_numTreeEdgesOnLevel += nodes[child].trackingData.accumulated_numTreeEdgesOnLevel;
+        data.accumulated_numNonTreeEdgesOnLevel += nodes[child].trackingData.accumulated_numNonTreeEdgesOnLevel;
     }
 }
 
-addressHDT ETForestHDT::separateDirChild(ETForestHDT::Node *v, bool left) {
-    Node *kid;
-    if (left) {
-        if (v->leftChild == nullptr) return nullptr;
-        kid = v->leftChild;
-        kid->parent = nullptr;
-        v->leftChild = nullptr;
-    } else {
-        if (v->rightChild == nullptr) return nullptr;
-        kid = v->rightChild;
-        kid->parent = nullptr;
-        v->rightChild = nullptr;
-    }
+addressHDT ETForestHDT::separateDirChild(Handle v, bool left) {
+    Handle &child = left ? nodes[v].leftChild : nodes[v].rightChild;
+    Handle kid = child;
+    if (kid == noHandle) return noHandle;
+
+    nodes[kid].parent = noHandle;
+    child = noHandle;
 
     return kid;
 }
 
-count ETForestHDT::getHeight(ETForestHDT::Node *v) {
-    if (v == nullptr) return 0;
-    return v->height;
+addressHDT ETForestHDT::buildBalanced(const Handle *order, count num) {
+    if (num == 0) return noHandle;
+
+    //Halving the sequence keeps the heights of both subtrees within one of each other
+    count mid = num / 2;
+    Handle root = order[mid];
+    nodes[root].leftChild = buildBalanced(order, mid);
+    nodes[root].rightChild = buildBalanced(order + mid + 1, num - mid - 1);
+    if (nodes[root].leftChild != noHandle) nodes[nodes[root].leftChild].parent = root;
+    if (nodes[root].rightChild != noHandle) nodes[nodes[root].rightChild].parent = root;
+
+    refreshSubtreeInfo(root);
+    return root;
 }
 
-count ETForestHDT::getSize(ETForestHDT::Node *v) {
-    if (v == nullptr) return 0;
-    return v->size;
+count ETForestHDT::getHeight(Handle v) const {
+    if (v == noHandle) return 0;
+    return nodes[v].height;
 }
 
-ETForestHDT::Node::Node(node pv, node pw, ETForestHDT::Node::TrackingData pTrackingData) {
-    v = pv;
-    w = pw;
-    trackingData = pTrackingData;
+count ETForestHDT::getSubtreeSize(Handle v) const {
+    if (v == noHandle) return 0;
+    return nodes[v].size;
 }
 
-void ETForestHDT::checkTreeValidity(ETForestHDT::Node *v) {
+void ETForestHDT::checkTreeValidity([[maybe_unused]] Handle v) {
 #ifndef NDEBUG //This code is only executed in debug mode
+    const Node &data = nodes[v];
     //Check if size and height are calculated correctly
-    assert(v->height == (std::max(getHeight(v->leftChild), getHeight(v->rightChild)) + 1));
-    assert(v->size == (getSize(v->leftChild) + getSize(v->rightChild) + 1));
+    assert(data.height == (std::max(getHeight(data.leftChild), getHeight(data.rightChild)) + 1));
+    assert(data.size == (getSubtreeSize(data.leftChild) + getSubtreeSize(data.rightChild) + 1));
 
     //Check if parents and children are fine
-    if(v->leftChild != nullptr) assert(v->leftChild->parent == v);
-    if(v->rightChild != nullptr) assert(v->rightChild->parent == v);
+    if(data.leftChild != noHandle) assert(nodes[data.leftChild].parent == v);
+    if(data.rightChild != noHandle) assert(nodes[data.rightChild].parent == v);
 
     //Check if everything is balanced properly
-    assert(v->height - getHeight(v->leftChild) <= 2);
-    assert(v->height - getHeight(v->rightChild) <= 2);
+    assert(data.height - getHeight(data.leftChild) <= 2);
+    assert(data.height - getHeight(data.rightChild) <= 2);
 
     //Check if tracking is done properly
-    count expTreeEdges = v->trackingData.own_isOnLevel ? 1 : 0;
-    count expNonTreeEdges = v->trackingData.own_numNonTreeEdgesOnLevel;
-    if (v->leftChild != nullptr) {
-        expTreeEdges += v->leftChild->trackingData.accumulated_numTreeEdgesOnLevel;
-        expNonTreeEdges += v->leftChild->trackingData.accumulated_numNonTreeEdgesOnLevel;
+    count expTreeEdges = data.trackingData.own_isOnLevel ? 1 : 0;
+    count expNonTreeEdges = data.trackingData.own_numNonTreeEdgesOnLevel;
+    for (Handle child : {data.leftChild, data.rightChild}) {
+        if (child == noHandle) continue;
+        expTreeEdges += nodes[child].trackingData.accumulated_numTreeEdgesOnLevel;
+        expNonTreeEdges += nodes[child].trackingData.accumulated_numNonTreeEdgesOnLevel;
     }
-    if (v->rightChild != nullptr) {
-        expTreeEdges += v->rightChild->trackingData.accumulated_numTreeEdgesOnLevel;
-        expNonTreeEdges += v->rightChild->trackingData.accumulated_numNonTreeEdgesOnLevel;
-    }
-    assert(v->trackingData.accumulated_numTreeEdgesOnLevel == expTreeEdges);
-    assert(v->trackingData.accumulated_numNonTreeEdgesOnLevel == expNonTreeEdges);
+    assert(data.trackingData.accumulated_numTreeEdgesOnLevel == expTreeEdges);
+    assert(data.trackingData.accumulated_numNonTreeEdgesOnLevel == expNonTreeEdges);
 
     //Check if everything is ordered
-    if(v->leftChild != nullptr){
-        Node* prevInOrder = v->leftChild;
-        while (prevInOrder->rightChild != nullptr) prevInOrder = prevInOrder->rightChild;
-        assert(prevInOrder->w == v->v);
-        checkTreeValidity(v->leftChild);
+    if(data.leftChild != noHandle){
+        Handle prevInOrder = data.leftChild;
+        while (nodes[prevInOrder].rightChild != noHandle) prevInOrder = nodes[prevInOrder].rightChild;
+        assert(nodes[prevInOrder].w == data.v);
+        checkTreeValidity(data.leftChild);
     }
-    if(v->rightChild != nullptr){
-        Node* nextInOrder = v->rightChild;
-        while (nextInOrder->leftChild != nullptr) nextInOrder = nextInOrder->leftChild;
-        assert(v->w == nextInOrder->v);
-        checkTreeValidity(v->rightChild);
+    if(data.rightChild != noHandle){
+        Handle nextInOrder = data.rightChild;
+        while (nodes[nextInOrder].leftChild != noHandle) nextInOrder = nodes[nextInOrder].leftChild;
+        assert(data.w == nodes[nextInOrder].v);
+        checkTreeValidity(data.rightChild);
     }
 #endif
 }
 
-void ETForestHDT::writeTour(Node *root, std::vector<std::pair<node, node>> *path) {
-    if (root->leftChild != nullptr) writeTour(root->leftChild, path);
-    path->push_back({root->v, root->w});
-    if (root->rightChild != nullptr) writeTour(root->rightChild, path);
-}
\ No newline at end of file
+void ETForestHDT::writeTour(Handle root, std::vector<std::pair<node, node>> *path) const {
+    if (nodes[root].leftChild != noHandle) writeTour(nodes[root].leftChild, path);
+    path->push_back({nodes[root].v, nodes[root].w});
+    if (nodes[root].rightChild != noHandle) writeTour(nodes[root].rightChild, path);
+}
@@ -0,0 +1,469 @@
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <stdexcept>
+#include <utility>
+
+#include "ETForestQuery.hpp"
+#include "EulerTour.hpp"
+
+constexpr bool LEFT = true;
+constexpr bool RIGHT = false;
+
+ETForestQuery::ETForestQuery(count n) {
+    //A spanning forest has at most 2 * (n - 1) nodes
+    maxNodes = (n > 1) ? 2 * (n - 1) : 0;
+    if (maxNodes >= noHandle) throw std::length_error("ETForestQuery: too many nodes for 32 bit handles");
+}
+
+addressQuery ETForestQuery::getRoot(Handle e) const {
+    if (e == noHandle) return noHandle;
+    while (at(e).parent != noHandle) e = at(e).parent;
+    return e;
+}
+
+std::vector<std::pair<node, node>> ETForestQuery::getTour(Handle e) const {
+    Handle n = getRoot(e);
+
+    std::deque<Handle> stack;
+
+    std::vector<std::pair<node, node>> ret;
+
+    while ((not stack.empty()) || (n != noHandle)) {
+        if (n != noHandle) {
+            stack.push_back(n);
+            n = at(n).leftChild;
+        } else {
+            n = stack.back();
+            stack.pop_back();
+            ret.emplace_back(at(n).v, at(n).w);
+            n = at(n).rightChild;
+        }
+    }
+
+    return ret;
+}
+
+std::pair<addressQuery, addressQuery> ETForestQuery::insertETEdge(node v, node w, Handle vEdge, Handle wEdge) {
+    if (vEdge != noHandle) assert(getRoot(vEdge) != getRoot(wEdge));
+
+    Handle vTree = noHandle, wTree = noHandle;
+    //Ensure that the Eulertours start and end with v and w respectively
+    if (vEdge != noHandle) vTree = makeFront(vEdge);
+    if (wEdge != noHandle) wTree = makeFront(wEdge);
+
+    Handle vwEdge = allocateNode(v, w);
+    Handle wvEdge = allocateNode(w, v);
+
+    //Join the Euler tours with the new edges
+    vTree = join(vTree, wTree, vwEdge);
+    trivialInsert(wvEdge, vTree, false);
+
+    return {vwEdge, wvEdge};
+}
+
+std::vector<std::pair<addressQuery, addressQuery>> ETForestQuery::buildForest(std::span<const edge> edges) {
+    assert(nodes.empty());
+    std::vector<count> tourStarts;
+    std::vector<count> tour = eulerTours(edges, tourStarts);
+
+    std::vector<std::pair<Handle, Handle>> newEdges(edges.size());
+    std::vector<Handle> order(tour.size());
+    for (count i = 0; i < tour.size(); i++) {
+        edge e = edges[tour[i] / 2];
+        if (tour[i] % 2 == 0) order[i] = newEdges[tour[i] / 2].first = allocateNode(e.v, e.w);
+        else order[i] = newEdges[tour[i] / 2].second = allocateNode(e.w, e.v);
+    }
+
+    for (count t = 0; t + 1 < tourStarts.size(); t++) buildBalanced(order.data() + tourStarts[t], tourStarts[t + 1] - tourStarts[t]);
+
+    return newEdges;
+}
+
+void ETForestQuery::deleteETEdge(Handle edge, Handle backEdge) {
+    assert(edge != noHandle && backEdge != noHandle);
+
+    //Rotate the edge to the front so the backedge is a clean cut
+    makeFront(edge);
+    std::pair<Handle, Handle> splitTour = split(backEdge);
+
+    //Now we simply have to remove edge and backedge and free their nodes
+    [[maybe_unused]] std::pair<Handle, Handle> edgePair = trivialDelete(splitTour.first, true);
+    assert(edgePair.first == edge);
+    [[maybe_unused]] std::pair<Handle, Handle> backEdgePair = trivialDelete(splitTour.second, true);
+    assert(backEdgePair.first == backEdge);
+
+    at(edge).parent = backEdge;
+    at(backEdge).parent = firstFree;
+    firstFree = edge;
+}
+
+addressQuery ETForestQuery::allocateNode(node v, node w) {
+    assert(v < noHandle && w < noHandle);
+
+    Handle e;
+    if (firstFree != noHandle) {
+        e = firstFree;
+        firstFree = at(e).parent;
+    } else {
+        //The array is allocated in one go once the first edge arrives, so it never has to move or grow beyond a spanning forest
+        if (nodes.capacity() == 0) nodes.reserve(maxNodes);
+        //Callers that insert more edges than a spanning forest has would otherwise wrap around into noHandle
+        if (nodes.size() >= noHandle) throw std::length_error("ETForestQuery: too many nodes for 32 bit handles");
+        e = nodes.size();
+        nodes.emplace_back();
+    }
+
+    at(e) = Node();
+    at(e).v = v;
+    at(e).w = w;
+
+    return e;
+}
+
+addressQuery ETForestQuery::makeFront(Handle newFront) {
+    assert(newFront != noHandle);
+    std::pair<Handle, Handle> sequenceParts = split(newFront);
+    if (sequenceParts.first == noHandle) return sequenceParts.second;
+
+    //We wish to swap around the order of stuff, so we use the first node in the front path as the join node
+    std::pair<Handle, Handle> splitFirst = trivialDelete(sequenceParts.first, true);
+    //Now we just glue together the two parts the other way around
+    Handle newTree = join(sequenceParts.second, splitFirst.second, splitFirst.first);
+
+    checkTreeValidity(newTree);
+
+    return newTree;
+}
+
+std::pair<addressQuery, addressQuery> ETForestQuery::split(Handle v) {
+    assert(v != noHandle);
+
+    //Get the starting trees
+    Handle leftTree = separateDirChild(v, LEFT);
+    Handle rightTree = separateDirChild(v, RIGHT);
+
+    //Trivial case that this was it
+    if (at(v).parent == noHandle) {
+        if (rightTree != noHandle) rightTree = trivialInsert(v, rightTree, true);
+        else {
+            cleanNode(v);
+            rightTree = v;
+        }
+
+        if (leftTree != noHandle) checkTreeValidity(leftTree);
+        checkTreeValidity(rightTree);
+
+        return {leftTree, rightTree};
+    }
+
+    //Other Case: Now we move up the tree and join all the left/right subtrees
+    Handle pos = at(v).parent;
+    Handle parent;
+    Handle joinTree;
+    bool left, nextLeft;
+
+    //Cut off v from its parent
+    if (at(pos).leftChild == v) {
+        at(pos).leftChild = noHandle;
+        left = false;
+    } else {
+        at(pos).rightChild = noHandle;
+        left = true;
+    }
+    rightTree = join(noHandle, rightTree, v);
+
+    while (pos != noHandle) {
+        parent = at(pos).parent;
+        //Cut off pos from parent
+        if (parent != noHandle) {
+            if (at(parent).leftChild == pos) {
+                at(parent).leftChild = noHandle;
+                nextLeft = false;
+            } else {
+                at(parent).rightChild = noHandle;
+                nextLeft = true;
+            }
+            at(pos).parent = noHandle;
+        }
+
+        //Get the tree we want to join in
+        joinTree = separateDirChild(pos, left);
+
+        if (left) {
+            leftTree = join(joinTree, leftTree, pos);
+            checkTreeValidity(leftTree);
+        } else {
+            rightTree = join(rightTree, joinTree, pos);
+            checkTreeValidity(rightTree);
+        }
+
+        pos = parent;
+        left = nextLeft;
+    }
+
+    return {leftTree, rightTree};
+}
+
+addressQuery ETForestQuery::join(Handle leftTree, Handle rightTree, Handle joinNode) {
+    assert(joinNode != noHandle);
+    assert(leftTree != joinNode && joinNode != rightTree);
+    if (leftTree != noHandle) assert(leftTree != rightTree);
+    if (leftTree != noHandle) assert(at(leftTree).parent == noHandle);
+    if (rightTree != noHandle) assert(at(rightTree).parent == noHandle);
+    cleanNode(joinNode);
+    if (leftTree == noHandle && rightTree == noHandle) return joinNode;
+    if (leftTree == noHandle) return trivialInsert(joinNode, rightTree, true);
+    if (rightTree == noHandle) return trivialInsert(joinNode, leftTree, false);
+
+    //Trivial case that both are roughly equal in height
+    count leftHeight = at(leftTree).height, rightHeight = at(rightTree).height;
+    if (leftHeight <= rightHeight + 1 && rightHeight <= leftHeight + 1) {
+        at(joinNode).leftChild = leftTree;
+        at(joinNode).rightChild = rightTree;
+        at(leftTree).parent = joinNode;
+        at(rightTree).parent = joinNode;
+
+        refreshSubtreeInfo(joinNode);
+
+        checkTreeValidity(joinNode);
+
+        return joinNode;
+    }
+
+    Handle pos;
+
+    //Case of a left join
+    if (leftHeight > rightHeight) {
+        pos = leftTree;
+        while (getHeight(at(pos).rightChild) > rightHeight) pos = at(pos).rightChild;
+        //Now the right child of pos is equal or 1 smaller then right tree
+        Handle smallTree = separateDirChild(pos, RIGHT);
+
+        at(joinNode).leftChild = smallTree;
+        if (smallTree != noHandle) at(smallTree).parent = joinNode;
+        at(joinNode).rightChild = rightTree;
+        at(rightTree).parent = joinNode;
+        refreshSubtreeInfo(joinNode);
+        at(pos).rightChild = joinNode;
+        at(joinNode).parent = pos;
+        pos = rebalance(pos);
+    } else {
+        pos = rightTree;
+        while (getHeight(at(pos).leftChild) > leftHeight) pos = at(pos).leftChild;
+        //Now the left child of pos is equal or 1 smaller then left tree
+        Handle smallTree = separateDirChild(pos, LEFT);
+
+        at(joinNode).rightChild = smallTree;
+        if (smallTree != noHandle) at(smallTree).parent = joinNode;
+        at(joinNode).leftChild = leftTree;
+        at(leftTree).parent = joinNode;
+        refreshSubtreeInfo(joinNode);
+        at(pos).leftChild = joinNode;
+        at(joinNode).parent = pos;
+        pos = rebalance(pos);
+    }
+
+    checkTreeValidity(pos);
+
+    return pos;
+}
+
+addressQuery ETForestQuery::trivialInsert(Handle newNode, Handle root, bool first) {
+    assert(root != noHandle);
+    assert(newNode != noHandle);
+    cleanNode(newNode);
+    //Move down until we find the place where the new node belongs
+    Handle pos = root;
+
+    if (first) {
+        while (at(pos).leftChild != noHandle) pos = at(pos).leftChild;
+        at(pos).leftChild = newNode;
+    } else {
+        while (at(pos).rightChild != noHandle) pos = at(pos).rightChild;
+        at(pos).rightChild = newNode;
+    }
+
+    at(newNode).parent = pos;
+
+    pos = rebalance(pos);
+
+    checkTreeValidity(pos);
+
+    return pos;
+}
+
+std::pair<addressQuery, addressQuery> ETForestQuery::trivialDelete(Handle root, bool first) {
+    assert(root != noHandle);
+
+    Handle u = root;
+
+    //Locating the relevant node
+    if (first) {
+        while (at(u).leftChild != noHandle) u = at(u).leftChild;
+    } else {
+        while (at(u).rightChild != noHandle) u = at(u).rightChild;
+    }
+
+    //u has at most 1 child
+    Handle parent = at(u).parent;
+    Handle child = (at(u).leftChild != noHandle) ? at(u).leftChild : at(u).rightChild;
+    if (child != noHandle) at(child).parent = parent;
+    if (parent != noHandle) {
+        if (at(parent).leftChild == u) at(parent).leftChild = child;
+        else at(parent).rightChild = child;
+        root = rebalance(parent);
+    } else root = child;
+
+    cleanNode(u);
+
+    if (root != noHandle) checkTreeValidity(root);
+
+    return {u, root};
+}
+
+addressQuery ETForestQuery::rebalance(Handle start) {
+    Handle prev = start;
+    while (start != noHandle) {
+        prev = start;
+        start = at(start).parent;
+        refreshSubtreeInfo(prev);
+        Handle left = at(prev).leftChild, right = at(prev).rightChild;
+        if (getHeight(left) > getHeight(right) + 1) {
+            //Right rotation necessary
+            if (getHeight(at(left).rightChild) > getHeight(at(left).leftChild)) {
+                //Left-Right-Rotation necessary
+                rotate(left, LEFT);
+            }
+            prev = rotate(prev, RIGHT);
+        } else if (getHeight(right) > getHeight(left) + 1) {
+            //Left rotation necessary
+            if (getHeight(at(right).leftChild) > getHeight(at(right).rightChild)) {
+                //Right-Left-Rotation necessary
+                rotate(right, RIGHT);
+            }
+            prev = rotate(prev, LEFT);
+        }
+    }
+
+    return prev;
+}
+
+addressQuery ETForestQuery::rotate(Handle head, bool left) {
+    Handle parent = at(head).parent;
+    Handle kid;
+
+    //Standard rotate of AVL-Trees
+    if (left) {
+        assert(at(head).rightChild != noHandle);
+        kid = separateDirChild(head, RIGHT);
+        Handle innerGrandKid = separateDirChild(kid, LEFT);
+        at(kid).leftChild = head;
+        at(head).parent = kid;
+        at(head).rightChild = innerGrandKid;
+        if (innerGrandKid != noHandle) at(innerGrandKid).parent = head;
+    } else {
+        assert(at(head).leftChild != noHandle);
+        kid = separateDirChild(head, LEFT);
+        Handle innerGrandKid = separateDirChild(kid, RIGHT);
+        at(kid).rightChild = head;
+        at(head).parent = kid;
+        at(head).leftChild = innerGrandKid;
+        if (innerGrandKid != noHandle) at(innerGrandKid).parent = head;
+    }
+
+    refreshSubtreeInfo(head);
+    refreshSubtreeInfo(kid);
+
+    //Fix connection to parents
+    at(kid).parent = parent;
+
+    if (parent != noHandle) {
+        if (at(parent).leftChild == head) at(parent).leftChild = kid;
+        else at(parent).rightChild = kid;
+    }
+
+    return kid;
+}
+
+void ETForestQuery::cleanNode(Handle v) {
+    Node &data = at(v);
+    data.parent = noHandle;
+    data.leftChild = noHandle;
+    data.rightChild = noHandle;
+    data.height = 1;
+    data.size = 1;
+}
+
+void ETForestQuery::refreshSubtreeInfo(Handle v) {
+    Node &data = at(v);
+    data.size = 1 + getSubtreeSize(data.leftChild) + getSubtreeSize(data.rightChild);
+    data.height = std::max(getHeight(data.leftChild), getHeight(data.rightChild)) + 1;
+}
+
+addressQuery ETForestQuery::separateDirChild(Handle v, bool left) {
+    Handle &child = left ? at(v).leftChild : at(v).rightChild;
+    Handle kid = child;
+    if (kid == noHandle) return noHandle;
+
+    at(kid).parent = noHandle;
+    child = noHandle;
+
+    return kid;
+}
+
+addressQuery ETForestQuery::buildBalanced(const Handle *order, count num) {
+    if (num == 0) return noHandle;
+
+    //Halving the sequence keeps the heights of both subtrees within one of each other
+    count mid = num / 2;
+    Handle root = order[mid];
+    at(root).leftChild = buildBalanced(order, mid);
+    at(root).rightChild = buildBalanced(order + mid + 1, num - mid - 1);
+    if (at(root).leftChild != noHandle) at(at(root).leftChild).parent = root;
+    if (at(root).rightChild != noHandle) at(at(root).rightChild).parent = root;
+
+    refreshSubtreeInfo(root);
+    return root;
+}
+
+count ETForestQuery::getHeight(Handle v) const {
+    if (v == noHandle) return 0;
+    return at(v).height;
+}
+
+count ETForestQuery::getSubtreeSize(Handle v) const {
+    if (v == noHandle) return 0;
+    return at(v).size;
+}
+
+void ETForestQuery::checkTreeValidity([[maybe_unused]] Handle v) {
+#ifndef NDEBUG //This code is only executed in debug mode
+    const Node &data = at(v);
+    //Check if size and height are calculated correctly
+    assert(data.height == (std::max(getHeight(data.leftChild), getHeight(data.rightChild)) + 1));
+    assert(data.size == (getSubtreeSize(data.leftChild) + getSubtreeSize(data.rightChild) + 1));
+
+    //Check if parents and children are fine
+    if(data.leftChild != noHandle) assert(at(data.leftChild).parent == v);
+    if(data.rightChild != noHandle) assert(at(data.rightChild).parent == v);
+
+    //Check if everything is balanced properly
+    assert(data.height - getHeight(data.leftChild) <= 2);
+    assert(data.height - getHeight(data.rightChild) <= 2);
+
+    //Check if everything is ordered
+    if(data.leftChild != noHandle){
+        Handle prevInOrder = data.leftChild;
+        while (at(prevInOrder).rightChild != noHandle) prevInOrder = at(prevInOrder).rightChild;
+        assert(at(prevInOrder).w == data.v);
+        checkTreeValidity(data.leftChild);
+    }
+    if(data.rightChild != noHandle){
+        Handle nextInOrder = data.rightChild;
+        while (at(nextInOrder).leftChild != noHandle) nextInOrder = at(nextInOrder).leftChild;
+        assert(data.w == at(nextInOrder).v);
+        checkTreeValidity(data.rightChild);
+    }
+#endif
+}
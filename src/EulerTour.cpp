@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <cassert>
+
+#include "EulerTour.hpp"
+
+std::vector<count> eulerTours(std::span<const edge> edges, std::vector<count> &tourStarts) {
+    count n = 0;
+    for (edge e : edges) n = std::max(n, std::max(e.v, e.w) + 1);
+
+    //Adjacency of the forest in compressed form, the directed edges leaving v are adjacent[offsets[v]] to adjacent[offsets[v + 1] - 1]
+    std::vector<count> offsets(n + 1, 0);
+    for (edge e : edges) {
+        offsets[e.v + 1]++;
+        offsets[e.w + 1]++;
+    }
+    for (node v = 0; v < n; v++) offsets[v + 1] += offsets[v];
+
+    std::vector<count> adjacent(2 * edges.size());
+    std::vector<count> next(offsets.begin(), offsets.end() - 1);
+    for (count k = 0; k < edges.size(); k++) {
+        adjacent[next[edges[k].v]++] = 2 * k;
+        adjacent[next[edges[k].w]++] = 2 * k + 1;
+    }
+
+    auto head = [&](count d) {
+        return (d % 2 == 0) ? edges[d / 2].w : edges[d / 2].v;
+    };
+
+    std::vector<count> tour;
+    tour.reserve(2 * edges.size());
+    tourStarts.clear();
+    std::vector<bool> visited(n, false);
+
+    //Depth first search without recursion, every entry holds a vertex, the directed edge it was reached by and its next adjacent edge
+    struct Step {
+        node v;
+        count incoming;
+        count position;
+    };
+    std::vector<Step> stack;
+
+    for (edge e : edges) {
+        if (visited[e.v]) continue;
+        visited[e.v] = true;
+        tourStarts.push_back(tour.size());
+
+        stack.assign(1, {e.v, none, offsets[e.v]});
+        while (not stack.empty()) {
+            Step &step = stack.back();
+            if (step.position == offsets[step.v + 1]) {
+                //All subtrees are done, go back up
+                if (step.incoming != none) tour.push_back(step.incoming ^ 1);
+                stack.pop_back();
+                continue;
+            }
+
+            count d = adjacent[step.position++];
+            if (d == (step.incoming ^ 1)) continue;
+
+            node w = head(d);
+            assert(not visited[w]);
+            visited[w] = true;
+            tour.push_back(d);
+            stack.push_back({w, d, offsets[w]});
+        }
+    }
+    tourStarts.push_back(tour.size());
+
+    assert(tour.size() == 2 * edges.size());
+    return tour;
+}
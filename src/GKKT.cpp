@@ -1,61 +1,111 @@
 #include "GKKT.hpp"
 
 #include <cmath>
+#include <numeric>
 
-GKKT::GKKT(Graph &G, float c, uint seed, count boostLevel, Mode mode) : n(G.getN()), c(c), boostLevel(boostLevel) {
-    switch (mode) {
-        case pHeu:
-            p = (1 - std::pow(0.5, boostLevel));
-            break;
-        default:
-            p = (1 - std::pow(1 - precision, boostLevel));
-    }
-
-    switch (mode) {
-        case lvlHeu:
-            numLevels = std::ceil(4*c*log2(n));
-            break;
-        default:
-            numLevels = std::ceil(std::max(2*std::ceil(log2(n)/log2(4/(4 - p)))*(1 - p/2)/(1 - p), 8*c*log2(n) * p * (1 - p/2)/(1 - p)));
-            break;
-    }
+GKKT::GKKT(Graph &G, float c, uint seed, count boostLevel, Mode mode, count numThreads, ETBalancing balancing,
+           QueryForestType queryForestType) : n(G.getN()), c(c), boostLevel(boostLevel) {
+    p = successProbability(boostLevel, mode);
+    numLevels = computeNumLevels(n, c, boostLevel, mode);
 
-    cutSet = std::make_unique<CutSet>(n, boostLevel, numLevels, seed, adjacencyTrees);
+    cutSet = std::make_unique<CutSet>(n, boostLevel, numLevels, seed, adjacencyTrees, SketchEncoding::delta, numThreads, balancing);
+    //The number of levels is only enough for this many boost lines
+    cutSet->setMinBoostLevel(boostLevel);
     linkCutTrees = std::make_unique<LinkCutTrees>(n);
-    queryForest = std::make_unique<QueryForestAVL>(n);
+    queryForest = QueryForest::create(queryForestType, n);
 
     adjacencyTrees.resize(n);
 
-    for(node u = 0; u < n; u++){
-        for(node v : G.getNeighbors(u)){
-            if(v > u) addEdge(u, v);
-        }
-    }
+    build(G);
+}
+
+GKKT::GKKT(count n, float c, uint seed, count boostLevel, Mode mode, count numThreads, ETBalancing balancing,
+           QueryForestType queryForestType) : n(n), c(c), boostLevel(boostLevel) {
+    p = successProbability(boostLevel, mode);
+    numLevels = computeNumLevels(n, c, boostLevel, mode);
+
+    cutSet = std::make_unique<CutSet>(n, boostLevel, numLevels, seed, adjacencyTrees, SketchEncoding::delta, numThreads, balancing);
+    //The number of levels is only enough for this many boost lines
+    cutSet->setMinBoostLevel(boostLevel);
+    linkCutTrees = std::make_unique<LinkCutTrees>(n);
+    queryForest = QueryForest::create(queryForestType, n);
+
+    adjacencyTrees.resize(n);
 }
 
-GKKT::GKKT(count n, float c, uint seed, count boostLevel, Mode mode) : n(n), c(c), boostLevel(boostLevel) {
+GKKT::GKKT(count n, const Configuration &config, uint seed, Mode mode, count numThreads, ETBalancing balancing, QueryForestType queryForestType) :
+        GKKT(n, config.c, seed, config.boostLevel, mode, numThreads, balancing, queryForestType) {}
+
+double GKKT::successProbability(count boostLevel, Mode mode) {
     switch (mode) {
         case pHeu:
-            p = (1 - std::pow(0.5, boostLevel));
-            break;
+            return 1 - std::pow(0.5, boostLevel);
         default:
-            p = (1 - std::pow(1 - precision, boostLevel));
+            return 1 - std::pow(1 - precision, boostLevel);
     }
+}
+
+count GKKT::computeNumLevels(count n, float c, count boostLevel, Mode mode) {
+    double p = successProbability(boostLevel, mode);
 
     switch (mode) {
         case lvlHeu:
-            numLevels = std::ceil(4*c*log2(n));
-            break;
+            return std::ceil(4*c*log2(n));
         default:
-            numLevels = std::ceil(std::max(2*std::ceil(log2(n)/log2(4/(4 - p)))*(1 - p/2)/(1 - p), 8*c*log2(n) * p * (1 - p/2)/(1 - p)));
-            break;
+            return std::ceil(std::max(2*std::ceil(log2(n)/log2(4/(4 - p)))*(1 - p/2)/(1 - p), 8*c*log2(n) * p * (1 - p/2)/(1 - p)));
     }
+}
 
-    cutSet = std::make_unique<CutSet>(n, boostLevel, numLevels, seed, adjacencyTrees);
-    linkCutTrees = std::make_unique<LinkCutTrees>(n);
-    queryForest = std::make_unique<QueryForestAVL>(n);
+MemoryUsage GKKT::projectMemoryUsage(count n, float c, count boostLevel, Mode mode, count m, QueryForestType queryForestType) {
+    MemoryUsage usage = CutSet::projectMemoryUsage(n, boostLevel, computeNumLevels(n, c, boostLevel, mode), m);
+    usage += QueryForest::projectMemoryUsage(queryForestType, n);
+    usage.linkCutTrees += LinkCutTrees::projectNumBytes(n);
+    //Every edge is stored in the adjacency trees of both endpoints
+    usage.avlNodes += 2 * m * AVLTree<node, bool>::getNodeBytes();
+    usage.other += n * sizeof(AVLTree<node, bool>);
+    return usage;
+}
 
-    adjacencyTrees.resize(n);
+std::optional<GKKT::Configuration> GKKT::configureForMemory(count n, count memoryBudget, Mode mode, float c, count maxBoostLevel, count m,
+                                                      QueryForestType queryForestType) {
+    std::optional<Configuration> best;
+
+    auto fits = [&](float candidate, count boostLevel) {
+        //Without a single level there is nothing to run on
+        return computeNumLevels(n, candidate, boostLevel, mode) > 0 && projectMemoryUsage(n, candidate, boostLevel, mode, m, queryForestType).total() <= memoryBudget;
+    };
+
+    for(count boostLevel = maxBoostLevel; boostLevel >= 1; boostLevel--){
+        float fitting = c;
+        if(not fits(c, boostLevel)){
+            //The memory grows with the precision, so search for the largest precision that still fits
+            float low = 0, high = c;
+            for(count i = 0; i < 32; i++){
+                float mid = (low + high) / 2;
+                if(fits(mid, boostLevel)) low = mid;
+                else high = mid;
+            }
+            if(not fits(low, boostLevel)) continue;
+            fitting = low;
+        }
+
+        if(not best.has_value() || fitting > best->c){
+            best = Configuration{fitting, boostLevel, computeNumLevels(n, fitting, boostLevel, mode), projectMemoryUsage(n, fitting, boostLevel, mode, m, queryForestType)};
+        }
+        //No smaller boost level can offer more precision than the full one
+        if(fitting == c) break;
+    }
+
+    return best;
+}
+
+MemoryUsage GKKT::memoryUsage() const {
+    MemoryUsage usage = cutSet->memoryUsage();
+    usage += queryForest->memoryUsage();
+    usage.linkCutTrees += linkCutTrees->getNumBytes();
+    for(const AVLTree<node, bool> &tree : adjacencyTrees) usage.avlNodes += tree.getNumBytes();
+    usage.other += adjacencyTrees.capacity() * sizeof(AVLTree<node, bool>);
+    return usage;
 }
 
 bool GKKT::query(node u, node v) {
@@ -136,15 +186,79 @@ void GKKT::searchAndInsert(node v, count level) {
     }
 }
 
+void GKKT::build(const Graph &G) {
+    std::vector<edge> edges;
+    edges.reserve(G.getM());
+    for(node u = 0; u < n; u++){
+        for(node v : G.getNeighbors(u)){
+            if(v > u){
+                adjacencyTrees[u].insert(v, false);
+                adjacencyTrees[v].insert(u, false);
+                edges.push_back({u, v});
+            }
+        }
+    }
+    //There are no tree edges yet, so this only hashes the edges
+    cutSet->addEdgesToSet(edges);
+
+    //Contract the graph like Boruvka: in round r every component picks an edge leaving it, which becomes a tree edge from level r upwards
+    //Thus every component with an edge leaving it is part of a larger component on the level above, just like searchAndInsert ensures
+    std::vector<node> component(n);
+    std::iota(component.begin(), component.end(), 0);
+    auto find = [&component](node v){
+        while(component[v] != v){
+            component[v] = component[component[v]];
+            v = component[v];
+        }
+        return v;
+    };
+
+    std::vector<edge> forest;
+    std::vector<count> lowestLevels;
+    std::vector<edge> picked(n, noEdge);
+    for(count round = 1; not edges.empty(); round++){
+        for(edge e : edges){
+            node vComponent = find(e.v), wComponent = find(e.w);
+            if(picked[vComponent] == noEdge) picked[vComponent] = e;
+            if(picked[wComponent] == noEdge) picked[wComponent] = e;
+        }
+
+        for(node v = 0; v < n; v++){
+            if(picked[v] == noEdge) continue;
+            edge e = picked[v];
+            picked[v] = noEdge;
+
+            //Both components may have picked the same edge
+            node vComponent = find(e.v), wComponent = find(e.w);
+            if(vComponent == wComponent) continue;
+            component[vComponent] = wComponent;
+
+            forest.push_back(e);
+            //Levels above the last one don't exist, so the remaining rounds all end up on it
+            lowestLevels.push_back(std::min(round, numLevels - 1));
+        }
+
+        //Edges within a component can't be picked anymore
+        std::erase_if(edges, [&find](edge e){ return find(e.v) == find(e.w); });
+    }
+
+    cutSet->buildTreeEdges(forest, lowestLevels);
+    queryForest->addForest(forest);
+    for(count k = 0; k < forest.size(); k++) linkCutTrees->link(forest[k].v, forest[k].w, lowestLevels[k]);
+
+    sanityCheck();
+}
+
 void GKKT::sanityCheck() {
 #ifndef NDEBUG
     for (count level = 0; level < numLevels; level++){
         for (node v = 0; v < n; v++) {
-            if (cutSet->search(v, level) != noEdge) {
+            //Checks must not feed adaptive boosting, otherwise debug builds would adapt differently
+            if (cutSet->search(v, level, false) != noEdge) {
                 if (level < numLevels - 1)
-                    assert(cutSet->compSize(v, level) < cutSet->compSize(v, level + 1));
+                    assert(cutSet->checkCompSize(v, level) < cutSet->checkCompSize(v, level + 1));
                 else
-                    assert(cutSet->compSize(v, level) < queryForest->compSize(v));
+                    assert(cutSet->checkCompSize(v, level) < queryForest->compSize(v));
             }
         }
     }
@@ -73,4 +73,27 @@ count Graph::getN() const {
 
 count Graph::getM() const {
     return m;
-}
\ No newline at end of file
+}
+
+std::vector<edge> Graph::spanningForest() const {
+    std::vector<edge> forest;
+    std::vector<bool> visited(n, false);
+    std::vector<node> queue;
+
+    for(node root = 0; root < n; root++){
+        if(visited[root]) continue;
+        visited[root] = true;
+
+        queue.assign(1, root);
+        for(count i = 0; i < queue.size(); i++){
+            for(node w : adjacencyArrays[queue[i]]){
+                if(visited[w]) continue;
+                visited[w] = true;
+                forest.push_back({queue[i], w});
+                queue.push_back(w);
+            }
+        }
+    }
+
+    return forest;
+}
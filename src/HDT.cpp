@@ -8,18 +8,14 @@ HDT::HDT(count n) {
 HDT::HDT(const Graph &G) {
     init(G.getN()-1, G.getN()-1);
 
-    for(node u = 0; u < n; u++){
-        for(node v : G.getNeighbors(u)){
-            if(v > u) addEdge(u, v);
-        }
-    }
+    build(G);
 }
 
 bool HDT::query(node u, node v) {
     if (u >= n || v >= n) return false;
     if (u == v) return true;
     if (activeEdge[u].empty() || activeEdge[v].empty()) return false;
-    if (activeEdge[u][0] == nullptr || activeEdge[v][0] == nullptr) return false;
+    if (activeEdge[u][0] == ETForestHDT::noHandle || activeEdge[v][0] == ETForestHDT::noHandle) return false;
     return etForest.getRoot(activeEdge[u][0]) == etForest.getRoot(activeEdge[v][0]);
 }
 
@@ -78,8 +74,8 @@ void HDT::deleteTreeEdge(node u, node v) {
         addressHDT vTree = etForest.getRoot(activeEdge [v][i]);
 
         //Special case of size 1 trees
-        if (uTree == nullptr || vTree == nullptr) {
-            node small = (uTree == nullptr) ? u : v;
+        if (uTree == ETForestHDT::noHandle || vTree == ETForestHDT::noHandle) {
+            node small = (uTree == ETForestHDT::noHandle) ? u : v;
             if (nonTreeEdgesOnLevels[small].size() > i && not nonTreeEdgesOnLevels[small][i].empty()) {
                 //Any edge leaving a single vertex is a replacement edge
                 std::pair<node, bool> repEdge = nonTreeEdgesOnLevels[small][i].getAnyEntry();
@@ -91,7 +87,7 @@ void HDT::deleteTreeEdge(node u, node v) {
                 continue;
         }
 
-        addressHDT smallTree = (uTree->getSize() < vTree->getSize()) ? uTree : vTree;
+        addressHDT smallTree = (etForest.getSize(uTree) < etForest.getSize(vTree)) ? uTree : vTree;
         //Step 1: promote every on-level-edge in the entire tree
         edge toPromote = etForest.getOnLevelTreeEdge(smallTree);
         while (toPromote != noEdge) {
@@ -109,7 +105,7 @@ void HDT::deleteTreeEdge(node u, node v) {
                 std::pair<node, bool> repEdge = nonTreeEdgesOnLevels[hasNonTreeEdges][i].getAnyEntry();
                 deleteNonTreeEdge(hasNonTreeEdges, repEdge.first, i);
 
-                assert(activeEdge[repEdge.first][i] != nullptr);
+                assert(activeEdge[repEdge.first][i] != ETForestHDT::noHandle);
                 if (etForest.getRoot(activeEdge[repEdge.first][i]) != smallTree) {
                     replacement = {hasNonTreeEdges, repEdge.first};
                     break;
@@ -144,13 +140,13 @@ void HDT::deleteNonTreeEdge(node u, node v, count level) {
 
     nonTreeEdgesOnLevels[u][level].remove(v);
     if (nonTreeEdgesOnLevels[u][level].empty()) {
-        if (activeEdge[u][level] != nullptr) {
+        if (activeEdge[u][level] != ETForestHDT::noHandle) {
             etForest.setEdgeNontreeEdges(activeEdge[u][level], 0);
         }
     }
     nonTreeEdgesOnLevels[v][level].remove(u);
     if (nonTreeEdgesOnLevels[v][level].empty()) {
-        if (activeEdge[v][level] != nullptr) {
+        if (activeEdge[v][level] != ETForestHDT::noHandle) {
             etForest.setEdgeNontreeEdges(activeEdge[v][level], 0);
         }
     }
@@ -165,7 +161,7 @@ void HDT::refreshActiveEdge(node v, count level) {
         if (nonTreeEdgesOnLevels[v].size() > level && not nonTreeEdgesOnLevels[v][level].empty())
             etForest.setEdgeNontreeEdges(activeEdge[v][level], 1);
     }
-    else activeEdge[v][level] = nullptr;
+    else activeEdge[v][level] = ETForestHDT::noHandle;
 }
 
 void HDT::addTreeEdge(node u, node v, count level, bool onLevel) {
@@ -175,25 +171,25 @@ void HDT::addTreeEdge(node u, node v, count level, bool onLevel) {
     assert(treeEdges[v].size() <= level || not treeEdges[v][level].contains(u));
 
     if (activeEdge[u].size() <= level) {
-        activeEdge[u].resize(level + 1, nullptr);
+        activeEdge[u].resize(level + 1, ETForestHDT::noHandle);
         treeEdges[u].resize(level + 1);
     }
     if (activeEdge[v].size() <= level) {
-        activeEdge[v].resize(level + 1, nullptr);
+        activeEdge[v].resize(level + 1, ETForestHDT::noHandle);
         treeEdges[v].resize(level + 1);
     }
 
-    bool uHasNonTreeEdges = (activeEdge[u][level] == nullptr) && (nonTreeEdgesOnLevels[u].size() > level) && (not nonTreeEdgesOnLevels[u][level].empty());
-    bool vHasNonTreeEdges = (activeEdge[v][level] == nullptr) && (nonTreeEdgesOnLevels[v].size() > level) && (not nonTreeEdgesOnLevels[v][level].empty());
+    bool uHasNonTreeEdges = (activeEdge[u][level] == ETForestHDT::noHandle) && (nonTreeEdgesOnLevels[u].size() > level) && (not nonTreeEdgesOnLevels[u][level].empty());
+    bool vHasNonTreeEdges = (activeEdge[v][level] == ETForestHDT::noHandle) && (nonTreeEdgesOnLevels[v].size() > level) && (not nonTreeEdgesOnLevels[v][level].empty());
 
     std::pair<addressHDT, addressHDT> newEdges = etForest.insertETEdge(u, v, activeEdge[u][level], activeEdge[v][level],
                                                                  onLevel, onLevel,
                                                                  uHasNonTreeEdges, vHasNonTreeEdges);
 
     treeEdges[u][level].insert(v, newEdges.first);
-    if (activeEdge[u][level] == nullptr) activeEdge[u][level] = newEdges.first;
+    if (activeEdge[u][level] == ETForestHDT::noHandle) activeEdge[u][level] = newEdges.first;
     treeEdges[v][level].insert(u, newEdges.second);
-    if (activeEdge[v][level] == nullptr) activeEdge[v][level] = newEdges.second;
+    if (activeEdge[v][level] == ETForestHDT::noHandle) activeEdge[v][level] = newEdges.second;
 }
 
 void HDT::addNonTreeEdge(node u, node v, count level) {
@@ -231,11 +227,45 @@ void HDT::init(node u, node v) {
         nonTreeEdgesOnLevels.resize(u + 1);
         nonTreeEdgesLevelIndex.resize(u + 1);
         treeEdges.resize(u + 1);
-        activeEdge.resize(u + 1, {nullptr});
+        activeEdge.resize(u + 1, {ETForestHDT::noHandle});
         for(count i = n; i < u + 1; i++) {
             nonTreeEdgesOnLevels[i].resize(1);
             treeEdges[i].resize(1);
         }
         n = u + 1;
     }
-}
\ No newline at end of file
+}
+
+void HDT::build(const Graph &G) {
+    std::vector<edge> forest = G.spanningForest();
+
+    //All other edges are nonTreeEdges on level 0, so a vertex has some iff it has more edges than forest edges
+    std::vector<count> forestDegrees(n, 0);
+    for (edge e : forest) {
+        forestDegrees[e.v]++;
+        forestDegrees[e.w]++;
+    }
+    std::vector<count> nonTreeEdgesOnLevel(n);
+    for (node v = 0; v < n; v++) nonTreeEdgesOnLevel[v] = (G.getNeighbors(v).size() > forestDegrees[v]) ? 1 : 0;
+
+    std::vector<std::pair<addressHDT, addressHDT>> newEdges = etForest.buildForest(forest, true, nonTreeEdgesOnLevel);
+    for (count k = 0; k < forest.size(); k++) {
+        node u = forest[k].v, v = forest[k].w;
+        treeEdges[u][0].insert(v, newEdges[k].first);
+        if (activeEdge[u][0] == ETForestHDT::noHandle) activeEdge[u][0] = newEdges[k].first;
+        treeEdges[v][0].insert(u, newEdges[k].second);
+        if (activeEdge[v][0] == ETForestHDT::noHandle) activeEdge[v][0] = newEdges[k].second;
+    }
+    numComponents -= forest.size();
+
+    //The active edges already know about the nonTreeEdges
+    for (node u = 0; u < n; u++) {
+        for (node v : G.getNeighbors(u)) {
+            if (v < u || treeEdges[u][0].contains(v)) continue;
+            nonTreeEdgesLevelIndex[u].insert(v, 0);
+            nonTreeEdgesLevelIndex[v].insert(u, 0);
+            nonTreeEdgesOnLevels[u][0].insert(v, false);
+            nonTreeEdgesOnLevels[v][0].insert(u, false);
+        }
+    }
+}
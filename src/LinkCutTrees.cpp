@@ -281,4 +281,9 @@ void LinkCutTrees::checkForestValidity() {
         }
     }
 #endif //NDEBUG
-}
\ No newline at end of file
+}
+
+count LinkCutTrees::projectNumBytes(count n) {
+    count perNode = sizeof(node) + sizeof(cost) + sizeof(Path) + sizeof(BiasedBinaryTree<std::pair<count, node>, Path>);
+    return n * perNode + 2 * n * sizeof(BBTNode) + n * BiasedBinaryTree<std::pair<count, node>, Path>::getNodeBytes();
+}
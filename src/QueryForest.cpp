@@ -0,0 +1,21 @@
+#include "QueryForest.hpp"
+#include "QueryForestAVL.hpp"
+#include "QueryForestBTree.hpp"
+
+std::unique_ptr<QueryForest> QueryForest::create(QueryForestType type, count n) {
+    switch (type) {
+        case QueryForestType::avl:
+            return std::make_unique<QueryForestAVL>(n);
+        default:
+            return std::make_unique<QueryForestBTree>(n);
+    }
+}
+
+MemoryUsage QueryForest::projectMemoryUsage(QueryForestType type, count n) {
+    switch (type) {
+        case QueryForestType::avl:
+            return QueryForestAVL::projectMemoryUsage(n);
+        default:
+            return QueryForestBTree::projectMemoryUsage(n);
+    }
+}
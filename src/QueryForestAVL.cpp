@@ -1,6 +1,6 @@
 #include "QueryForestAVL.hpp"
 
-QueryForestAVL::QueryForestAVL(count n) : n(n), forest(ETForestCutSet(0, n, true)) {
+QueryForestAVL::QueryForestAVL(count n) : n(n), forest(n) {
     treeEdges.resize(n);
     numConnectedComponents = n;
 }
@@ -15,13 +15,13 @@ bool QueryForestAVL::query(node u, node v) const {
 count QueryForestAVL::compSize(node v) const {
     if(v >= n) return 0;
     if(treeEdges[v].empty()) return 1;
-    return forest.getRoot(treeEdges[v].getAnyEntry().second)->getSize();
+    return forest.getSize(forest.getRoot(treeEdges[v].getAnyEntry().second));
 }
 
 count QueryForestAVL::compRepresentative(node v) const {
     if(v >= n) return none;
     if(treeEdges[v].empty()) return 1;
-    return forest.getRoot(treeEdges[v].getAnyEntry().second)->getSize();
+    return forest.getSize(forest.getRoot(treeEdges[v].getAnyEntry().second));
 }
 
 bool QueryForestAVL::isTreeEdge(node u, node v) const {
@@ -37,12 +37,12 @@ void QueryForestAVL::addEdge(node u, node v) {
     assert(not query(u, v));
 
     //Get two tree edges if any exist
-    address uEdge = nullptr, vEdge = nullptr;
+    addressQuery uEdge = ETForestQuery::noHandle, vEdge = ETForestQuery::noHandle;
     if(not treeEdges[u].empty()) uEdge = treeEdges[u].getAnyEntry().second;
     if(not treeEdges[v].empty()) vEdge = treeEdges[v].getAnyEntry().second;
 
     //Insert the edge into the ETForest
-    std::pair<address, address> newEdges = forest.insertETEdge(u, v, uEdge, vEdge);
+    std::pair<addressQuery, addressQuery> newEdges = forest.insertETEdge(u, v, uEdge, vEdge);
 
     //Store the edges for later use
     treeEdges[u].insert(v, newEdges.first);
@@ -51,12 +51,40 @@ void QueryForestAVL::addEdge(node u, node v) {
     numConnectedComponents--;
 }
 
+void QueryForestAVL::addForest(std::span<const edge> edges) {
+    std::vector<std::pair<addressQuery, addressQuery>> newEdges = forest.buildForest(edges);
+
+    for(count k = 0; k < edges.size(); k++){
+        treeEdges[edges[k].v].insert(edges[k].w, newEdges[k].first);
+        treeEdges[edges[k].w].insert(edges[k].v, newEdges[k].second);
+    }
+
+    numConnectedComponents -= edges.size();
+}
+
 void QueryForestAVL::deleteEdge(node u, node v) {
     assert(u < n && v < n);
 
     //Get the edges and delete them
-    address uEdge = treeEdges[u].remove(v), vEdge = treeEdges[v].remove(u);
+    addressQuery uEdge = treeEdges[u].remove(v), vEdge = treeEdges[v].remove(u);
     forest.deleteETEdge(uEdge, vEdge);
 
     numConnectedComponents++;
-}
\ No newline at end of file
+}
+
+MemoryUsage QueryForestAVL::memoryUsage() const {
+    MemoryUsage usage;
+    usage.etNodes = forest.getNumBytes();
+    for(const AVLTree<node, addressQuery> &tree : treeEdges) usage.avlNodes += tree.getNumBytes();
+    usage.other = treeEdges.capacity() * sizeof(AVLTree<node, addressQuery>);
+    return usage;
+}
+
+MemoryUsage QueryForestAVL::projectMemoryUsage(count n) {
+    MemoryUsage usage;
+    count treeNodes = (n == 0) ? 0 : 2 * (n - 1);
+    usage.etNodes = ETForestQuery::projectNumBytes(treeNodes);
+    usage.avlNodes = treeNodes * AVLTree<node, addressQuery>::getNodeBytes();
+    usage.other = n * sizeof(AVLTree<node, addressQuery>);
+    return usage;
+}
@@ -0,0 +1,91 @@
+#include "QueryForestBTree.hpp"
+
+QueryForestBTree::QueryForestBTree(count n) : n(n), forest(n) {
+    treeEdges.resize(n);
+    numConnectedComponents = n;
+}
+
+bool QueryForestBTree::query(node u, node v) const {
+    if(u == v) return true;
+    if(u >= n || v >= n) return false;
+    if(treeEdges[u].empty() || treeEdges[v].empty()) return false;
+    return forest.getRoot(treeEdges[u].getAnyEntry().second) == forest.getRoot(treeEdges[v].getAnyEntry().second);
+}
+
+count QueryForestBTree::compSize(node v) const {
+    if(v >= n) return 0;
+    if(treeEdges[v].empty()) return 1;
+    return forest.getSize(forest.getRoot(treeEdges[v].getAnyEntry().second));
+}
+
+count QueryForestBTree::compRepresentative(node v) const {
+    if(v >= n) return none;
+    if(treeEdges[v].empty()) return v;
+    //The tour only changes with the forest, so the start of its first edge is stable
+    return forest.getV(forest.getFirst(forest.getRoot(treeEdges[v].getAnyEntry().second)));
+}
+
+bool QueryForestBTree::isTreeEdge(node u, node v) const {
+    return treeEdges[u].contains(v);
+}
+
+count QueryForestBTree::numberOfComponents() const {
+    return numConnectedComponents;
+}
+
+void QueryForestBTree::addEdge(node u, node v) {
+    assert(u < n && v < n);
+    assert(not query(u, v));
+
+    //Get two tree edges if any exist
+    ETForestBTree::Handle uEdge = ETForestBTree::noHandle, vEdge = ETForestBTree::noHandle;
+    if(not treeEdges[u].empty()) uEdge = treeEdges[u].getAnyEntry().second;
+    if(not treeEdges[v].empty()) vEdge = treeEdges[v].getAnyEntry().second;
+
+    //Insert the edge into the ETForest
+    std::pair<ETForestBTree::Handle, ETForestBTree::Handle> newEdges = forest.insertETEdge(u, v, uEdge, vEdge);
+
+    //Store the edges for later use
+    treeEdges[u].insert(v, newEdges.first);
+    treeEdges[v].insert(u, newEdges.second);
+
+    numConnectedComponents--;
+}
+
+void QueryForestBTree::addForest(std::span<const edge> edges) {
+    std::vector<std::pair<ETForestBTree::Handle, ETForestBTree::Handle>> newEdges = forest.buildForest(edges);
+
+    for(count k = 0; k < edges.size(); k++){
+        treeEdges[edges[k].v].insert(edges[k].w, newEdges[k].first);
+        treeEdges[edges[k].w].insert(edges[k].v, newEdges[k].second);
+    }
+
+    numConnectedComponents -= edges.size();
+}
+
+void QueryForestBTree::deleteEdge(node u, node v) {
+    assert(u < n && v < n);
+
+    //Get the edges and delete them
+    ETForestBTree::Handle uEdge = treeEdges[u].remove(v), vEdge = treeEdges[v].remove(u);
+    forest.deleteETEdge(uEdge, vEdge);
+
+    numConnectedComponents++;
+}
+
+MemoryUsage QueryForestBTree::memoryUsage() const {
+    MemoryUsage usage;
+    usage.etNodes = forest.getNumBytes();
+    for(const AVLTree<node, ETForestBTree::Handle> &tree : treeEdges) usage.avlNodes += tree.getNumBytes();
+    usage.other = treeEdges.capacity() * sizeof(AVLTree<node, ETForestBTree::Handle>);
+    return usage;
+}
+
+MemoryUsage QueryForestBTree::projectMemoryUsage(count n) {
+    MemoryUsage usage;
+    count treeNodes = (n == 0) ? 0 : 2 * (n - 1);
+    usage.etNodes = ETForestBTree::projectNumBytes(treeNodes);
+    usage.avlNodes = treeNodes * AVLTree<node, ETForestBTree::Handle>::getNodeBytes();
+    usage.other = n * sizeof(AVLTree<node, ETForestBTree::Handle>);
+    return usage;
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define GKKT_ZERO_PAGES
+#endif
+
+#include "SketchArena.hpp"
+
+sketchWord* allocateSketchMemory(count numEntries) {
+    if (numEntries == 0) return nullptr;
+    count numBytes = numEntries * sizeof(sketchWord);
+
+#ifdef GKKT_ZERO_PAGES
+    //Anonymous mappings are page aligned and zero, so nothing has to be written here
+    if (numBytes >= zeroPageThreshold) {
+        void *data = mmap(nullptr, numBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED) throw std::bad_alloc();
+        return static_cast<sketchWord*>(data);
+    }
+#endif
+
+    //Zero the raw memory before it is typed, an all zero edge is the empty sketch word
+    void *data = ::operator new(numBytes, std::align_val_t(cacheLineSize));
+    std::memset(data, 0, numBytes);
+    return static_cast<sketchWord*>(data);
+}
+
+void freeSketchMemory(sketchWord *data, count numEntries) {
+    if (data == nullptr) return;
+
+#ifdef GKKT_ZERO_PAGES
+    if (numEntries * sizeof(sketchWord) >= zeroPageThreshold) {
+        munmap(data, numEntries * sizeof(sketchWord));
+        return;
+    }
+#endif
+
+    ::operator delete(data, std::align_val_t(cacheLineSize));
+}
+
+SketchArena::SketchArena(count pNumSketches, count pBoostLevel, count pLognsqr) {
+    numSketches = pNumSketches;
+    stride = sketchStride(pBoostLevel, pLognsqr);
+    data = allocateSketchMemory(numSketches * stride);
+}
+
+SketchArena::SketchArena(SketchArena &&other) noexcept {
+    numSketches = std::exchange(other.numSketches, 0);
+    stride = std::exchange(other.stride, 0);
+    data = std::exchange(other.data, nullptr);
+}
+
+SketchArena &SketchArena::operator=(SketchArena &&other) noexcept {
+    if (this == &other) return *this;
+
+    freeSketchMemory(data, numSketches * stride);
+    numSketches = std::exchange(other.numSketches, 0);
+    stride = std::exchange(other.stride, 0);
+    data = std::exchange(other.data, nullptr);
+
+    return *this;
+}
+
+SketchArena::~SketchArena() {
+    freeSketchMemory(data, numSketches * stride);
+}
+
+count SketchArena::sketchStride(count boostLevel, count lognsqr) {
+    constexpr count wordsPerLine = cacheLineSize / sizeof(sketchWord);
+    count size = boostLevel * lognsqr;
+    return (size + wordsPerLine - 1) / wordsPerLine * wordsPerLine;
+}
+
+sketchWord *SketchPool::allocate() {
+    if (usedInBlock == blockCapacity) {
+        blockCapacity = blocks.empty() ? minSketchesPerBlock : std::min(2 * blockCapacity, maxSketchesPerBlock);
+        blocks.emplace_back(blockCapacity, boostLevel, lognsqr);
+        usedInBlock = 0;
+    }
+
+    return blocks.back().getSketch(usedInBlock++);
+}
+
+count SketchPool::getNumBytes() const {
+    count numBytes = 0;
+    for (const SketchArena &block : blocks) numBytes += block.getNumBytes();
+    return numBytes;
+}
+
+count SketchPool::projectNumSketches(count numSketches) {
+    count allocated = 0;
+    for (count capacity = minSketchesPerBlock; allocated < numSketches; capacity = std::min(2 * capacity, maxSketchesPerBlock)) allocated += capacity;
+    return allocated;
+}
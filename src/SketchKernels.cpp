@@ -0,0 +1,219 @@
+#include <cstring>
+
+#include "SketchKernels.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define GKKT_SKETCH_X86
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(sketchWord) % sizeof(uint64_t) == 0 && sizeof(sketchWord) <= 2 * sizeof(uint64_t),
+              "sketch kernels expect a sketch word to be one or two 64 bit words");
+
+namespace {
+
+//! Number of 64 bit words in one sketch word
+constexpr count wordsPerSlot = sizeof(sketchWord) / sizeof(uint64_t);
+
+/*
+ * The kernels work on arrays of 64 bit words. A sketch word xored into a range is given as the pattern (lo, hi) that
+ * alternates over the words, for packed sketch words lo and hi are the same
+ */
+using XorRangeFunction = void (*)(uint64_t*, uint64_t, uint64_t, count);
+using XorIntoFunction = void (*)(uint64_t*, const uint64_t*, count);
+using Xor2Function = void (*)(uint64_t*, const uint64_t*, const uint64_t*, count);
+using Xor3Function = void (*)(uint64_t*, const uint64_t*, const uint64_t*, const uint64_t*, count);
+
+void xorRangeScalar(uint64_t* data, uint64_t lo, uint64_t hi, count length) {
+    for (count i = 0; i < length; i++) data[i] ^= (i % 2 == 0) ? lo : hi;
+}
+
+void xorIntoScalar(uint64_t* dst, const uint64_t* src, count length) {
+    for (count i = 0; i < length; i++) dst[i] ^= src[i];
+}
+
+void xor2Scalar(uint64_t* dst, const uint64_t* a, const uint64_t* b, count length) {
+    for (count i = 0; i < length; i++) dst[i] = a[i] ^ b[i];
+}
+
+void xor3Scalar(uint64_t* dst, const uint64_t* a, const uint64_t* b, const uint64_t* c, count length) {
+    for (count i = 0; i < length; i++) dst[i] = a[i] ^ b[i] ^ c[i];
+}
+
+#ifdef GKKT_SKETCH_X86
+//SSE2 is part of x86-64, so these need no runtime check. One 128 bit register holds two words, an odd remaining word is done scalar
+void xorRangeSSE2(uint64_t* data, uint64_t lo, uint64_t hi, count length) {
+    const __m128i pattern = _mm_set_epi64x(static_cast<long long>(hi), static_cast<long long>(lo));
+    auto *p = reinterpret_cast<__m128i*>(data);
+    count blocks = length / 2;
+    for (count i = 0; i < blocks; i++) _mm_storeu_si128(p + i, _mm_xor_si128(_mm_loadu_si128(p + i), pattern));
+    if (length % 2 == 1) data[length - 1] ^= lo;
+}
+
+void xorIntoSSE2(uint64_t* dst, const uint64_t* src, count length) {
+    auto *d = reinterpret_cast<__m128i*>(dst);
+    auto *s = reinterpret_cast<const __m128i*>(src);
+    count blocks = length / 2;
+    for (count i = 0; i < blocks; i++) _mm_storeu_si128(d + i, _mm_xor_si128(_mm_loadu_si128(d + i), _mm_loadu_si128(s + i)));
+    if (length % 2 == 1) dst[length - 1] ^= src[length - 1];
+}
+
+void xor2SSE2(uint64_t* dst, const uint64_t* a, const uint64_t* b, count length) {
+    auto *d = reinterpret_cast<__m128i*>(dst);
+    auto *sa = reinterpret_cast<const __m128i*>(a);
+    auto *sb = reinterpret_cast<const __m128i*>(b);
+    count blocks = length / 2;
+    for (count i = 0; i < blocks; i++) _mm_storeu_si128(d + i, _mm_xor_si128(_mm_loadu_si128(sa + i), _mm_loadu_si128(sb + i)));
+    if (length % 2 == 1) dst[length - 1] = a[length - 1] ^ b[length - 1];
+}
+
+void xor3SSE2(uint64_t* dst, const uint64_t* a, const uint64_t* b, const uint64_t* c, count length) {
+    auto *d = reinterpret_cast<__m128i*>(dst);
+    auto *sa = reinterpret_cast<const __m128i*>(a);
+    auto *sb = reinterpret_cast<const __m128i*>(b);
+    auto *sc = reinterpret_cast<const __m128i*>(c);
+    count blocks = length / 2;
+    for (count i = 0; i < blocks; i++)
+        _mm_storeu_si128(d + i, _mm_xor_si128(_mm_xor_si128(_mm_loadu_si128(sa + i), _mm_loadu_si128(sb + i)), _mm_loadu_si128(sc + i)));
+    if (length % 2 == 1) dst[length - 1] = a[length - 1] ^ b[length - 1] ^ c[length - 1];
+}
+
+//AVX2 handles four words per register, the remaining words are done with SSE2
+__attribute__((target("avx2"))) void xorRangeAVX2(uint64_t* data, uint64_t lo, uint64_t hi, count length) {
+    const __m256i pattern = _mm256_set_epi64x(static_cast<long long>(hi), static_cast<long long>(lo),
+                                              static_cast<long long>(hi), static_cast<long long>(lo));
+    auto *p = reinterpret_cast<__m256i*>(data);
+    count blocks = length / 4;
+    for (count i = 0; i < blocks; i++) _mm256_storeu_si256(p + i, _mm256_xor_si256(_mm256_loadu_si256(p + i), pattern));
+    xorRangeSSE2(data + 4 * blocks, lo, hi, length % 4);
+}
+
+__attribute__((target("avx2"))) void xorIntoAVX2(uint64_t* dst, const uint64_t* src, count length) {
+    auto *d = reinterpret_cast<__m256i*>(dst);
+    auto *s = reinterpret_cast<const __m256i*>(src);
+    count blocks = length / 4;
+    for (count i = 0; i < blocks; i++) _mm256_storeu_si256(d + i, _mm256_xor_si256(_mm256_loadu_si256(d + i), _mm256_loadu_si256(s + i)));
+    xorIntoSSE2(dst + 4 * blocks, src + 4 * blocks, length % 4);
+}
+
+__attribute__((target("avx2"))) void xor2AVX2(uint64_t* dst, const uint64_t* a, const uint64_t* b, count length) {
+    auto *d = reinterpret_cast<__m256i*>(dst);
+    auto *sa = reinterpret_cast<const __m256i*>(a);
+    auto *sb = reinterpret_cast<const __m256i*>(b);
+    count blocks = length / 4;
+    for (count i = 0; i < blocks; i++) _mm256_storeu_si256(d + i, _mm256_xor_si256(_mm256_loadu_si256(sa + i), _mm256_loadu_si256(sb + i)));
+    xor2SSE2(dst + 4 * blocks, a + 4 * blocks, b + 4 * blocks, length % 4);
+}
+
+__attribute__((target("avx2"))) void xor3AVX2(uint64_t* dst, const uint64_t* a, const uint64_t* b, const uint64_t* c, count length) {
+    auto *d = reinterpret_cast<__m256i*>(dst);
+    auto *sa = reinterpret_cast<const __m256i*>(a);
+    auto *sb = reinterpret_cast<const __m256i*>(b);
+    auto *sc = reinterpret_cast<const __m256i*>(c);
+    count blocks = length / 4;
+    for (count i = 0; i < blocks; i++)
+        _mm256_storeu_si256(d + i, _mm256_xor_si256(_mm256_xor_si256(_mm256_loadu_si256(sa + i), _mm256_loadu_si256(sb + i)), _mm256_loadu_si256(sc + i)));
+    xor3SSE2(dst + 4 * blocks, a + 4 * blocks, b + 4 * blocks, c + 4 * blocks, length % 4);
+}
+#endif
+
+//! Views sketch words as the 64 bit words the kernels work on
+uint64_t* words(sketchWord* data) {
+    return reinterpret_cast<uint64_t*>(data);
+}
+
+const uint64_t* words(const sketchWord* data) {
+    return reinterpret_cast<const uint64_t*>(data);
+}
+
+struct KernelTable {
+    SketchISA isa;
+    XorRangeFunction xorRange;
+    XorIntoFunction xorInto;
+    Xor2Function xor2;
+    Xor3Function xor3;
+};
+
+bool isSupported(SketchISA isa) {
+    switch (isa) {
+        case SketchISA::scalar:
+            return true;
+#ifdef GKKT_SKETCH_X86
+        case SketchISA::sse2:
+            return true;
+        case SketchISA::avx2:
+            //The kernel table is set up during static initialization, so the cpu info has to be initialized by hand
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+KernelTable makeTable(SketchISA isa) {
+    switch (isa) {
+#ifdef GKKT_SKETCH_X86
+        case SketchISA::avx2:
+            return {isa, xorRangeAVX2, xorIntoAVX2, xor2AVX2, xor3AVX2};
+        case SketchISA::sse2:
+            return {isa, xorRangeSSE2, xorIntoSSE2, xor2SSE2, xor3SSE2};
+#endif
+        default:
+            return {SketchISA::scalar, xorRangeScalar, xorIntoScalar, xor2Scalar, xor3Scalar};
+    }
+}
+
+KernelTable detectBestTable() {
+    if (isSupported(SketchISA::avx2)) return makeTable(SketchISA::avx2);
+    if (isSupported(SketchISA::sse2)) return makeTable(SketchISA::sse2);
+    return makeTable(SketchISA::scalar);
+}
+
+KernelTable kernels = detectBestTable();
+
+} //namespace
+
+SketchISA getSketchISA() {
+    return kernels.isa;
+}
+
+bool setSketchISA(SketchISA isa) {
+    if (not isSupported(isa)) return false;
+    kernels = makeTable(isa);
+    return true;
+}
+
+void xorEdgeIntoRange(sketchWord* data, sketchWord e, count length) {
+    uint64_t pattern[2];
+    std::memcpy(pattern, &e, sizeof(sketchWord));
+    if (wordsPerSlot == 1) pattern[1] = pattern[0];
+    kernels.xorRange(words(data), pattern[0], pattern[1], length * wordsPerSlot);
+}
+
+void xorSketchInto(sketchWord* dst, const sketchWord* src, count length) {
+    kernels.xorInto(words(dst), words(src), length * wordsPerSlot);
+}
+
+void combineSketches(sketchWord* dst, const sketchWord* own, const sketchWord* left, const sketchWord* right, count length) {
+    //Gather the sketches that are actually present so every case is a single pass over dst
+    const sketchWord* sources[3];
+    count numSources = 0;
+    if (own != nullptr) sources[numSources++] = own;
+    if (left != nullptr) sources[numSources++] = left;
+    if (right != nullptr) sources[numSources++] = right;
+
+    switch (numSources) {
+        case 0:
+            std::memset(static_cast<void*>(dst), 0, length * sizeof(sketchWord));
+            break;
+        case 1:
+            std::memcpy(static_cast<void*>(dst), sources[0], length * sizeof(sketchWord));
+            break;
+        case 2:
+            kernels.xor2(words(dst), words(sources[0]), words(sources[1]), length * wordsPerSlot);
+            break;
+        default:
+            kernels.xor3(words(dst), words(sources[0]), words(sources[1]), words(sources[2]), length * wordsPerSlot);
+    }
+}
@@ -53,4 +53,19 @@ count TabularHash::hash(edge e) {
     }
 
     return res;
-}
\ No newline at end of file
+}
+
+count TabularHash::getNumBytes() const {
+    count numBytes = hashBlocks.capacity() * sizeof(std::vector<count>);
+    for(const std::vector<count> &block : hashBlocks) numBytes += block.capacity() * sizeof(count);
+    return numBytes;
+}
+
+count TabularHash::projectNumBytes(count n, uint pBlockSize) {
+    //Same table layout as in the constructor
+    count length = 0;
+    for(count nUp2 = 1; n * n > nUp2; nUp2 *= 2) length++;
+    count numBlocks = 2 * std::ceil((1.0 * length)/pBlockSize);
+
+    return numBlocks * (sizeof(std::vector<count>) + (count(1) << pBlockSize) * sizeof(count));
+}
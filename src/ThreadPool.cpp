@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <utility>
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(count pNumThreads) {
+    if (pNumThreads == 0) pNumThreads = 1;
+
+    workers.reserve(pNumThreads - 1);
+    for (count i = 0; i + 1 < pNumThreads; i++) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    jobReady.notify_all();
+
+    for (std::thread &worker : workers) worker.join();
+}
+
+void ThreadPool::parallelFor(count begin, count end, count minChunk, const std::function<void(count)> &body) {
+    if (begin >= end) return;
+
+    minChunk = std::max<count>(minChunk, 1);
+    count chunks = std::min(getNumThreads(), (end - begin) / minChunk);
+
+    //Too little work to be worth waking anyone up
+    if (chunks <= 1) {
+        for (count i = begin; i < end; i++) body(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &body;
+        jobBegin = begin;
+        jobEnd = end;
+        numChunks = chunks;
+        chunkSize = (end - begin + chunks - 1) / chunks;
+        pending = workers.size();
+        error = nullptr;
+        generation++;
+    }
+    jobReady.notify_all();
+
+    //The caller handles the first chunk itself
+    runChunk(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    jobDone.wait(lock, [this] { return pending == 0; });
+    job = nullptr;
+
+    //Only rethrown once all workers are done, since they still refer to the body until then
+    if (error != nullptr) std::rethrow_exception(std::exchange(error, nullptr));
+}
+
+void ThreadPool::workerLoop(count id) {
+    count seenGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this, seenGeneration] { return stop || generation != seenGeneration; });
+            if (stop) return;
+            seenGeneration = generation;
+        }
+
+        //Workers without a chunk of their own only acknowledge the loop
+        if (id + 1 < numChunks) runChunk(id + 1);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = (--pending == 0);
+        }
+        if (last) jobDone.notify_one();
+    }
+}
+
+void ThreadPool::runChunk(count chunk) {
+    count first = jobBegin + chunk * chunkSize;
+    count last = std::min(jobEnd, first + chunkSize);
+
+    try {
+        for (count i = first; i < last; i++) (*job)(i);
+    } catch (...) {
+        //An exception escaping a worker thread would terminate the program, so it is handed to the caller
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error == nullptr) error = std::current_exception();
+    }
+}
@@ -2,7 +2,7 @@
 
 #include <cmath>
 
-Wang::Wang(Graph &G, float c, uint seed, count boostLevel, Mode mode) : n(G.getN()), c(c), boostLevel(boostLevel) {
+Wang::Wang(Graph &G, float c, uint seed, count boostLevel, Mode mode, QueryForestType queryForestType) : n(G.getN()), c(c), boostLevel(boostLevel) {
     switch (mode) {
         case pHeu:
             p = (1 - std::pow(0.5, boostLevel));
@@ -21,19 +21,17 @@ Wang::Wang(Graph &G, float c, uint seed, count boostLevel, Mode mode) : n(G.getN
     }
 
     cutSet = std::make_unique<CutSet>(n, boostLevel, numLevels, seed, adjacencyTrees);
+    //The number of levels is only enough for this many boost lines
+    cutSet->setMinBoostLevel(boostLevel);
     linkCutTrees = std::make_unique<LinkCutTrees>(n);
-    queryForest = std::make_unique<QueryForestAVL>(n);
+    queryForest = QueryForest::create(queryForestType, n);
 
     adjacencyTrees.resize(n);
 
-    for(node u = 0; u < n; u++){
-        for(node v : G.getNeighbors(u)){
-            if(v > u) addEdge(u, v);
-        }
-    }
+    build(G);
 }
 
-Wang::Wang(count n, float c, uint seed, count boostLevel, Mode mode) : n(n), c(c), boostLevel(boostLevel) {
+Wang::Wang(count n, float c, uint seed, count boostLevel, Mode mode, QueryForestType queryForestType) : n(n), c(c), boostLevel(boostLevel) {
     switch (mode) {
         case pHeu:
             p = (1 - std::pow(0.5, boostLevel));
@@ -52,8 +50,10 @@ Wang::Wang(count n, float c, uint seed, count boostLevel, Mode mode) : n(n), c(c
     }
 
     cutSet = std::make_unique<CutSet>(n, boostLevel, numLevels, seed, adjacencyTrees);
+    //The number of levels is only enough for this many boost lines
+    cutSet->setMinBoostLevel(boostLevel);
     linkCutTrees = std::make_unique<LinkCutTrees>(n);
-    queryForest = std::make_unique<QueryForestAVL>(n);
+    queryForest = QueryForest::create(queryForestType, n);
 
     adjacencyTrees.resize(n);
 }
@@ -141,6 +141,30 @@ void Wang::searchAndInsert(node v, count level) {
     }
 }
 
+void Wang::build(const Graph &G) {
+    std::vector<edge> edges;
+    edges.reserve(G.getM());
+    for(node u = 0; u < n; u++){
+        for(node v : G.getNeighbors(u)){
+            if(v > u){
+                adjacencyTrees[u].insert(v, false);
+                adjacencyTrees[v].insert(u, false);
+                edges.push_back({u, v});
+            }
+        }
+    }
+    //There are no tree edges yet, so this only hashes the edges
+    cutSet->addEdgesToSet(edges);
+
+    //Like addEdge every edge connecting two components becomes a tree edge on all levels
+    std::vector<edge> forest = G.spanningForest();
+    cutSet->buildTreeEdges(forest, std::vector<count>(forest.size(), 0));
+    queryForest->addForest(forest);
+    for(edge e : forest) linkCutTrees->link(e.v, e.w, 0);
+
+    sanityCheck();
+}
+
 void Wang::sanityCheck() {
 #ifndef NDEBUG
 
@@ -112,7 +112,7 @@ TEST(CutSet, testConnectivityCorrectness){
         int insertionLevel = dis(rng) % numLevels;
         edgeList.push_back({{u, v}, insertionLevel});
 
-        for(int j = insertionLevel; j < numLevels; j++) dTrees[j].addEdge(u, v);
+        for(count j = insertionLevel; j < numLevels; j++) dTrees[j].addEdge(u, v);
         cutSet.makeTreeEdge({u, v}, insertionLevel);
 
         checkConnectivityEquality(n, numLevels, dTrees, cutSet);
@@ -126,7 +126,7 @@ TEST(CutSet, testConnectivityCorrectness){
         int insertionLevel = dis(rng) % numLevels;
         edgeList.push_back({{u, v}, insertionLevel});
 
-        for(int j = insertionLevel; j < numLevels; j++) dTrees[j].addEdge(u, v);
+        for(count j = insertionLevel; j < numLevels; j++) dTrees[j].addEdge(u, v);
         cutSet.makeTreeEdge({u, v}, insertionLevel);
 
         checkConnectivityEquality(n, numLevels, dTrees, cutSet);
@@ -137,7 +137,7 @@ TEST(CutSet, testConnectivityCorrectness){
         std::pair<edge, int> e = edgeList.back();
         edgeList.pop_back();
 
-        for(int j = e.second; j < numLevels; j++){
+        for(count j = e.second; j < numLevels; j++){
             dTrees[j].deleteEdge(e.first.v, e.first.w);
         }
         cutSet.deleteEdge(e.first);
@@ -337,4 +337,646 @@ TEST(CutSet, countSuccessfulSearchesFullyDynamic){
 
     std::cout << "Number of searches:  " << searches << "\n";
     std::cout << "Number of successes: " << successes << "\n";
-}
\ No newline at end of file
+}
+
+//Builds the same graph with both encodings and checks that every search finds the same edge
+void checkEncodingsMatch(uint boostLevel){
+    uint n = 200;
+    uint numLevels = 6;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+
+    CutSet cumulative(n, boostLevel, numLevels, 42, adjacencyTrees, SketchEncoding::cumulative);
+    CutSet delta(n, boostLevel, numLevels, 42, adjacencyTrees, SketchEncoding::delta);
+
+    std::vector<edge> edgeList;
+
+    for(count i = 0; i < n; i++){
+        for(count j = i+1; j < n; j++){
+            if(dis(rng) % n < 4){
+                edgeList.push_back({i, j});
+                adjacencyTrees[i].insert(j, false);
+                adjacencyTrees[j].insert(i, false);
+                cumulative.addEdgeToSet({i, j});
+                delta.addEdgeToSet({i, j});
+                if(cumulative.compRepresentative(i, numLevels - 1) != cumulative.compRepresentative(j, numLevels - 1)){
+                    count level = dis(rng) % numLevels;
+                    cumulative.makeTreeEdge({i, j}, level);
+                    delta.makeTreeEdge({i, j}, level);
+                }
+            }
+        }
+    }
+
+    //Delete half of the edges again
+    for(count i = 0; i < edgeList.size(); i += 2){
+        edge e = edgeList[i];
+        adjacencyTrees[e.v].remove(e.w);
+        adjacencyTrees[e.w].remove(e.v);
+        cumulative.deleteEdge(e);
+        delta.deleteEdge(e);
+    }
+
+    //Both encodings have to find exactly the same edges
+    count found = 0;
+    for(count level = 0; level < numLevels; level++){
+        for(node v = 0; v < n; v++){
+            edge e = cumulative.search(v, level);
+            EXPECT_EQ(e, delta.search(v, level));
+            if(e != noEdge) found++;
+        }
+    }
+    EXPECT_GT(found, 0);
+}
+
+TEST(CutSet, deltaEncodingMatchesCumulative){
+    checkEncodingsMatch(2);
+    //Boost levels above 4 use the sketch loops without a fixed number of lines
+    checkEncodingsMatch(6);
+}
+
+TEST(CutSet, parallelLevelsMatchSerial){
+    uint n = 200;
+    uint numLevels = 40;
+    uint boostLevel = 2;
+
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+
+    CutSet serial(n, boostLevel, numLevels, 42, adjacencyTrees);
+    //Building the levels in parallel must give the same hash functions as building them serially
+    CutSet parallel(n, boostLevel, numLevels, 42, adjacencyTrees, SketchEncoding::delta, 4);
+
+    std::vector<edge> edgeList;
+
+    for(count i = 0; i < n; i++){
+        for(count j = i+1; j < n; j++){
+            if(dis(rng) % n < 4){
+                edgeList.push_back({i, j});
+                adjacencyTrees[i].insert(j, false);
+                adjacencyTrees[j].insert(i, false);
+                serial.addEdgeToSet({i, j});
+                parallel.addEdgeToSet({i, j});
+                if(serial.compRepresentative(i, numLevels - 1) != serial.compRepresentative(j, numLevels - 1)){
+                    count level = dis(rng) % numLevels;
+                    serial.makeTreeEdge({i, j}, level);
+                    parallel.makeTreeEdge({i, j}, level);
+                }
+            }
+        }
+    }
+
+    //Delete half of the edges again, which also cuts tree edges
+    for(count i = 0; i < edgeList.size(); i += 2){
+        edge e = edgeList[i];
+        adjacencyTrees[e.v].remove(e.w);
+        adjacencyTrees[e.w].remove(e.v);
+        serial.deleteEdge(e);
+        parallel.deleteEdge(e);
+    }
+
+    for(count level = 0; level < numLevels; level++){
+        for(node v = 0; v < n; v++){
+            EXPECT_EQ(serial.compSize(v, level), parallel.compSize(v, level));
+            EXPECT_EQ(serial.search(v, level), parallel.search(v, level));
+        }
+    }
+}
+
+TEST(CutSet, batchedUpdatesMatchSingleUpdates){
+    uint n = 200;
+    uint numLevels = 6;
+    uint boostLevel = 2;
+
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+
+    CutSet single(n, boostLevel, numLevels, 42, adjacencyTrees);
+    CutSet batched(n, boostLevel, numLevels, 42, adjacencyTrees);
+
+    //Build a spanning forest first so that the batches hit nonempty ET trees
+    for(node v = 1; v < n; v++){
+        if(dis(rng) % 4 == 0) continue;
+        edge e = {dis(rng) % v, v};
+        count level = dis(rng) % numLevels;
+        adjacencyTrees[e.v].insert(e.w, false);
+        adjacencyTrees[e.w].insert(e.v, false);
+        single.addEdgeToSet(e);
+        batched.addEdgeToSet(e);
+        single.makeTreeEdge(e, level);
+        batched.makeTreeEdge(e, level);
+    }
+
+    std::vector<edge> batch;
+    for(count i = 0; i < n; i++){
+        for(count j = i+1; j < n; j++){
+            if(!adjacencyTrees[i].contains(j) && dis(rng) % n < 3) batch.push_back({j, i});
+        }
+    }
+
+    for(edge e : batch){
+        adjacencyTrees[e.v].insert(e.w, false);
+        adjacencyTrees[e.w].insert(e.v, false);
+        single.addEdgeToSet(e);
+    }
+    batched.addEdgesToSet(batch);
+
+    auto compare = [&](){
+        for(count level = 0; level < numLevels; level++){
+            for(node v = 0; v < n; v++){
+                EXPECT_EQ(single.compSize(v, level), batched.compSize(v, level));
+                EXPECT_EQ(single.search(v, level), batched.search(v, level));
+            }
+        }
+    };
+    compare();
+
+    //Delete every third edge, including tree edges
+    std::vector<edge> deletions;
+    for(node v = 0; v < n; v++){
+        for(std::pair<node, bool> neighbour : adjacencyTrees[v].getSortedSet()){
+            if(v < neighbour.first && dis(rng) % 3 == 0) deletions.push_back({v, neighbour.first});
+        }
+    }
+
+    for(edge e : deletions){
+        adjacencyTrees[e.v].remove(e.w);
+        adjacencyTrees[e.w].remove(e.v);
+        single.deleteEdge(e);
+    }
+    batched.deleteEdges(deletions);
+
+    compare();
+}
+
+TEST(CutSet, deletingEveryEdgeEmptiesSketches){
+    uint n = 100;
+    uint numLevels = 5;
+    uint boostLevel = 3;
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSet cutset(n, boostLevel, numLevels, 42, adjacencyTrees);
+
+    //Insert and delete in several rounds so that freed signatures get reused for other edges
+    for(count round = 0; round < 3; round++){
+        std::vector<edge> edgeList;
+        for(count i = 0; i < n; i++){
+            for(count j = i+1; j < n; j++){
+                if(dis(rng) % n < 5){
+                    edgeList.push_back({j, i});
+                    adjacencyTrees[i].insert(j, false);
+                    adjacencyTrees[j].insert(i, false);
+                    cutset.addEdgeToSet({j, i});
+                }
+            }
+        }
+
+        for(edge e : edgeList){
+            adjacencyTrees[e.v].remove(e.w);
+            adjacencyTrees[e.w].remove(e.v);
+            cutset.deleteEdge(e);
+        }
+
+        for(count level = 0; level < numLevels; level++){
+            for(node v = 0; v < n; v++) EXPECT_EQ(cutset.search(v, level), noEdge);
+        }
+    }
+}
+
+TEST(CutSet, searchOnlyReturnsCuttingEdges){
+    uint n = 300;
+    uint numLevels = 4;
+    uint boostLevel = 4;
+
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSet cutset(n, boostLevel, numLevels, 42, adjacencyTrees);
+
+    for(count i = 0; i < n; i++){
+        for(count j = i+1; j < n; j++){
+            if(dis(rng) % n < 6){
+                adjacencyTrees[i].insert(j, false);
+                adjacencyTrees[j].insert(i, false);
+                cutset.addEdgeToSet({i, j});
+                if(cutset.compRepresentative(i, numLevels - 1) != cutset.compRepresentative(j, numLevels - 1)){
+                    cutset.makeTreeEdge({i, j}, dis(rng) % numLevels);
+                }
+            }
+        }
+    }
+
+    //Slots holding several edges must be rejected by their fingerprints, so every result has to be a real cutting edge
+    count found = 0;
+    for(count level = 0; level < numLevels; level++){
+        for(node v = 0; v < n; v++){
+            edge e = cutset.search(v, level);
+            if(e == noEdge) continue;
+
+            found++;
+            EXPECT_TRUE(adjacencyTrees[e.v].contains(e.w));
+            node rep = cutset.compRepresentative(v, level);
+            EXPECT_NE(cutset.compRepresentative(e.v, level) == rep, cutset.compRepresentative(e.w, level) == rep);
+        }
+    }
+    EXPECT_GT(found, 0);
+}
+
+TEST(CutSet, searchManyFindsDistinctCuttingEdges){
+    uint n = 300;
+    uint numLevels = 3;
+    uint boostLevel = 4;
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSet cutset(n, boostLevel, numLevels, 42, adjacencyTrees);
+
+    for(count i = 0; i < n; i++){
+        for(count j = i+1; j < n; j++){
+            if(dis(rng) % n < 6){
+                adjacencyTrees[i].insert(j, false);
+                adjacencyTrees[j].insert(i, false);
+                cutset.addEdgeToSet({i, j});
+                if(cutset.compRepresentative(i, numLevels - 1) != cutset.compRepresentative(j, numLevels - 1)){
+                    cutset.makeTreeEdge({i, j}, dis(rng) % numLevels);
+                }
+            }
+        }
+    }
+
+    count moreThanOne = 0;
+    for(count level = 0; level < numLevels; level++){
+        for(node v = 0; v < n; v++){
+            std::vector<edge> edges = cutset.searchMany(v, level, 5);
+            EXPECT_LE(edges.size(), 5);
+            //searchMany checks a superset of the slots search looks at
+            if(cutset.search(v, level) != noEdge){ EXPECT_FALSE(edges.empty()); }
+            if(edges.size() > 1) moreThanOne++;
+
+            node rep = cutset.compRepresentative(v, level);
+            for(count i = 0; i < edges.size(); i++){
+                edge e = edges[i];
+                EXPECT_TRUE(adjacencyTrees[e.v].contains(e.w));
+                EXPECT_NE(cutset.compRepresentative(e.v, level) == rep, cutset.compRepresentative(e.w, level) == rep);
+                for(count j = 0; j < i; j++) EXPECT_FALSE(edges[j] == e);
+            }
+        }
+    }
+    EXPECT_GT(moreThanOne, 0);
+}
+
+TEST(CutSet, searchStatistics){
+    uint n = 100;
+    uint numLevels = 3;
+    uint boostLevel = 2;
+
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSet cutset(n, boostLevel, numLevels, 42, adjacencyTrees);
+
+    for(count i = 0; i < n; i++){
+        for(count j = i+1; j < n; j++){
+            if(dis(rng) % n < 4){
+                adjacencyTrees[i].insert(j, false);
+                adjacencyTrees[j].insert(i, false);
+                cutset.addEdgeToSet({i, j});
+            }
+        }
+    }
+
+    //Nothing is counted while statistics are off
+    cutset.search(0, 0);
+    EXPECT_EQ(cutset.getSearchStats(0, 0).searches, 0);
+
+    cutset.setSearchStatsEnabled(true);
+
+    //Nor are searches that ask not to be recorded
+    cutset.search(0, 0, false);
+    EXPECT_EQ(cutset.getSearchStats(0, 0).searches, 0);
+
+    count successes = 0;
+    for(count level = 0; level < numLevels; level++){
+        for(node v = 0; v < n; v++){
+            if(cutset.search(v, level) != noEdge) successes++;
+        }
+    }
+
+    count countedSuccesses = 0;
+    for(count level = 0; level < numLevels; level++){
+        EXPECT_EQ(cutset.getSearchStats(level, 0).searches, n);
+        for(count line = 0; line < boostLevel; line++){
+            CutSet::SearchStats stats = cutset.getSearchStats(level, line);
+            //Every search that looks at a line ends in exactly one of the three outcomes
+            EXPECT_EQ(stats.searches, stats.empty + stats.rejected + stats.successes);
+            countedSuccesses += stats.successes;
+        }
+    }
+    EXPECT_EQ(successes, countedSuccesses);
+
+    cutset.resetSearchStats();
+    EXPECT_EQ(cutset.getSearchStats(1, 1).searches, 0);
+}
+
+//Cached and uncached roots have to agree through links and cuts on every level
+void checkRootCacheMatchesUncached(ETBalancing balancing){
+    uint n = 200;
+    uint numLevels = 4;
+    uint boostLevel = 1;
+
+    std::mt19937 rng(31);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSet uncached(n, boostLevel, numLevels, 42, adjacencyTrees, SketchEncoding::delta, 1, balancing);
+    CutSet cached(n, boostLevel, numLevels, 42, adjacencyTrees, SketchEncoding::delta, 1, balancing);
+    cached.setRootCacheEnabled(true);
+
+    auto checkRoots = [&](){
+        for(count j = 0; j < 20; j++){
+            node v = dis(rng) % n, w = dis(rng) % n;
+            count level = dis(rng) % numLevels;
+            EXPECT_EQ(cached.compSize(v, level), uncached.compSize(v, level));
+            //Long root walks reshape splay trees, so the two forests may pick different roots and only have to agree on the components
+            EXPECT_EQ(cached.compRepresentative(v, level) == cached.compRepresentative(w, level),
+                      uncached.compRepresentative(v, level) == uncached.compRepresentative(w, level));
+        }
+    };
+
+    std::vector<edge> edgeList;
+    for(count i = 0; i < 4 * n; i++){
+        node u = dis(rng) % n, v = dis(rng) % n;
+        if(u == v || adjacencyTrees[u].contains(v)) continue;
+        adjacencyTrees[u].insert(v, false);
+        adjacencyTrees[v].insert(u, false);
+        cached.addEdgeToSet({u, v});
+        uncached.addEdgeToSet({u, v});
+        edgeList.push_back({u, v});
+        if(uncached.compRepresentative(u, numLevels - 1) != uncached.compRepresentative(v, numLevels - 1)){
+            count level = dis(rng) % numLevels;
+            cached.makeTreeEdge({u, v}, level);
+            uncached.makeTreeEdge({u, v}, level);
+        }
+        checkRoots();
+    }
+
+    //Deleting edges cuts trees, which has to invalidate the cached roots of both halves
+    for(count i = 0; i < edgeList.size(); i += 2){
+        edge e = edgeList[i];
+        adjacencyTrees[e.v].remove(e.w);
+        adjacencyTrees[e.w].remove(e.v);
+        cached.deleteEdge(e);
+        uncached.deleteEdge(e);
+        checkRoots();
+    }
+
+    count hits = 0, misses = 0;
+    for(count level = 0; level < numLevels; level++){
+        hits += cached.getRootCacheStats(level).hits;
+        misses += cached.getRootCacheStats(level).misses;
+        EXPECT_EQ(uncached.getRootCacheStats(level).hits + uncached.getRootCacheStats(level).misses, 0);
+    }
+    EXPECT_GT(hits, 0);
+    EXPECT_GT(misses, 0);
+}
+
+TEST(CutSet, rootCacheMatchesUncached){
+    checkRootCacheMatchesUncached(ETBalancing::avl);
+    checkRootCacheMatchesUncached(ETBalancing::splay);
+}
+
+//A cut or link gives the trees it touches new versions, cached roots of the old trees have to be looked up again
+void checkStaleRootsAreRejected(ETBalancing balancing){
+    uint n = 6;
+    uint numLevels = 1;
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSet cutset(n, 1, numLevels, 42, adjacencyTrees, SketchEncoding::delta, 1, balancing);
+    cutset.setRootCacheEnabled(true);
+
+    //A path 0 - 1 - ... - 5
+    for(node v = 0; v + 1 < n; v++){
+        adjacencyTrees[v].insert(v + 1, false);
+        adjacencyTrees[v + 1].insert(v, false);
+        cutset.addEdgeToSet({v, v + 1});
+        cutset.makeTreeEdge({v, v + 1}, 0);
+    }
+
+    //Sizes count the 2 * (k - 1) tour edges of a tree with k vertices
+    count whole = 2 * (n - 1), half = 4;
+    auto misses = [&](){ return cutset.getRootCacheStats(0).misses; };
+    auto hits = [&](){ return cutset.getRootCacheStats(0).hits; };
+
+    EXPECT_EQ(cutset.compSize(0, 0), whole);
+    EXPECT_EQ(cutset.compSize(5, 0), whole);
+    count missesBefore = misses(), hitsBefore = hits();
+    EXPECT_EQ(cutset.compSize(0, 0), whole);
+    EXPECT_EQ(cutset.compSize(5, 0), whole);
+    EXPECT_EQ(hits(), hitsBefore + 2);
+    EXPECT_EQ(misses(), missesBefore);
+
+    //Both halves are new trees, whichever of them kept the old root handle
+    cutset.makeNonTreeEdge({2, 3});
+    missesBefore = misses();
+    EXPECT_EQ(cutset.compSize(0, 0), half);
+    EXPECT_EQ(cutset.compSize(5, 0), half);
+    EXPECT_NE(cutset.compRepresentative(0, 0), cutset.compRepresentative(5, 0));
+    EXPECT_EQ(misses(), missesBefore + 2);
+
+    //Linking them again invalidates the roots of both halves once more
+    cutset.makeTreeEdge({2, 3}, 0);
+    missesBefore = misses();
+    EXPECT_EQ(cutset.compSize(0, 0), whole);
+    EXPECT_EQ(cutset.compSize(5, 0), whole);
+    EXPECT_EQ(cutset.compRepresentative(0, 0), cutset.compRepresentative(5, 0));
+    EXPECT_EQ(misses(), missesBefore + 2);
+
+    //Checks look at the trees without counting as lookups
+    missesBefore = misses();
+    hitsBefore = hits();
+    EXPECT_TRUE(cutset.checkConnected(0, 5, 0));
+    EXPECT_EQ(cutset.checkCompSize(0, 0), whole);
+    cutset.search(0, 0, false);
+    EXPECT_EQ(hits(), hitsBefore);
+    EXPECT_EQ(misses(), missesBefore);
+}
+
+TEST(CutSet, staleRootCacheEntriesAreRejected){
+    checkStaleRootsAreRejected(ETBalancing::avl);
+    checkStaleRootsAreRejected(ETBalancing::splay);
+}
+
+TEST(CutSet, changingLevelBoostLevels){
+    uint n = 200;
+    uint numLevels = 4;
+    uint boostLevel = 3;
+
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSet reference(n, boostLevel, numLevels, 42, adjacencyTrees);
+    CutSet changed(n, boostLevel, numLevels, 42, adjacencyTrees);
+
+    std::vector<edge> edgeList;
+
+    for(count i = 0; i < n; i++){
+        for(count j = i+1; j < n; j++){
+            if(dis(rng) % n < 4){
+                edgeList.push_back({i, j});
+                adjacencyTrees[i].insert(j, false);
+                adjacencyTrees[j].insert(i, false);
+                reference.addEdgeToSet({i, j});
+                changed.addEdgeToSet({i, j});
+                if(reference.compRepresentative(i, numLevels - 1) != reference.compRepresentative(j, numLevels - 1)){
+                    count level = dis(rng) % numLevels;
+                    reference.makeTreeEdge({i, j}, level);
+                    changed.makeTreeEdge({i, j}, level);
+                }
+            }
+        }
+    }
+
+    for(count level = 0; level < numLevels; level++) changed.setLevelBoostLevel(level, 1);
+    EXPECT_EQ(changed.getLevelBoostLevel(0), 1);
+
+    //Update the levels while they only use a single line
+    for(count i = 0; i < edgeList.size(); i += 2){
+        edge e = edgeList[i];
+        adjacencyTrees[e.v].remove(e.w);
+        adjacencyTrees[e.w].remove(e.v);
+        reference.deleteEdge(e);
+        changed.deleteEdge(e);
+    }
+
+    for(count level = 0; level < numLevels; level++){
+        for(node v = 0; v < n; v++){
+            edge e = changed.search(v, level);
+            if(e == noEdge) continue;
+            node rep = changed.compRepresentative(v, level);
+            EXPECT_NE(changed.compRepresentative(e.v, level) == rep, changed.compRepresentative(e.w, level) == rep);
+        }
+    }
+
+    //Lines that are enabled again are rebuilt, so both cutsets have to agree once more
+    for(count level = 0; level < numLevels; level++) changed.setLevelBoostLevel(level, boostLevel);
+    for(count level = 0; level < numLevels; level++){
+        for(node v = 0; v < n; v++){
+            EXPECT_EQ(reference.search(v, level), changed.search(v, level));
+        }
+    }
+}
+
+//Adaptation lowers every level as far as the floor allows, but not further
+void checkAdaptiveBoostLevels(count minBoostLevel){
+    uint n = 200;
+    uint numLevels = 3;
+    uint boostLevel = 3;
+
+    std::mt19937 rng(29);
+    std::uniform_int_distribution<int> dis(0, bigNum);
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSet cutset(n, boostLevel, numLevels, 42, adjacencyTrees);
+
+    for(count i = 0; i < n; i++){
+        for(count j = i+1; j < n; j++){
+            if(dis(rng) % n < 4){
+                adjacencyTrees[i].insert(j, false);
+                adjacencyTrees[j].insert(i, false);
+                cutset.addEdgeToSet({i, j});
+                if(cutset.compRepresentative(i, numLevels - 1) != cutset.compRepresentative(j, numLevels - 1) && dis(rng) % 4 == 0){
+                    cutset.makeTreeEdge({i, j}, 1 + dis(rng) % (numLevels - 1));
+                }
+            }
+        }
+    }
+
+    //With a tolerated failure rate this high the extra lines are never worth it
+    cutset.setMinBoostLevel(minBoostLevel);
+    cutset.setAdaptiveBoost(0.9);
+    for(count round = 0; round < 10; round++){
+        for(count level = 0; level < numLevels; level++){
+            for(node v = 0; v < n; v++){
+                edge e = cutset.search(v, level);
+                if(e == noEdge) continue;
+                EXPECT_TRUE(adjacencyTrees[e.v].contains(e.w));
+                node rep = cutset.compRepresentative(v, level);
+                EXPECT_NE(cutset.compRepresentative(e.v, level) == rep, cutset.compRepresentative(e.w, level) == rep);
+            }
+        }
+    }
+
+    for(count level = 0; level < numLevels; level++) EXPECT_EQ(cutset.getLevelBoostLevel(level), minBoostLevel);
+}
+
+TEST(CutSet, adaptiveBoostLevels){
+    checkAdaptiveBoostLevels(1);
+}
+
+TEST(CutSet, adaptiveBoostLevelsStopAtFloor){
+    checkAdaptiveBoostLevels(2);
+}
+
+class CutSetSlotTest : public CutSet {
+public:
+    using CutSet::CutSet;
+    using CutSet::getTreeRoot;
+    using CutSet::getTreeFirstSlot;
+    using CutSet::getTreeSketch;
+};
+
+TEST(CutSet, emptySlotsOfSmallTreesAreSkipped){
+    uint n = 1000;
+    uint numLevels = 2;
+    uint boostLevel = 2;
+
+    std::vector<AVLTree<node, bool>> adjacencyTrees(n);
+    CutSetSlotTest cutset(n, boostLevel, numLevels, 42, adjacencyTrees);
+
+    //Paths of 5 nodes with a few extra edges to the next path
+    for(node v = 0; v + 1 < n; v++){
+        if(v % 5 == 4){
+            if(v + 3 >= n) continue;
+            adjacencyTrees[v].insert(v + 3, false);
+            adjacencyTrees[v + 3].insert(v, false);
+            cutset.addEdgeToSet({v, v + 3});
+            continue;
+        }
+        adjacencyTrees[v].insert(v + 1, false);
+        adjacencyTrees[v + 1].insert(v, false);
+        cutset.addEdgeToSet({v, v + 1});
+        cutset.makeTreeEdge({v, v + 1}, 0);
+    }
+
+    count skipping = 0;
+    for(count level = 0; level < numLevels; level++){
+        for(node v = 0; v < n; v++){
+            address root = cutset.getTreeRoot(level, v);
+            count first = cutset.getTreeFirstSlot(v, level, root);
+            if(first > 0) skipping++;
+
+            //The skipped slots really are empty
+            SketchView sketch = cutset.getTreeSketch(v, level, root);
+            for(count line = 0; line < 2 * boostLevel; line++){
+                for(count slot = 0; slot < first; slot++) EXPECT_EQ(sketch(line, slot), noSketchWord);
+            }
+        }
+    }
+    //A tree with a handful of edges almost never has an edge in the sparsest slots
+    EXPECT_GT(skipping, n);
+}
@@ -0,0 +1,205 @@
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+
+#include "ETForestBTree.hpp"
+#include "QueryForestBTree.hpp"
+//To check connected components
+#include "PrimitiveStructures/RootedTree.hpp"
+
+class ETForestBTreeTest : public ETForestBTree {
+public:
+    using ETForestBTree::ETForestBTree;
+
+    count getHeight(BlockIndex b) const {
+        return blocks[b].height;
+    }
+};
+
+//Checks that every tree of the forest is a closed Euler tour whose size matches the tour
+void checkTours(const ETForestBTree &etForest, const std::map<std::pair<node, node>, ETForestBTree::Handle> &edges){
+    std::set<ETForestBTree::BlockIndex> roots;
+    for(auto [e, handle] : edges){
+        ETForestBTree::BlockIndex root = etForest.getRoot(handle);
+        if(not roots.insert(root).second) continue;
+
+        std::vector<std::pair<node, node>> tour = etForest.getTour(handle);
+        EXPECT_EQ(tour.size(), etForest.getSize(root));
+        EXPECT_EQ(tour[0].first, tour.back().second);
+        for(count i = 0; i + 1 < tour.size(); i++) EXPECT_EQ(tour[i].second, tour[i + 1].first);
+    }
+}
+
+//Random links and cuts on @n vertices, checked against a RootedForest
+void checkFullyDynamic(count n, count steps){
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    ETForestBTree etForest(n);
+    RootedForest rootedForest(n);
+
+    //Both directions of every tree edge with their handles
+    std::map<std::pair<node, node>, ETForestBTree::Handle> edges;
+    std::vector<std::pair<node, node>> treeEdges;
+
+    auto anyEdge = [&](node v){
+        auto it = edges.lower_bound({v, 0});
+        return (it != edges.end() && it->first.first == v) ? it->second : ETForestBTree::noHandle;
+    };
+
+    for(count i = 0; i < steps; i++){
+        if(treeEdges.size() < n / 2 || (treeEdges.size() < n - 1 && dis(rng) % 2 == 0)){
+            node v = dis(rng), w;
+            do w = dis(rng); while (rootedForest.getRoot(v) == rootedForest.getRoot(w));
+            rootedForest.link(v, w, 0);
+
+            std::pair<ETForestBTree::Handle, ETForestBTree::Handle> newEdges = etForest.insertETEdge(v, w, anyEdge(v), anyEdge(w));
+            edges[{v, w}] = newEdges.first;
+            edges[{w, v}] = newEdges.second;
+            treeEdges.emplace_back(v, w);
+        } else {
+            count index = dis(rng) % treeEdges.size();
+            auto [v, w] = treeEdges[index];
+            rootedForest.cutEdge(v, w);
+
+            etForest.deleteETEdge(edges[{v, w}], edges[{w, v}]);
+            edges.erase({v, w});
+            edges.erase({w, v});
+            treeEdges[index] = treeEdges.back();
+            treeEdges.pop_back();
+        }
+
+        if(i % 10 == 0) checkTours(etForest, edges);
+
+        //Vertices are connected iff their edges are in the same tree
+        for(count j = 0; j < 10; j++){
+            node u = dis(rng), v = dis(rng);
+            ETForestBTree::Handle uEdge = anyEdge(u), vEdge = anyEdge(v);
+            if(uEdge == ETForestBTree::noHandle || vEdge == ETForestBTree::noHandle) continue;
+            EXPECT_EQ(rootedForest.getRoot(u) == rootedForest.getRoot(v), etForest.getRoot(uEdge) == etForest.getRoot(vEdge));
+        }
+    }
+}
+
+TEST(ETForestBTree, fullyDynamic){
+    checkFullyDynamic(100, 1000);
+}
+
+TEST(ETForestBTree, fullyDynamicDeep){
+    //Large enough for trees of several levels of blocks
+    checkFullyDynamic(2000, 4000);
+}
+
+TEST(ETForestBTree, pathIsShallow){
+    count n = 10000;
+    ETForestBTreeTest etForest(n);
+
+    //The backward edge (v + 1, v) is the edge the next link starts from
+    std::vector<ETForestBTree::Handle> forward(n - 1), backward(n - 1);
+    for(node v = 0; v + 1 < n; v++){
+        ETForestBTree::Handle vEdge = (v == 0) ? ETForestBTree::noHandle : backward[v - 1];
+        std::tie(forward[v], backward[v]) = etForest.insertETEdge(v, v + 1, vEdge, ETForestBTree::noHandle);
+    }
+
+    ETForestBTree::BlockIndex root = etForest.getRoot(forward[0]);
+    EXPECT_EQ(etForest.getSize(root), 2 * (n - 1));
+    for(node v = 0; v + 1 < n; v++) EXPECT_EQ(etForest.getRoot(forward[v]), root);
+    //Every block below the root has at least minFanout children
+    EXPECT_LE(etForest.getHeight(root) + 1, std::ceil(std::log(2 * n) / std::log(ETForestBTree::minFanout)));
+    EXPECT_LE(etForest.getNumBytes(), ETForestBTree::projectNumBytes(2 * (n - 1)));
+}
+
+TEST(ETForestBTree, queryForest){
+    count n = 500;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    QueryForestBTree queryForest(n);
+    RootedForest rootedForest(n);
+    std::vector<std::pair<node, node>> treeEdges;
+
+    for(count i = 0; i < 3000; i++){
+        if(treeEdges.empty() || (treeEdges.size() < n - 1 && dis(rng) % 2 == 0)){
+            node v = dis(rng), w;
+            do w = dis(rng); while (rootedForest.getRoot(v) == rootedForest.getRoot(w));
+            rootedForest.link(v, w, 0);
+            queryForest.addEdge(v, w);
+            treeEdges.emplace_back(v, w);
+        } else {
+            count index = dis(rng) % treeEdges.size();
+            auto [v, w] = treeEdges[index];
+            rootedForest.cutEdge(v, w);
+            queryForest.deleteEdge(v, w);
+            treeEdges[index] = treeEdges.back();
+            treeEdges.pop_back();
+        }
+
+        EXPECT_EQ(queryForest.numberOfComponents(), n - treeEdges.size());
+        for(count j = 0; j < 10; j++){
+            node u = dis(rng), v = dis(rng);
+            bool connected = rootedForest.getRoot(u) == rootedForest.getRoot(v);
+            EXPECT_EQ(queryForest.query(u, v), connected);
+            EXPECT_EQ(queryForest.compRepresentative(u) == queryForest.compRepresentative(v), connected);
+        }
+    }
+}
+
+TEST(ETForestBTree, buildForest){
+    count n = 5000;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    //A random forest, most vertices hang off a smaller one
+    RootedForest rootedForest(n);
+    std::vector<edge> forestEdges;
+    for(node v = 1; v < n; v++){
+        if(dis(rng) % 100 == 0) continue;
+        node u = dis(rng) % v;
+        rootedForest.link(v, u, 0);
+        forestEdges.push_back({v, u});
+    }
+
+    ETForestBTreeTest etForest(n);
+    std::vector<std::pair<ETForestBTree::Handle, ETForestBTree::Handle>> newEdges = etForest.buildForest(forestEdges);
+
+    std::map<std::pair<node, node>, ETForestBTree::Handle> edges;
+    for(count k = 0; k < forestEdges.size(); k++){
+        auto [v, w] = forestEdges[k];
+        EXPECT_EQ(etForest.getV(newEdges[k].first), v);
+        EXPECT_EQ(etForest.getW(newEdges[k].first), w);
+        EXPECT_EQ(etForest.getV(newEdges[k].second), w);
+        edges[{v, w}] = newEdges[k].first;
+        edges[{w, v}] = newEdges[k].second;
+    }
+    checkTours(etForest, edges);
+
+    //Blocks are filled evenly, so the trees are as shallow as the fullest blocks allow
+    ETForestBTree::BlockIndex root = etForest.getRoot(newEdges[0].first);
+    EXPECT_LE(etForest.getHeight(root) + 1, std::ceil(std::log(etForest.getSize(root)) / std::log(ETForestBTree::minFanout)));
+
+    //The built trees take cuts like any other
+    for(count k = 0; k < forestEdges.size(); k += 3){
+        etForest.deleteETEdge(newEdges[k].first, newEdges[k].second);
+        rootedForest.cutEdge(forestEdges[k].v, forestEdges[k].w);
+        edges.erase({forestEdges[k].v, forestEdges[k].w});
+        edges.erase({forestEdges[k].w, forestEdges[k].v});
+    }
+    checkTours(etForest, edges);
+    for(count i = 0; i < 1000; i++){
+        count k = dis(rng) % forestEdges.size(), l = dis(rng) % forestEdges.size();
+        if(k % 3 == 0 || l % 3 == 0) continue;
+        EXPECT_EQ(rootedForest.getRoot(forestEdges[k].v) == rootedForest.getRoot(forestEdges[l].v),
+                  etForest.getRoot(newEdges[k].first) == etForest.getRoot(newEdges[l].first));
+    }
+}
+
+TEST(ETForestBTree, tooManyEdgesForHandles){
+    //2 * (n - 1) edges would not be addressable by 32 bit handles, this must fail in release builds as well
+    EXPECT_THROW(ETForestBTree((count(1) << 31) + 1), std::length_error);
+    EXPECT_NO_THROW(ETForestBTree(count(1) << 31));
+}
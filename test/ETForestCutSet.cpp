@@ -1,8 +1,13 @@
 #include "gtest/gtest.h"
 
+#include <bit>
+#include <cmath>
 #include <deque>
 #include <random>
 #include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
 
 #include "ETForestCutSet.hpp"
 //To check connected components
@@ -18,26 +23,17 @@ public:
     FRIEND_TEST(ETForestCutSet, basicSplitTest);
     FRIEND_TEST(ETForestCutSet, largeJoinTest);
     FRIEND_TEST(ETForestCutSet, largeSplitTest);
-
-    class NodeTest : public Node {
-    public:
-        FRIEND_TEST(ETForestCutSet, basicJoinTest);
-        FRIEND_TEST(ETForestCutSet, basicSplitTest);
-        FRIEND_TEST(ETForestCutSet, largeJoinTest);
-        FRIEND_TEST(ETForestCutSet, largeSplitTest);
-
-        NodeTest(node pv, node pw) : Node(pv, pw, {}){}
-    };
 };
 
 TEST(ETForestCutSet, basicJoinTest){
     ETForestTest etForest;
 
-    ETForestTest::NodeTest node1(0,1), node2(1,2), node3(2,3), node4(3,4), node5(4,5), node6(5,6), node7(6,7);
+    std::vector<address> nodes;
+    for(node v = 0; v < 7; v++) nodes.push_back(etForest.allocateNode(v, v + 1));
 
-    ETForestTest::Node* join1 = etForest.join(&node1, &node3, &node2);
-    ETForestTest::Node* join2 = etForest.join(join1, &node5, &node4);
-    ETForestTest::Node* join3 = etForest.join(join2, &node7, &node6);
+    address join1 = etForest.join(nodes[0], nodes[2], nodes[1]);
+    address join2 = etForest.join(join1, nodes[4], nodes[3]);
+    address join3 = etForest.join(join2, nodes[6], nodes[5]);
 
     std::vector<std::pair<node, node>> sequence;
     etForest.writeTour(join3, &sequence);
@@ -53,13 +49,14 @@ TEST(ETForestCutSet, basicJoinTest){
 TEST(ETForestCutSet, basicSplitTest){
     ETForestTest etForest;
 
-    ETForestTest::NodeTest node1(0,1), node2(1,2), node3(2,3), node4(3,4), node5(4,5), node6(5,6), node7(6,7);
+    std::vector<address> nodes;
+    for(node v = 0; v < 7; v++) nodes.push_back(etForest.allocateNode(v, v + 1));
 
-    ETForestTest::Node* join1 = etForest.join(&node1, &node3, &node2);
-    ETForestTest::Node* join2 = etForest.join(join1, &node5, &node4);
-    ETForestTest::Node* join3 = etForest.join(join2, &node7, &node6);
+    address join1 = etForest.join(nodes[0], nodes[2], nodes[1]);
+    address join2 = etForest.join(join1, nodes[4], nodes[3]);
+    address join3 = etForest.join(join2, nodes[6], nodes[5]);
 
-    std::pair<address, address> splitResults = etForest.split(&node3);
+    std::pair<address, address> splitResults = etForest.split(nodes[2]);
 
     std::vector<std::pair<node, node>> sequence1, sequence2;
     etForest.writeTour(splitResults.first, &sequence1);
@@ -79,15 +76,15 @@ TEST(ETForestCutSet, basicSplitTest){
     }
 }
 
-void checkSequenceEquality(std::vector<std::vector<std::pair<node, node>>> &sequencesExpected, std::vector<std::vector<ETForestTest::NodeTest*>> &sequencesActual){
+void checkSequenceEquality(const ETForestCutSet &etForest, std::vector<std::vector<std::pair<node, node>>> &sequencesExpected, std::vector<std::vector<address>> &sequencesActual){
     EXPECT_EQ(sequencesActual.size(), sequencesExpected.size());
 
     for(count i = 0; i < sequencesExpected.size(); i++){
         EXPECT_EQ(sequencesExpected[i].size(), sequencesActual[i].size());
 
         for(count j = 0; j < sequencesExpected[i].size(); j++){
-            EXPECT_EQ(sequencesExpected[i][j].first, sequencesActual[i][j]->getV());
-            EXPECT_EQ(sequencesExpected[i][j].second, sequencesActual[i][j]->getW());
+            EXPECT_EQ(sequencesExpected[i][j].first, etForest.getV(sequencesActual[i][j]));
+            EXPECT_EQ(sequencesExpected[i][j].second, etForest.getW(sequencesActual[i][j]));
 
             if(j != 0){
                 EXPECT_EQ(sequencesExpected[i][j-1].second, sequencesExpected[i][j].first);
@@ -105,12 +102,12 @@ TEST(ETForestCutSet, largeJoinTest){
     ETForestTest etForest;
 
     std::vector<std::vector<std::pair<node, node>>> sequencesExpected;
-    std::vector<ETForestTest::Node*> sequencesActualRoots;
+    std::vector<address> sequencesActualRoots;
 
     //Generate the base sequences
     for(count i = 0; i < n; i++){
         sequencesExpected.push_back({{i, i+1}});
-        ETForestTest::Node* node = new ETForestTest::NodeTest(i,i+1);
+        address node = etForest.allocateNode(i,i+1);
         sequencesActualRoots.push_back(node);
     }
 
@@ -131,7 +128,7 @@ TEST(ETForestCutSet, largeJoinTest){
         sequencesExpected.pop_back();
 
         //Modify the actual sequences
-        ETForestTest::Node* newNode = new ETForestTest::NodeTest(connectEdge.first, connectEdge.second);
+        address newNode = etForest.allocateNode(connectEdge.first, connectEdge.second);
         sequencesActualRoots[p1] = etForest.join(sequencesActualRoots[p1], sequencesActualRoots[p2], newNode);
         sequencesActualRoots[p2] = sequencesActualRoots.back();
         sequencesActualRoots.pop_back();
@@ -159,13 +156,13 @@ TEST(ETForestCutSet, largeSplitTest){
     ETForestTest etForest;
 
     std::vector<std::vector<std::pair<node, node>>> sequencesExpected;
-    std::vector<ETForestTest::Node*> sequencesActualRoots;
-    std::vector<std::vector<ETForestTest::Node*>> sequenceActualNodes;
+    std::vector<address> sequencesActualRoots;
+    std::vector<std::vector<address>> sequenceActualNodes;
 
     //Generate the base sequences
     for(count i = 0; i < n; i++){
         sequencesExpected.push_back({{i, i+1}});
-        ETForestTest::Node* node = new ETForestTest::NodeTest(i,i+1);
+        address node = etForest.allocateNode(i,i+1);
         sequencesActualRoots.push_back(node);
         sequenceActualNodes.push_back({node});
     }
@@ -188,12 +185,12 @@ TEST(ETForestCutSet, largeSplitTest){
         sequencesExpected.pop_back();
 
         //Modify the actual sequences
-        ETForestTest::Node* newNode = new ETForestTest::NodeTest(connectEdge.first, connectEdge.second);
+        address newNode = etForest.allocateNode(connectEdge.first, connectEdge.second);
         sequencesActualRoots[p1] = etForest.join(sequencesActualRoots[p1], sequencesActualRoots[p2], newNode);
         sequencesActualRoots[p2] = sequencesActualRoots.back();
         sequencesActualRoots.pop_back();
         sequenceActualNodes[p1].push_back(newNode);
-        for(ETForestTest::Node* e : sequenceActualNodes[p2]) sequenceActualNodes[p1].push_back(e);
+        for(address e : sequenceActualNodes[p2]) sequenceActualNodes[p1].push_back(e);
         sequenceActualNodes[p2] = sequenceActualNodes.back();
         sequenceActualNodes.pop_back();
     }
@@ -211,7 +208,7 @@ TEST(ETForestCutSet, largeSplitTest){
         }
 
         auto splitResults = etForest.split(sequenceActualNodes[p1][p2]);
-        if(splitResults.first != nullptr){
+        if(splitResults.first != ETForestCutSet::noHandle){
             sequencesActualRoots[p1] = splitResults.first;
             sequencesActualRoots.push_back(splitResults.second);
             sequenceActualNodes.emplace_back();
@@ -253,12 +250,12 @@ TEST(ETForestCutSet, largeSplitTest){
         sequencesExpected.pop_back();
 
         //Modify the actual sequences
-        ETForestTest::Node* newNode = new ETForestTest::NodeTest(connectEdge.first, connectEdge.second);
+        address newNode = etForest.allocateNode(connectEdge.first, connectEdge.second);
         sequencesActualRoots[p1] = etForest.join(sequencesActualRoots[p1], sequencesActualRoots[p2], newNode);
         sequencesActualRoots[p2] = sequencesActualRoots.back();
         sequencesActualRoots.pop_back();
         sequenceActualNodes[p1].emplace_back(newNode);
-        for(ETForestTest::Node* e : sequenceActualNodes[p2]) sequenceActualNodes[p1].emplace_back(e);
+        for(address e : sequenceActualNodes[p2]) sequenceActualNodes[p1].emplace_back(e);
         sequenceActualNodes[p2] = sequenceActualNodes.back();
         sequenceActualNodes.pop_back();
 
@@ -352,8 +349,8 @@ TEST(ETForestCutSet, ETTreesIncremental){
 
         rootedForest.link(v,w,0);
 
-        address vEdge = nullptr;
-        address wEdge = nullptr;
+        address vEdge = ETForestCutSet::noHandle;
+        address wEdge = ETForestCutSet::noHandle;
 
         for(TestEdge e : edges){
             if(e.v1 == v) vEdge = e.ETEdge;
@@ -387,8 +384,8 @@ TEST(ETForestCutSet, ETForestFullyDynamic){
 
         rootedForest.link(v,w,0);
 
-        address vEdge = nullptr;
-        address wEdge = nullptr;
+        address vEdge = ETForestCutSet::noHandle;
+        address wEdge = ETForestCutSet::noHandle;
 
         for(TestEdge e : edges){
             if(e.v1 == v) vEdge = e.ETEdge;
@@ -412,8 +409,8 @@ TEST(ETForestCutSet, ETForestFullyDynamic){
 
         rootedForest.link(v,w,0);
 
-        address vEdge = nullptr;
-        address wEdge = nullptr;
+        address vEdge = ETForestCutSet::noHandle;
+        address wEdge = ETForestCutSet::noHandle;
 
         for(TestEdge e : edges){
             if(e.v1 == v) vEdge = e.ETEdge;
@@ -448,4 +445,263 @@ TEST(ETForestCutSet, ETForestFullyDynamic){
 
         testEulerTours(etForest, edges);
     }
-}
\ No newline at end of file
+}
+TEST(ETForestCutSet, deletedNodesAreRecycled){
+    count n = 100;
+    ETForestCutSet etForest(2, n);
+    count lognsqr = std::ceil(2.0 * std::log2(n)) + 1;
+    std::vector<sketchWord> sketch(4 * lognsqr, toSketchWord({1, 2}));
+
+    std::pair<address, address> first = etForest.insertETEdge(0, 1, ETForestCutSet::noHandle, ETForestCutSet::noHandle);
+    etForest.setTrackingData(first.first, sketch.data());
+    count numBytes = etForest.getNumBytes();
+    EXPECT_GT(numBytes, 0);
+
+    //The slots of the deleted nodes are handed out again, with cleared sketches
+    etForest.deleteETEdge(first.first, first.second);
+    std::pair<address, address> second = etForest.insertETEdge(2, 3, ETForestCutSet::noHandle, ETForestCutSet::noHandle);
+    EXPECT_EQ(etForest.getNumBytes(), numBytes);
+    EXPECT_TRUE((second.first == first.first && second.second == first.second) || (second.first == first.second && second.second == first.first));
+
+    SketchView accumulated = etForest.getAccumulatedSketch(etForest.getRoot(second.first));
+    for(count i = 0; i < 4; i++){
+        for(count j = 0; j < lognsqr; j++) EXPECT_EQ(accumulated(i, j), noSketchWord);
+    }
+}
+
+//Links, cuts and sketch updates on a forest with random sketches, checks that the aggregates and connectivity stay correct
+void checkAggregatesMatchTour(ETBalancing balancing){
+    count n = 100;
+    count lognsqr = std::ceil(2.0 * std::log2(n)) + 1;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    ETForestCutSet etForest(1, n, false, SketchEncoding::cumulative, balancing);
+    RootedForest rootedForest(n);
+
+    //Every ET edge carries a sketch of its own, the edges are stored with both directions
+    std::map<std::pair<node, node>, address> edges;
+    std::map<std::pair<node, node>, std::vector<sketchWord>> sketches;
+    std::vector<std::pair<node, node>> treeEdges;
+
+    auto anyEdge = [&](node v){
+        auto it = edges.lower_bound({v, 0});
+        return (it != edges.end() && it->first.first == v) ? it->second : ETForestCutSet::noHandle;
+    };
+
+    auto addEdge = [&](node v, node w){
+        std::pair<address, address> newEdges = etForest.insertETEdge(v, w, anyEdge(v), anyEdge(w));
+        edges[{v, w}] = newEdges.first;
+        edges[{w, v}] = newEdges.second;
+        sketches[{v, w}] = std::vector<sketchWord>(2 * lognsqr, toSketchWord({v, w}));
+        etForest.setTrackingData(newEdges.first, sketches[{v, w}].data());
+    };
+
+    for(count i = 0; i < 20 * n; i++){
+        //Several links, cuts and sketch updates happen before the aggregates are read again
+        if(treeEdges.size() < n / 2 || (treeEdges.size() < n - 1 && dis(rng) % 2 == 0)){
+            node v = dis(rng), w;
+            do w = dis(rng); while (rootedForest.getRoot(v) == rootedForest.getRoot(w));
+            rootedForest.link(v, w, 0);
+            addEdge(v, w);
+            treeEdges.emplace_back(v, w);
+        } else {
+            count index = dis(rng) % treeEdges.size();
+            auto [v, w] = treeEdges[index];
+            rootedForest.cutEdge(v, w);
+            etForest.deleteETEdge(edges[{v, w}], edges[{w, v}]);
+            edges.erase({v, w});
+            edges.erase({w, v});
+            sketches.erase({v, w});
+            treeEdges[index] = treeEdges.back();
+            treeEdges.pop_back();
+        }
+
+        if(not treeEdges.empty()){
+            auto [v, w] = treeEdges[dis(rng) % treeEdges.size()];
+            uint8_t startingLevel = dis(rng) % lognsqr;
+            sketchWord newEdge = toSketchWord({dis(rng), dis(rng)}), fingerprint = toSketchWord({dis(rng), dis(rng)});
+            std::vector<sketchWord> &sketch = sketches[{v, w}];
+            for(count j = startingLevel; j < lognsqr; j++){
+                sketch[j] ^= newEdge;
+                sketch[lognsqr + j] ^= fingerprint;
+            }
+            etForest.addEdgeToData(edges[{v, w}], newEdge, fingerprint, &startingLevel);
+        }
+
+        for(count j = 0; j < 10; j++){
+            node u = dis(rng), v = dis(rng);
+            address uEdge = anyEdge(u), vEdge = anyEdge(v);
+            if(uEdge == ETForestCutSet::noHandle || vEdge == ETForestCutSet::noHandle) continue;
+            EXPECT_EQ(rootedForest.getRoot(u) == rootedForest.getRoot(v), etForest.getRoot(uEdge) == etForest.getRoot(vEdge));
+        }
+
+        if(i % 5 != 0) continue;
+
+        //Every root aggregate is the xor of the sketches along its tour
+        for(auto [e, handle] : edges){
+            address root = etForest.getRoot(handle);
+            if(root != handle) continue;
+
+            std::vector<sketchWord> expected(2 * lognsqr, noSketchWord);
+            for(std::pair<node, node> tourEdge : etForest.getTour(root)){
+                auto it = sketches.find(tourEdge);
+                if(it == sketches.end()) continue;
+                for(count j = 0; j < 2 * lognsqr; j++) expected[j] ^= it->second[j];
+            }
+
+            SketchView accumulated = etForest.getAccumulatedSketch(root);
+            for(count j = 0; j < 2 * lognsqr; j++) EXPECT_EQ(accumulated(j / lognsqr, j % lognsqr), expected[j]);
+        }
+    }
+    //Deleted nodes are reused, so the forest never holds more than the 2 * (n - 1) nodes of a spanning tree
+    EXPECT_LE(etForest.getNumBytes(), ETForestCutSet::projectNumBytes(2 * (n - 1), 1, lognsqr, false));
+}
+
+TEST(ETForestCutSet, lazyAggregatesMatchTour){
+    checkAggregatesMatchTour(ETBalancing::avl);
+}
+
+TEST(ETForestCutSet, splayAggregatesMatchTour){
+    checkAggregatesMatchTour(ETBalancing::splay);
+}
+
+class ETForestDepthTest : public ETForestCutSet {
+public:
+    using ETForestCutSet::ETForestCutSet;
+
+    count depth(address e) const {
+        count d = 0;
+        for(; at(e).parent != noHandle; d++) e = at(e).parent;
+        return d;
+    }
+};
+
+TEST(ETForestCutSet, splayRootWalksStayShort){
+#ifdef NDEBUG
+    count n = 100000;
+#else //Debug builds check the whole tree after every link
+    count n = 3000;
+#endif //NDEBUG
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<count> dis(0, bigNum);
+
+    //Linking a path puts every new node on top, which leaves long spines below the root
+    ETForestDepthTest etForest(0, n, true, SketchEncoding::cumulative, ETBalancing::splay);
+    std::vector<address> handles;
+    address previous = ETForestCutSet::noHandle;
+    for(node v = 0; v + 1 < n; v++){
+        std::pair<address, address> newEdges = etForest.insertETEdge(v, v + 1, previous, ETForestCutSet::noHandle);
+        handles.push_back(newEdges.first);
+        handles.push_back(newEdges.second);
+        previous = newEdges.second;
+    }
+
+    address root = etForest.getRoot(handles[0]);
+    count logNodes = std::bit_width(handles.size());
+    count walked = 0;
+    for(count i = 0; i < n; i++){
+        address e = handles[dis(rng) % handles.size()];
+        walked += etForest.depth(e);
+        //Lookups never move the root, so it still identifies the tree
+        EXPECT_EQ(etForest.getRoot(e), root);
+        //A long walk leaves e right below the root
+        EXPECT_LE(etForest.depth(e), 2 * logNodes);
+    }
+    //Splaying amortizes the walks, including the spines the links left behind
+    EXPECT_LE(walked, 4 * (n + handles.size()) * logNodes);
+
+    //Reading the tour must not recurse along the spines
+    std::vector<std::pair<node, node>> tour = etForest.getTour(root);
+    ASSERT_EQ(tour.size(), handles.size());
+    for(count i = 0; i + 1 < tour.size(); i++) EXPECT_EQ(tour[i].second, tour[i + 1].first);
+}
+
+TEST(ETForestCutSet, buildForestMatchesTour){
+    count n = 300;
+    count lognsqr = std::ceil(2.0 * std::log2(n)) + 1;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    //A random forest, most vertices hang off a smaller one
+    RootedForest rootedForest(n);
+    std::vector<edge> forestEdges;
+    for(node v = 1; v < n; v++){
+        if(dis(rng) % 10 == 0) continue;
+        node u = dis(rng) % v;
+        rootedForest.link(v, u, 0);
+        forestEdges.push_back({v, u});
+    }
+
+    std::vector<std::vector<sketchWord>> vertexSketches(n);
+    std::vector<sketchWord*> ownData(n);
+    std::vector<uint8_t> ownFirstSlots(n, 0);
+    for(node v = 0; v < n; v++){
+        vertexSketches[v].assign(2 * lognsqr, toSketchWord({v, dis(rng)}));
+        ownData[v] = vertexSketches[v].data();
+    }
+
+    ETForestCutSet etForest(1, n);
+    std::vector<std::pair<address, address>> newEdges = etForest.buildForest(forestEdges, ownData, ownFirstSlots);
+    ASSERT_EQ(newEdges.size(), forestEdges.size());
+
+    for(count k = 0; k < forestEdges.size(); k++){
+        auto [v, w] = forestEdges[k];
+        EXPECT_EQ(etForest.getV(newEdges[k].first), v);
+        EXPECT_EQ(etForest.getW(newEdges[k].first), w);
+        EXPECT_EQ(etForest.getV(newEdges[k].second), w);
+        EXPECT_EQ(etForest.getW(newEdges[k].second), v);
+        EXPECT_EQ(etForest.getRoot(newEdges[k].first), etForest.getRoot(newEdges[k].second));
+    }
+
+    //Every tree is a closed tour over its component whose aggregate holds the sketch of every vertex once
+    std::map<node, std::vector<sketchWord>> expected;
+    std::vector<bool> seen(n, false);
+    for(edge e : forestEdges){
+        for(node v : {e.v, e.w}){
+            if(seen[v]) continue;
+            seen[v] = true;
+            std::vector<sketchWord> &sketch = expected[rootedForest.getRoot(v)];
+            if(sketch.empty()) sketch.assign(2 * lognsqr, noSketchWord);
+            for(count j = 0; j < 2 * lognsqr; j++) sketch[j] ^= vertexSketches[v][j];
+        }
+    }
+
+    std::set<address> roots;
+    for(count k = 0; k < forestEdges.size(); k++){
+        address root = etForest.getRoot(newEdges[k].first);
+        if(not roots.insert(root).second) continue;
+
+        std::vector<std::pair<node, node>> tour = etForest.getTour(root);
+        EXPECT_EQ(tour[0].first, tour.back().second);
+        for(count i = 0; i + 1 < tour.size(); i++) EXPECT_EQ(tour[i].second, tour[i + 1].first);
+
+        SketchView accumulated = etForest.getAccumulatedSketch(root);
+        const std::vector<sketchWord> &sketch = expected[rootedForest.getRoot(forestEdges[k].v)];
+        for(count j = 0; j < 2 * lognsqr; j++) EXPECT_EQ(accumulated(j / lognsqr, j % lognsqr), sketch[j]);
+    }
+    EXPECT_EQ(roots.size(), expected.size());
+
+    //The built trees take cuts like any other
+    std::vector<bool> cut(forestEdges.size(), false);
+    for(count k = 0; k < forestEdges.size(); k += 3){
+        etForest.deleteETEdge(newEdges[k].first, newEdges[k].second);
+        rootedForest.cutEdge(forestEdges[k].v, forestEdges[k].w);
+        cut[k] = true;
+    }
+    for(count i = 0; i < 1000; i++){
+        count k = dis(rng) % forestEdges.size(), l = dis(rng) % forestEdges.size();
+        if(cut[k] || cut[l]) continue;
+        EXPECT_EQ(rootedForest.getRoot(forestEdges[k].v) == rootedForest.getRoot(forestEdges[l].v),
+                  etForest.getRoot(newEdges[k].first) == etForest.getRoot(newEdges[l].first));
+    }
+}
+
+TEST(ETForestCutSet, tooManyNodesForHandles){
+    //2 * (n - 1) nodes would not be addressable by 32 bit handles, this must fail in release builds as well
+    EXPECT_THROW(ETForestCutSet(1, (count(1) << 31) + 1), std::length_error);
+    EXPECT_NO_THROW(ETForestCutSet(1, count(1) << 31));
+}
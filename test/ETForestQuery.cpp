@@ -0,0 +1,127 @@
+#include "gtest/gtest.h"
+
+#include <map>
+#include <random>
+#include <stdexcept>
+
+#include "ETForestQuery.hpp"
+//To check connected components
+#include "PrimitiveStructures/RootedTree.hpp"
+
+//Checks that every tree of the forest is a closed Euler tour whose size matches the tour
+void checkTours(const ETForestQuery &etForest, const std::map<std::pair<node, node>, addressQuery> &edges){
+    for(auto [e, handle] : edges){
+        addressQuery root = etForest.getRoot(handle);
+        if(root != handle) continue;
+
+        std::vector<std::pair<node, node>> tour = etForest.getTour(root);
+        EXPECT_EQ(tour.size(), etForest.getSize(root));
+        EXPECT_EQ(tour[0].first, tour.back().second);
+        for(count i = 0; i + 1 < tour.size(); i++) EXPECT_EQ(tour[i].second, tour[i + 1].first);
+    }
+}
+
+TEST(ETForestQuery, fullyDynamic){
+    count n = 100;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    ETForestQuery etForest(n);
+    RootedForest rootedForest(n);
+
+    //Both directions of every tree edge with their nodes
+    std::map<std::pair<node, node>, addressQuery> edges;
+    std::vector<std::pair<node, node>> treeEdges;
+
+    auto anyEdge = [&](node v){
+        auto it = edges.lower_bound({v, 0});
+        return (it != edges.end() && it->first.first == v) ? it->second : ETForestQuery::noHandle;
+    };
+
+    for(count i = 0; i < 10 * n; i++){
+        if(treeEdges.size() < n / 2 || (treeEdges.size() < n - 1 && dis(rng) % 2 == 0)){
+            node v = dis(rng), w;
+            do w = dis(rng); while (rootedForest.getRoot(v) == rootedForest.getRoot(w));
+            rootedForest.link(v, w, 0);
+
+            std::pair<addressQuery, addressQuery> newEdges = etForest.insertETEdge(v, w, anyEdge(v), anyEdge(w));
+            edges[{v, w}] = newEdges.first;
+            edges[{w, v}] = newEdges.second;
+            treeEdges.emplace_back(v, w);
+        } else {
+            count index = dis(rng) % treeEdges.size();
+            auto [v, w] = treeEdges[index];
+            rootedForest.cutEdge(v, w);
+
+            etForest.deleteETEdge(edges[{v, w}], edges[{w, v}]);
+            edges.erase({v, w});
+            edges.erase({w, v});
+            treeEdges[index] = treeEdges.back();
+            treeEdges.pop_back();
+        }
+
+        checkTours(etForest, edges);
+
+        //Vertices are connected iff their edges are in the same tree
+        for(count j = 0; j < 10; j++){
+            node u = dis(rng), v = dis(rng);
+            addressQuery uEdge = anyEdge(u), vEdge = anyEdge(v);
+            if(uEdge == ETForestQuery::noHandle || vEdge == ETForestQuery::noHandle) continue;
+            EXPECT_EQ(rootedForest.getRoot(u) == rootedForest.getRoot(v), etForest.getRoot(uEdge) == etForest.getRoot(vEdge));
+        }
+    }
+
+    //Deleted nodes are reused, so the forest never holds more than the 2 * (n - 1) nodes of a spanning tree
+    EXPECT_LE(etForest.getNumBytes(), ETForestQuery::projectNumBytes(2 * (n - 1)));
+}
+
+TEST(ETForestQuery, buildForest){
+    count n = 1000;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    //A random forest, most vertices hang off a smaller one
+    RootedForest rootedForest(n);
+    std::vector<edge> forestEdges;
+    for(node v = 1; v < n; v++){
+        if(dis(rng) % 20 == 0) continue;
+        node u = dis(rng) % v;
+        rootedForest.link(v, u, 0);
+        forestEdges.push_back({v, u});
+    }
+
+    ETForestQuery etForest(n);
+    std::vector<std::pair<addressQuery, addressQuery>> newEdges = etForest.buildForest(forestEdges);
+
+    std::map<std::pair<node, node>, addressQuery> edges;
+    for(count k = 0; k < forestEdges.size(); k++){
+        auto [v, w] = forestEdges[k];
+        EXPECT_EQ(etForest.getV(newEdges[k].first), v);
+        EXPECT_EQ(etForest.getW(newEdges[k].first), w);
+        EXPECT_EQ(etForest.getV(newEdges[k].second), w);
+        edges[{v, w}] = newEdges[k].first;
+        edges[{w, v}] = newEdges[k].second;
+    }
+    checkTours(etForest, edges);
+
+    for(count i = 0; i < 1000; i++){
+        count k = dis(rng) % forestEdges.size(), l = dis(rng) % forestEdges.size();
+        EXPECT_EQ(rootedForest.getRoot(forestEdges[k].v) == rootedForest.getRoot(forestEdges[l].v),
+                  etForest.getRoot(newEdges[k].first) == etForest.getRoot(newEdges[l].first));
+    }
+
+    //The built trees take cuts like any other
+    for(count k = 0; k < forestEdges.size(); k += 3){
+        etForest.deleteETEdge(newEdges[k].first, newEdges[k].second);
+        edges.erase({forestEdges[k].v, forestEdges[k].w});
+        edges.erase({forestEdges[k].w, forestEdges[k].v});
+    }
+    checkTours(etForest, edges);
+}
+
+TEST(ETForestQuery, tooManyNodesForHandles){
+    //2 * (n - 1) nodes would not be addressable by 32 bit handles, this must fail in release builds as well
+    EXPECT_THROW(ETForestQuery((count(1) << 31) + 1), std::length_error);
+    EXPECT_NO_THROW(ETForestQuery(count(1) << 31));
+}
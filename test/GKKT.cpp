@@ -1,5 +1,9 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <random>
+#include <set>
+
 #include "base.hpp"
 #include "DTree.hpp"
 #include "GKKT.hpp"
@@ -217,6 +221,112 @@ TEST(GKKT, largeInsertDeleteTest) {
     std::cout << "Number errors: " << errors << "\n";
 }
 
+TEST(GKKT, splayMatchesAVL) {
+    count n = 100;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    //Sketches only depend on the edge sets, so both forests find the same replacement edges
+    GKKT avl(n, 1, 42, 1, GKKT::Mode::lvlHeu);
+    GKKT splay(n, 1, 42, 1, GKKT::Mode::lvlHeu, 1, ETBalancing::splay);
+
+    std::set<std::pair<node, node>> edges;
+    for(count i = 0; i < 20 * n; i++){
+        node u = dis(rng), v = dis(rng);
+        if(u == v) continue;
+        if(u > v) std::swap(u, v);
+
+        if(edges.erase({u, v})){
+            avl.deleteEdge(u, v);
+            splay.deleteEdge(u, v);
+        } else {
+            edges.insert({u, v});
+            avl.addEdge(u, v);
+            splay.addEdge(u, v);
+        }
+
+        EXPECT_EQ(avl.numberOfComponents(), splay.numberOfComponents());
+        for(count j = 0; j < 10; j++){
+            node x = dis(rng), y = dis(rng);
+            EXPECT_EQ(avl.query(x, y), splay.query(x, y));
+        }
+    }
+}
+
+TEST(GKKT, queryForestsMatch) {
+    count n = 100;
+
+    std::mt19937 rng(43);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    //The query forest only answers queries, both kinds see the same tree edges
+    GKKT btree(n, 1, 42, 1, GKKT::Mode::lvlHeu);
+    GKKT avl(n, 1, 42, 1, GKKT::Mode::lvlHeu, 1, ETBalancing::avl, QueryForestType::avl);
+
+    std::set<std::pair<node, node>> edges;
+    for(count i = 0; i < 20 * n; i++){
+        node u = dis(rng), v = dis(rng);
+        if(u == v) continue;
+        if(u > v) std::swap(u, v);
+
+        if(edges.erase({u, v})){
+            btree.deleteEdge(u, v);
+            avl.deleteEdge(u, v);
+        } else {
+            edges.insert({u, v});
+            btree.addEdge(u, v);
+            avl.addEdge(u, v);
+        }
+
+        EXPECT_EQ(btree.numberOfComponents(), avl.numberOfComponents());
+        for(count j = 0; j < 10; j++){
+            node x = dis(rng), y = dis(rng);
+            EXPECT_EQ(btree.query(x, y), avl.query(x, y));
+        }
+    }
+
+    //The projection covers the forest in use
+    MemoryUsage projected = GKKT::projectMemoryUsage(n, 1, 1, GKKT::lvlHeu, edges.size(), QueryForestType::avl);
+    EXPECT_GE(projected.etNodes, avl.memoryUsage().etNodes);
+}
+
+TEST(GKKT, graphConstructorMatchesDTree) {
+    count n = 200;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    Graph graph(n);
+    DTree expected(n);
+    std::vector<edge> edgeList;
+    for(count i = 0; i < 2 * n; i++){
+        node u = dis(rng), v = dis(rng);
+        if(u == v || graph.hasEdge(u, v)) continue;
+        graph.addEdge(u, v);
+        expected.addEdge(u, v);
+        edgeList.push_back({u, v});
+    }
+
+    //All edges are added at once
+    GKKT actual(graph, 1, 42, 1);
+    EXPECT_EQ(expected.numberOfComponents(), actual.numberOfComponents());
+    for(node u = 0; u < n; u++) EXPECT_EQ(expected.query(0, u), actual.query(0, u));
+
+    //The structures built at once have to find replacement edges like the ones built edge by edge
+    std::shuffle(edgeList.begin(), edgeList.end(), rng);
+    for(edge e : edgeList){
+        actual.deleteEdge(e.v, e.w);
+        expected.deleteEdge(e.v, e.w);
+
+        EXPECT_EQ(expected.numberOfComponents(), actual.numberOfComponents());
+        for(count j = 0; j < 10; j++){
+            node u = dis(rng), v = dis(rng);
+            EXPECT_EQ(expected.query(u, v), actual.query(u, v));
+        }
+    }
+}
+
 TEST(GKKT, profileTest) {
     count n = 10;
 
@@ -256,4 +366,60 @@ TEST(GKKT, profileTest) {
     for(edge e : edgeList){
         actual.deleteEdge(e.v, e.w);
     }
-}
\ No newline at end of file
+}
+TEST(GKKT, memoryUsage) {
+    count n = 200;
+    float c = 1;
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    GKKT algo(n, c, 42, 2);
+    MemoryUsage empty = algo.memoryUsage();
+    EXPECT_EQ(empty.etNodes, 0);
+
+    //A path keeps the graph connected, the rest are random extra edges
+    std::set<std::pair<node, node>> edges;
+    for(node v = 0; v + 1 < n; v++) edges.insert({v, v + 1});
+    while(edges.size() < 3 * n){
+        node u = dis(rng), v = dis(rng);
+        if(u < v) edges.insert({u, v});
+    }
+    for(std::pair<node, node> e : edges) algo.addEdge(e.first, e.second);
+
+    MemoryUsage used = algo.memoryUsage();
+    EXPECT_GT(used.sketches, empty.sketches);
+    EXPECT_GT(used.etNodes, 0);
+    EXPECT_GT(used.avlNodes, empty.avlNodes);
+    EXPECT_GT(used.linkCutTrees, 0);
+
+    //The projection assumes every level is spanned by a tree, which bounds the parts that don't depend on the edges
+    MemoryUsage projected = GKKT::projectMemoryUsage(n, c, 2, GKKT::base, edges.size());
+    EXPECT_GE(projected.sketches, used.sketches);
+    EXPECT_GE(projected.etNodes, used.etNodes);
+    EXPECT_GE(projected.linkCutTrees, used.linkCutTrees);
+}
+
+TEST(GKKT, configureForMemory) {
+    count n = 1000;
+    count budget = GKKT::projectMemoryUsage(n, 1, 2, GKKT::lvlHeu).total();
+
+    //The budget of a configuration fits that configuration itself
+    std::optional<GKKT::Configuration> config = GKKT::configureForMemory(n, budget, GKKT::lvlHeu, 1, 2);
+    ASSERT_TRUE(config.has_value());
+    EXPECT_EQ(config->c, 1);
+    EXPECT_EQ(config->boostLevel, 2);
+    EXPECT_LE(config->projectedMemory.total(), budget);
+
+    //With less memory precision has to give way
+    config = GKKT::configureForMemory(n, budget / 2, GKKT::lvlHeu, 1, 2);
+    ASSERT_TRUE(config.has_value());
+    EXPECT_LT(config->c, 1);
+    EXPECT_LE(config->projectedMemory.total(), budget / 2);
+
+    EXPECT_FALSE(GKKT::configureForMemory(n, 1000, GKKT::lvlHeu, 1, 2).has_value());
+
+    GKKT algo(n, *config, 42, GKKT::lvlHeu);
+    algo.addEdge(0, 1);
+    EXPECT_TRUE(algo.query(0, 1));
+}
@@ -1,5 +1,8 @@
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <random>
+
 #include "base.hpp"
 #include "DTree.hpp"
 #include "Kaibel.hpp"
@@ -217,6 +220,42 @@ TEST(Kaibel, largeInsertDeleteTest) {
     std::cout << "Number errors: " << errors << "\n";
 }
 
+TEST(Kaibel, graphConstructorMatchesDTree) {
+    count n = 200;
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<node> dis(0, n - 1);
+
+    Graph graph(n);
+    DTree expected(n);
+    std::vector<edge> edgeList;
+    for(count i = 0; i < 2 * n; i++){
+        node u = dis(rng), v = dis(rng);
+        if(u == v || graph.hasEdge(u, v)) continue;
+        graph.addEdge(u, v);
+        expected.addEdge(u, v);
+        edgeList.push_back({u, v});
+    }
+
+    //All edges are added at once
+    Kaibel actual(graph, 1, 42, 1);
+    EXPECT_EQ(expected.numberOfComponents(), actual.numberOfComponents());
+    for(node u = 0; u < n; u++) EXPECT_EQ(expected.query(0, u), actual.query(0, u));
+
+    //The structures built at once have to find replacement edges like the ones built edge by edge
+    std::shuffle(edgeList.begin(), edgeList.end(), rng);
+    for(edge e : edgeList){
+        actual.deleteEdge(e.v, e.w);
+        expected.deleteEdge(e.v, e.w);
+
+        EXPECT_EQ(expected.numberOfComponents(), actual.numberOfComponents());
+        for(count j = 0; j < 10; j++){
+            node u = dis(rng), v = dis(rng);
+            EXPECT_EQ(expected.query(u, v), actual.query(u, v));
+        }
+    }
+}
+
 TEST(Kaibel, profileTest) {
     count n = 10;
 
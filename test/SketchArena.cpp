@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "SketchArena.hpp"
+
+TEST(SketchArena, alignedAndZeroed){
+    count boostLevel = 3, lognsqr = 21;
+
+    SketchArena arena(50, boostLevel, lognsqr);
+
+    EXPECT_GE(arena.getStride(), boostLevel * lognsqr);
+    EXPECT_EQ(arena.getStride() * sizeof(sketchWord) % cacheLineSize, 0);
+    EXPECT_EQ(arena.getNumBytes(), 50 * arena.getStride() * sizeof(sketchWord));
+
+    for(count i = 0; i < 50; i++){
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.getSketch(i)) % cacheLineSize, 0);
+        for(count j = 0; j < boostLevel * lognsqr; j++) EXPECT_EQ(arena.getSketch(i)[j], noSketchWord);
+    }
+}
+
+TEST(SketchArena, sketchesAreDisjoint){
+    count boostLevel = 2, lognsqr = 5;
+
+    SketchArena arena(10, boostLevel, lognsqr);
+
+    for(count i = 0; i < 10; i++){
+        for(count j = 0; j < boostLevel * lognsqr; j++) arena.getSketch(i)[j] = toSketchWord({i, j});
+    }
+
+    for(count i = 0; i < 10; i++){
+        for(count j = 0; j < boostLevel * lognsqr; j++) EXPECT_EQ(arena.getSketch(i)[j], toSketchWord({i, j}));
+    }
+
+    SketchArena moved(std::move(arena));
+    EXPECT_EQ(moved.getSketch(3)[4], toSketchWord({3, 4}));
+}
+
+TEST(SketchPool, stableAddresses){
+    count boostLevel = 2, lognsqr = 9;
+
+    SketchPool pool(boostLevel, lognsqr);
+    EXPECT_EQ(pool.getNumBytes(), 0);
+
+    std::vector<sketchWord*> sketches;
+    for(count i = 0; i < 200; i++){
+        sketchWord *sketch = pool.allocate();
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(sketch) % cacheLineSize, 0);
+        for(count j = 0; j < boostLevel * lognsqr; j++){
+            EXPECT_EQ(sketch[j], noSketchWord);
+            sketch[j] = toSketchWord({i, j});
+        }
+        sketches.push_back(sketch);
+    }
+
+    //Later allocations must not move or overwrite earlier sketches
+    for(count i = 0; i < 200; i++){
+        for(count j = 0; j < boostLevel * lognsqr; j++) EXPECT_EQ(sketches[i][j], toSketchWord({i, j}));
+    }
+    EXPECT_GE(pool.getNumBytes(), 200 * boostLevel * lognsqr * sizeof(sketchWord));
+}
+
+TEST(SketchArena, largeArenasAreZeroed){
+    count boostLevel = 4, lognsqr = 41;
+    //Big enough to be mapped from the OS directly
+    count numSketches = zeroPageThreshold / (boostLevel * lognsqr * sizeof(sketchWord)) + 1;
+
+    SketchArena arena(numSketches, boostLevel, lognsqr);
+    EXPECT_GE(arena.getNumBytes(), zeroPageThreshold);
+
+    for(count i = 0; i < numSketches; i += 97){
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(arena.getSketch(i)) % cacheLineSize, 0);
+        for(count j = 0; j < boostLevel * lognsqr; j++) EXPECT_EQ(arena.getSketch(i)[j], noSketchWord);
+    }
+    arena.getSketch(numSketches - 1)[0] = toSketchWord({1, 2});
+    EXPECT_EQ(arena.getSketch(numSketches - 1)[0], toSketchWord({1, 2}));
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "SketchKernels.hpp"
+
+constexpr count maxLength = 70;
+
+sketchWord randomWord(std::mt19937_64 &rng){
+    return toSketchWord({rng(), rng()});
+}
+
+std::vector<sketchWord> randomSketch(std::mt19937_64 &rng, count length){
+    std::vector<sketchWord> ret(length);
+    for(sketchWord &e : ret) e = randomWord(rng);
+    return ret;
+}
+
+class SketchKernelsTest : public ::testing::TestWithParam<SketchISA> {
+protected:
+    void SetUp() override {
+        previous = getSketchISA();
+        if(not setSketchISA(GetParam())) GTEST_SKIP() << "Instruction set not supported on this machine";
+    }
+
+    void TearDown() override {
+        setSketchISA(previous);
+    }
+
+    SketchISA previous = SketchISA::scalar;
+};
+
+TEST_P(SketchKernelsTest, xorEdgeIntoRange){
+    std::mt19937_64 rng(42);
+
+    for(count offset = 0; offset < 3; offset++){
+        for(count length = 0; length < maxLength; length++){
+            std::vector<sketchWord> data = randomSketch(rng, offset + length + 1);
+            std::vector<sketchWord> expected = data;
+            sketchWord e = randomWord(rng);
+
+            for(count i = offset; i < offset + length; i++) expected[i] ^= e;
+            xorEdgeIntoRange(data.data() + offset, e, length);
+
+            EXPECT_EQ(data, expected);
+        }
+    }
+}
+
+TEST_P(SketchKernelsTest, xorSketchInto){
+    std::mt19937_64 rng(42);
+
+    for(count length = 0; length < maxLength; length++){
+        std::vector<sketchWord> dst = randomSketch(rng, length), src = randomSketch(rng, length);
+        std::vector<sketchWord> expected = dst;
+
+        for(count i = 0; i < length; i++) expected[i] ^= src[i];
+        xorSketchInto(dst.data(), src.data(), length);
+
+        EXPECT_EQ(dst, expected);
+    }
+}
+
+TEST_P(SketchKernelsTest, combineSketches){
+    std::mt19937_64 rng(42);
+
+    for(count length = 1; length < maxLength; length++){
+        std::vector<sketchWord> own = randomSketch(rng, length), left = randomSketch(rng, length), right = randomSketch(rng, length);
+
+        //Try every combination of present and missing sketches
+        for(count mask = 0; mask < 8; mask++){
+            std::vector<sketchWord> dst = randomSketch(rng, length), expected(length, noSketchWord);
+            const sketchWord *ownPtr = (mask & 1) ? own.data() : nullptr;
+            const sketchWord *leftPtr = (mask & 2) ? left.data() : nullptr;
+            const sketchWord *rightPtr = (mask & 4) ? right.data() : nullptr;
+
+            for(count i = 0; i < length; i++){
+                if(ownPtr != nullptr) expected[i] ^= own[i];
+                if(leftPtr != nullptr) expected[i] ^= left[i];
+                if(rightPtr != nullptr) expected[i] ^= right[i];
+            }
+            combineSketches(dst.data(), ownPtr, leftPtr, rightPtr, length);
+
+            EXPECT_EQ(dst, expected);
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(SketchKernels, SketchKernelsTest, ::testing::Values(SketchISA::scalar, SketchISA::sse2, SketchISA::avx2));
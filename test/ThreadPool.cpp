@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <new>
+#include <stdexcept>
+
+#include "ThreadPool.hpp"
+
+TEST(ThreadPool, everyIndexOnce){
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.getNumThreads(), 4);
+
+    std::vector<std::atomic<count>> hits(1000);
+
+    for(count round = 0; round < 50; round++){
+        pool.parallelFor(round, 1000, 7, [&](count i){ hits[i]++; });
+    }
+
+    for(count i = 0; i < 1000; i++) EXPECT_EQ(hits[i], std::min<count>(i + 1, 50));
+}
+
+TEST(ThreadPool, smallRangesStaySerial){
+    ThreadPool pool(8);
+
+    std::thread::id caller = std::this_thread::get_id();
+    bool onCaller = true;
+
+    pool.parallelFor(0, 15, 8, [&](count){ if(std::this_thread::get_id() != caller) onCaller = false; });
+    EXPECT_TRUE(onCaller);
+
+    //Empty ranges do nothing
+    pool.parallelFor(5, 5, 1, [&](count){ onCaller = false; });
+    EXPECT_TRUE(onCaller);
+
+    ThreadPool single(0);
+    EXPECT_EQ(single.getNumThreads(), 1);
+    count sum = 0;
+    single.parallelFor(0, 100, 1, [&](count i){ sum += i; });
+    EXPECT_EQ(sum, 4950);
+}
+
+TEST(ThreadPool, exceptionsReachTheCaller){
+    ThreadPool pool(4);
+
+    //Thrown on a worker, the chunk of the caller is the first one
+    EXPECT_THROW(pool.parallelFor(0, 400, 1, [](count i){ if(i == 399) throw std::bad_alloc(); }), std::bad_alloc);
+    EXPECT_THROW(pool.parallelFor(0, 400, 1, [](count i){ if(i == 0) throw std::runtime_error("caller"); }), std::runtime_error);
+
+    //The pool stays usable afterwards
+    std::vector<std::atomic<count>> hits(400);
+    pool.parallelFor(0, 400, 1, [&](count i){ hits[i]++; });
+    for(count i = 0; i < 400; i++) EXPECT_EQ(hits[i], 1);
+}